@@ -1,7 +1,17 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "bitset.h"
 #include "structs.h"
 #include "queue.h"
+#include "checkpoint.h"
+#include "bfs.h"
+
+// Odstęp między punktami kontrolnymi jest co najmniej tyle razy dłuższy
+// od czasu zapisu ostatniego z nich, co ogranicza ich narzut do ok. 5%.
+#define CHECKPOINT_OVERHEAD_FACTOR 20
 
 // Funkcja zwraca zakodowaną pozycję w labiryncie.
 // table - tablica opisująca kodowaną pozycję.
@@ -33,67 +43,147 @@ static void decodePosition(size_t *table, Labyrinth *labyrinth, size_t number) {
    }
 }
 
-void bfs(Labyrinth *labyrinth) {
-   Queue *q = createQueue();
-   if (q == NULL)
+// Funkcja odwiedza sąsiada o podanej pozycji.
+// Zwraca "true", jeżeli sąsiad jest pozycją końcową.
+static bool visit(Labyrinth *labyrinth, Bitset *walls, Queue *q, 
+                  size_t *currentPosition, size_t end) {
+   size_t position = codePosition(currentPosition, labyrinth);
+   if (position == end)
+      return true;
+   if (!bitsetCheck(walls, position)) {
+      if (!push(q, position)) {
+         clearQueue(q);
+         freeLabyrinthAndExitWithError(labyrinth, 0);
+      }
+      bitsetSet(walls, position);
+   }
+   return false;
+}
+
+// Funkcja przywraca stan przeszukiwania z punktu kontrolnego, jeżeli taki istnieje.
+// Zwraca "true", jeżeli stan został przywrócony.
+static bool resume(Labyrinth *labyrinth, Queue *q, BfsOptions const *options, 
+                   uint64_t wallHash, size_t *distance) {
+   if (options->checkpointPath == NULL)
+      return false;
+
+   int result = loadCheckpoint(options->checkpointPath, labyrinth, q, distance, wallHash);
+   if (result == -1) {
+      clearQueue(q);
       freeLabyrinthAndExitWithError(labyrinth, 0);
+   }
+   return (result == 1);
+}
 
+// Funkcja przegląda kolejne poziomy przeszukiwania.
+// Zwraca "true", jeżeli pozycja końcowa jest osiągalna, jej dystans zapisuje w "distance".
+static bool search(Labyrinth *labyrinth, Queue *q, BfsOptions const *options, 
+                   size_t *distance, size_t *checkpoints) {
    size_t numberOfDimensions = getNumberOfDimensions(labyrinth);
    size_t currentPosition[numberOfDimensions];
    size_t *dimensions = getDimensions(labyrinth);
-   size_t distance = 0;
    size_t position = getStartingPosition(labyrinth);
    size_t end = getEndingPosition(labyrinth);
+   Bitset *walls = getWalls(labyrinth);
 
-   if (position == end) {
-      printf("0\n");
-      clearQueue(q);
-      return;
+   *distance = 0;
+   if (position == end)
+      return true;
+
+   uint64_t wallHash = 0;
+   if (options->checkpointPath != NULL)
+      wallHash = hashWalls(labyrinth);
+
+   if (!resume(labyrinth, q, options, wallHash, distance)) {
+      if (!push(q, position)) {
+         clearQueue(q);
+         freeLabyrinthAndExitWithError(labyrinth, 0);
+      }
+      bitsetSet(walls, position);
    }
-   
-   if (!push(q, position, distance))
-      freeLabyrinthAndExitWithError(labyrinth, 0);
 
-   while (!isEmpty(q)) {
-      position = getFirstPosition(q);
-      distance = getFirstDistance(q);
-      pop(q);
-      decodePosition(currentPosition, labyrinth, position);
-   
-      for (size_t i = 0; i < numberOfDimensions; i++) {
-         if (currentPosition[i] > 1) {
-            currentPosition[i]--;
-            position = codePosition(currentPosition, labyrinth);
-            if (position == end) {
-               printf("%zu\n", distance + 1);
-               clearQueue(q);
-               return;
-            }
-            if (!checkWall(labyrinth, position)) {
-               if (!push(q, position, distance + 1))
-                  freeLabyrinthAndExitWithError(labyrinth, 0);
-               setWall(labyrinth, position);
-            }
-            currentPosition[i]++;
-         }
-         if (currentPosition[i] < dimensions[i]) {
-            currentPosition[i]++;
-            position = codePosition(currentPosition, labyrinth);
-            if (position == end) {
-               printf("%zu\n", distance + 1);
-               clearQueue(q);
-               return;
+   time_t nextCheckpoint = time(NULL) + (time_t)options->checkpointInterval;
+
+   // Wszystkie wierzchołki bieżącego poziomu mają dystans "*distance",
+   // a ich sąsiedzi, dodawani do następnego poziomu, dystans o 1 większy.
+   while (nextLevel(q)) {
+      if (options->checkpointPath != NULL && time(NULL) >= nextCheckpoint) {
+         time_t begin = time(NULL);
+         if (saveCheckpoint(options->checkpointPath, labyrinth, q, *distance, wallHash))
+            (*checkpoints)++;
+         time_t now = time(NULL);
+         time_t pause = (time_t)options->checkpointInterval;
+         if (pause < CHECKPOINT_OVERHEAD_FACTOR * (now - begin))
+            pause = CHECKPOINT_OVERHEAD_FACTOR * (now - begin);
+         nextCheckpoint = now + pause;
+      }
+
+      (*distance)++;
+      while (pop(q, &position)) {
+         decodePosition(currentPosition, labyrinth, position);
+
+         for (size_t i = 0; i < numberOfDimensions; i++) {
+            if (currentPosition[i] > 1) {
+               currentPosition[i]--;
+               if (visit(labyrinth, walls, q, currentPosition, end))
+                  return true;
+               currentPosition[i]++;
             }
-            if (!checkWall(labyrinth, position)) {
-               if (!push(q, position, distance + 1))
-                  freeLabyrinthAndExitWithError(labyrinth, 0);
-               setWall(labyrinth, position);
+            if (currentPosition[i] < dimensions[i]) {
+               currentPosition[i]++;
+               if (visit(labyrinth, walls, q, currentPosition, end))
+                  return true;
+               currentPosition[i]--;
             }
-            currentPosition[i]--;
          }
       }
    }
 
-   printf("NO WAY\n");
+   return false;
+}
+
+// Funkcja wypisuje pierwszą wolną pozycję, do której przeszukiwanie nie dotarło.
+// Po przeszukiwaniu ściany i odwiedzone pozycje tworzą zwykle długie ciągi
+// ustawionych bitów, więc pełne słowa są pomijane bez sprawdzania ich bitów.
+static void printUnreachable(Labyrinth *labyrinth) {
+   size_t position = bitsetFindNextClear(getWalls(labyrinth), 0);
+   if (position == getLabyrinthSize(labyrinth))
+      return;
+
+   size_t numberOfDimensions = getNumberOfDimensions(labyrinth);
+   size_t table[numberOfDimensions];
+   decodePosition(table, labyrinth, position);
+   fprintf(stderr, "First unreachable cell:");
+   for (size_t i = 0; i < numberOfDimensions; i++)
+      fprintf(stderr, " %zu", table[i]);
+   fprintf(stderr, "\n");
+}
+
+void bfs(Labyrinth *labyrinth, BfsOptions const *options) {
+   Queue *q = createQueue(options->frontierLimit);
+   if (q == NULL)
+      freeLabyrinthAndExitWithError(labyrinth, 0);
+
+   size_t distance;
+   size_t checkpoints = 0;
+   size_t wallCount = (options->printStats ? bitsetCount(getWalls(labyrinth)) : 0);
+   bool found = search(labyrinth, q, options, &distance, &checkpoints);
+   if (found)
+      printf("%zu\n", distance);
+   else
+      printf("NO WAY\n");
+
+   // Przeszukiwanie zakończyło się, punkt kontrolny nie jest już potrzebny.
+   if (options->checkpointPath != NULL)
+      remove(options->checkpointPath);
+
+   if (options->printStats) {
+      fprintf(stderr, "Peak frontier memory: %zu B\n", getPeakMemory(q));
+      fprintf(stderr, "Visited cells: %zu\n", bitsetCount(getWalls(labyrinth)) - wallCount);
+      if (!found)
+         printUnreachable(labyrinth);
+      if (options->checkpointPath != NULL)
+         fprintf(stderr, "Checkpoints written: %zu\n", checkpoints);
+   }
    clearQueue(q);
 }
\ No newline at end of file
@@ -1,7 +1,15 @@
 #ifndef BFS_H
 #define BFS_H
 
+// Parametry przeszukiwania.
+typedef struct BfsOptions {
+   size_t frontierLimit; // Limit pamięci nieskompresowanego poziomu (0 - bez kompresji).
+   bool printStats;      // Czy wypisać statystyki na standardowe wyjście błędów.
+   char const *checkpointPath;  // Plik z punktem kontrolnym (NULL - bez punktów kontrolnych).
+   size_t checkpointInterval;   // Minimalny odstęp między punktami kontrolnymi w sekundach.
+} BfsOptions;
+
 // Funkcja szuka drogi w labiryncie i wypisuje wynik.
-void bfs(Labyrinth *labyrinth);
+void bfs(Labyrinth *labyrinth, BfsOptions const *options);
 
 #endif /* BFS_H */
\ No newline at end of file
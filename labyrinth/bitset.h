@@ -0,0 +1,118 @@
+#ifndef BITSET_H
+#define BITSET_H
+
+// Liczba bitów w jednym słowie bitsetu.
+#define BITSET_WORD_BITS 64
+
+// Zbiór bitów przechowywany w 64-bitowych słowach bez znaku.
+// Funkcje są zdefiniowane w nagłówku, żeby mogły być rozwijane w miejscu wywołania.
+typedef struct Bitset {
+   uint64_t *table;
+   size_t size;    // Liczba bitów.
+   size_t words;   // Liczba słów.
+} Bitset;
+
+// Funkcja sprawdza, czy bit na danej pozycji jest ustawiony.
+static inline bool bitsetCheck(Bitset const *bitset, size_t position) {
+   return ((bitset->table)[position / BITSET_WORD_BITS] >> (position % BITSET_WORD_BITS)) & 1;
+}
+
+// Funkcja ustawia bit na danej pozycji.
+static inline void bitsetSet(Bitset *bitset, size_t position) {
+   (bitset->table)[position / BITSET_WORD_BITS] |= (uint64_t)1 << (position % BITSET_WORD_BITS);
+}
+
+// Funkcja zwraca słowo o danym indeksie.
+static inline uint64_t bitsetGetWord(Bitset const *bitset, size_t index) {
+   return (bitset->table)[index];
+}
+
+// Funkcje wykonują operację logiczną na słowie o danym indeksie.
+static inline void bitsetOrWord(Bitset *bitset, size_t index, uint64_t word) {
+   (bitset->table)[index] |= word;
+}
+
+static inline void bitsetAndWord(Bitset *bitset, size_t index, uint64_t word) {
+   (bitset->table)[index] &= word;
+}
+
+static inline void bitsetAndNotWord(Bitset *bitset, size_t index, uint64_t word) {
+   (bitset->table)[index] &= ~word;
+}
+
+// Funkcja zwraca liczbę ustawionych bitów w słowie.
+static inline int bitsetPopcount(uint64_t word) {
+#ifdef __GNUC__
+   return __builtin_popcountll(word);
+#else
+   int result = 0;
+   while (word != 0) {
+      word &= word - 1;
+      result++;
+   }
+   return result;
+#endif
+}
+
+// Funkcja zwraca indeks najmłodszego ustawionego bitu niezerowego słowa.
+static inline int bitsetLowestBit(uint64_t word) {
+#ifdef __GNUC__
+   return __builtin_ctzll(word);
+#else
+   return bitsetPopcount((word & (~word + 1)) - 1);
+#endif
+}
+
+// Funkcja zwraca maskę bitów słowa o indeksach z przedziału [from, 64).
+static inline uint64_t bitsetMaskFrom(size_t from) {
+   return (from >= BITSET_WORD_BITS ? 0 : ~(uint64_t)0 << from);
+}
+
+// Funkcja ustawia bity na pozycjach z przedziału [begin, end).
+static inline void bitsetSetRange(Bitset *bitset, size_t begin, size_t end) {
+   if (begin >= end)
+      return;
+
+   size_t first = begin / BITSET_WORD_BITS;
+   size_t last = (end - 1) / BITSET_WORD_BITS;
+   uint64_t firstMask = bitsetMaskFrom(begin % BITSET_WORD_BITS);
+   uint64_t lastMask = ~bitsetMaskFrom((end - 1) % BITSET_WORD_BITS + 1);
+
+   if (first == last) {
+      (bitset->table)[first] |= firstMask & lastMask;
+      return;
+   }
+   (bitset->table)[first] |= firstMask;
+   for (size_t i = first + 1; i < last; i++)
+      (bitset->table)[i] = ~(uint64_t)0;
+   (bitset->table)[last] |= lastMask;
+}
+
+// Funkcja zwraca liczbę ustawionych bitów.
+static inline size_t bitsetCount(Bitset const *bitset) {
+   size_t result = 0;
+   for (size_t i = 0; i < bitset->words; i++)
+      result += (size_t)bitsetPopcount((bitset->table)[i]);
+   return result;
+}
+
+// Funkcja zwraca najmniejszą pozycję nie mniejszą niż "from", na której bit
+// nie jest ustawiony, lub rozmiar bitsetu, jeżeli takiej pozycji nie ma.
+static inline size_t bitsetFindNextClear(Bitset const *bitset, size_t from) {
+   if (from >= bitset->size)
+      return bitset->size;
+
+   size_t index = from / BITSET_WORD_BITS;
+   uint64_t word = ~(bitset->table)[index] & bitsetMaskFrom(from % BITSET_WORD_BITS);
+   while (word == 0) {
+      index++;
+      if (index == bitset->words)
+         return bitset->size;
+      word = ~(bitset->table)[index];
+   }
+
+   size_t position = index * BITSET_WORD_BITS + (size_t)bitsetLowestBit(word);
+   return (position < bitset->size ? position : bitset->size);
+}
+
+#endif /* BITSET_H */
\ No newline at end of file
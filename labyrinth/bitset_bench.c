@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "bitset.h"
+#include "structs.h"
+
+// Mikrobenchmark sprawdzania ścian: porównuje wywołanie "checkWall" przez
+// granicę jednostek kompilacji z rozwijaną w miejscu funkcją "bitsetCheck"
+// oraz szukanie wolnych pól bit po bicie z "bitsetFindNextClear".
+// Użycie: ./bitset_bench [log2_liczby_pól]
+
+#define DEFAULT_LOG_SIZE 27
+#define RUN_LENGTH 256
+
+// Funkcja zwraca bieżący czas w sekundach.
+static double currentTime() {
+   struct timespec ts;
+   timespec_get(&ts, TIME_UTC);
+   return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Funkcja zwraca kolejną liczbę pseudolosową (xorshift64).
+static uint64_t nextRandom(uint64_t *state) {
+   *state ^= *state << 13;
+   *state ^= *state >> 7;
+   *state ^= *state << 17;
+   return *state;
+}
+
+// Funkcja wypisuje przepustowość w milionach pól na sekundę.
+static void report(char const *name, size_t cells, double seconds, size_t result) {
+   printf("%-28s %8.1f M/s (result %zu)\n", name, (double)cells / seconds / 1e6, result);
+}
+
+int main(int argc, char *argv[]) {
+   size_t logSize = (argc > 1 ? strtoull(argv[1], NULL, 10) : DEFAULT_LOG_SIZE);
+   if (logSize < 10 || logSize > 34) {
+      fprintf(stderr, "Usage: %s [log2_cells (10-34)]\n", argv[0]);
+      return 1;
+   }
+   size_t size = (size_t)1 << logSize;
+
+   size_t *dimensions = malloc(sizeof(size_t));
+   if (dimensions == NULL)
+      return 1;
+   dimensions[0] = size;
+   Labyrinth *labyrinth = createLabyrinth(dimensions, 0, 0, 1, size);
+   if (labyrinth == NULL)
+      return 1;
+   Bitset *walls = getWalls(labyrinth);
+
+   // Co trzecie pole jest ścianą, a co ósmy odcinek jest w całości zajęty,
+   // żeby szukanie wolnych pól miało pełne słowa do pominięcia.
+   uint64_t state = 88172645463325252ULL;
+   for (size_t i = 0; i < size; i++)
+      if (nextRandom(&state) % 3 == 0)
+         bitsetSet(walls, i);
+   for (size_t i = 0; i < size; i += 8 * RUN_LENGTH)
+      bitsetSetRange(walls, i, i + RUN_LENGTH);
+
+   size_t *order = malloc(size * sizeof(size_t));
+   if (order == NULL) {
+      freeLabyrinth(labyrinth);
+      return 1;
+   }
+   for (size_t i = 0; i < size; i++)
+      order[i] = (size_t)(nextRandom(&state) % size);
+
+   double start = currentTime();
+   size_t result = 0;
+   for (size_t i = 0; i < size; i++)
+      result += checkWall(labyrinth, order[i]);
+   report("checkWall random", size, currentTime() - start, result);
+
+   start = currentTime();
+   result = 0;
+   for (size_t i = 0; i < size; i++)
+      result += bitsetCheck(walls, order[i]);
+   report("bitsetCheck random", size, currentTime() - start, result);
+
+   start = currentTime();
+   result = 0;
+   for (size_t i = 0; i < size; i++)
+      result += checkWall(labyrinth, i);
+   report("checkWall sequential", size, currentTime() - start, result);
+
+   start = currentTime();
+   result = 0;
+   for (size_t i = 0; i < size; i++)
+      result += bitsetCheck(walls, i);
+   report("bitsetCheck sequential", size, currentTime() - start, result);
+
+   start = currentTime();
+   result = 0;
+   for (size_t i = bitsetFindNextClear(walls, 0); i < size;
+        i = bitsetFindNextClear(walls, i + 1))
+      result++;
+   report("bitsetFindNextClear", size, currentTime() - start, result);
+
+   free(order);
+   freeLabyrinth(labyrinth);
+   return 0;
+}
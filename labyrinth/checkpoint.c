@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "structs.h"
+#include "queue.h"
+
+#define MAGIC "LABCKPT2"
+#define MAGIC_LENGTH 8
+
+// Rozmiar bufora pliku - zapis i odczyt odbywają się dużymi sekwencyjnymi blokami.
+#define BUFFER_SIZE (1 << 20)
+
+// Funkcja zapisuje nagłówek punktu kontrolnego.
+static bool writeHeader(FILE *file, Labyrinth *labyrinth, size_t distance, uint64_t wallHash) {
+   size_t numberOfDimensions = getNumberOfDimensions(labyrinth);
+   size_t startingPosition = getStartingPosition(labyrinth);
+   size_t endingPosition = getEndingPosition(labyrinth);
+
+   return (fwrite(MAGIC, 1, MAGIC_LENGTH, file) == MAGIC_LENGTH
+           && fwrite(&numberOfDimensions, sizeof(size_t), 1, file) == 1
+           && fwrite(getDimensions(labyrinth), sizeof(size_t), numberOfDimensions, file) 
+              == numberOfDimensions
+           && fwrite(&startingPosition, sizeof(size_t), 1, file) == 1
+           && fwrite(&endingPosition, sizeof(size_t), 1, file) == 1
+           && fwrite(&wallHash, sizeof(uint64_t), 1, file) == 1
+           && fwrite(&distance, sizeof(size_t), 1, file) == 1);
+}
+
+// Funkcja wczytuje nagłówek punktu kontrolnego i sprawdza, czy opisuje on
+// ten sam labirynt. Zwraca "true", jeżeli tak jest.
+static bool readHeader(FILE *file, Labyrinth *labyrinth, size_t *distance, uint64_t wallHash) {
+   char magic[MAGIC_LENGTH];
+   size_t numberOfDimensions;
+   if (fread(magic, 1, MAGIC_LENGTH, file) != MAGIC_LENGTH
+       || memcmp(magic, MAGIC, MAGIC_LENGTH) != 0
+       || fread(&numberOfDimensions, sizeof(size_t), 1, file) != 1
+       || numberOfDimensions != getNumberOfDimensions(labyrinth))
+      return false;
+
+   size_t *dimensions = getDimensions(labyrinth);
+   for (size_t i = 0; i < numberOfDimensions; i++) {
+      size_t dimension;
+      if (fread(&dimension, sizeof(size_t), 1, file) != 1 || dimension != dimensions[i])
+         return false;
+   }
+
+   size_t startingPosition, endingPosition;
+   uint64_t hash;
+   return (fread(&startingPosition, sizeof(size_t), 1, file) == 1
+           && startingPosition == getStartingPosition(labyrinth)
+           && fread(&endingPosition, sizeof(size_t), 1, file) == 1
+           && endingPosition == getEndingPosition(labyrinth)
+           && fread(&hash, sizeof(uint64_t), 1, file) == 1
+           && hash == wallHash
+           && fread(distance, sizeof(size_t), 1, file) == 1);
+}
+
+// Funkcja sprawdza, czy do końca pliku pozostało dokładnie "expected" bajtów.
+static bool remainingBytesEqual(FILE *file, long expected) {
+   long position = ftell(file);
+   if (position < 0 || fseek(file, 0, SEEK_END) != 0)
+      return false;
+   long end = ftell(file);
+   return (fseek(file, position, SEEK_SET) == 0 && end - position == expected);
+}
+
+bool saveCheckpoint(char const *path, Labyrinth *labyrinth, Queue *q, 
+                    size_t distance, uint64_t wallHash) {
+   size_t length = strlen(path);
+   char *temporaryPath = malloc(length + 5);
+   if (temporaryPath == NULL)
+      return false;
+   memcpy(temporaryPath, path, length);
+   memcpy(temporaryPath + length, ".tmp", 5);
+
+   FILE *file = fopen(temporaryPath, "wb");
+   if (file == NULL) {
+      free(temporaryPath);
+      return false;
+   }
+   setvbuf(file, NULL, _IOFBF, BUFFER_SIZE);
+
+   bool result = writeHeader(file, labyrinth, distance, wallHash)
+                 && writeLevel(q, file)
+                 && saveWalls(labyrinth, file);
+   if (fclose(file) != 0)
+      result = false;
+
+   if (result)
+      result = (rename(temporaryPath, path) == 0);
+   if (!result)
+      remove(temporaryPath);
+
+   free(temporaryPath);
+   return result;
+}
+
+int loadCheckpoint(char const *path, Labyrinth *labyrinth, Queue *q, 
+                   size_t *distance, uint64_t wallHash) {
+   FILE *file = fopen(path, "rb");
+   if (file == NULL)
+      return 0;
+   setvbuf(file, NULL, _IOFBF, BUFFER_SIZE);
+
+   // Numer poziomu jest przekazywany dopiero po wczytaniu całego pliku.
+   size_t level;
+   if (!readHeader(file, labyrinth, &level, wallHash)
+       || !readLevel(q, file, getLabyrinthSize(labyrinth))
+       || !remainingBytesEqual(file, (long)getWallsSize(labyrinth))) {
+      fclose(file);
+      return 0;
+   }
+
+   int result = (loadWalls(labyrinth, file) ? 1 : -1);
+   fclose(file);
+   if (result == 1)
+      *distance = level;
+   return result;
+}
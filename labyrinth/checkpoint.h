@@ -0,0 +1,26 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// Punkt kontrolny zawiera stan przeszukiwania na granicy poziomów: numer
+// poziomu, pozycje bieżącego poziomu i zbiór ścian razem z odwiedzonymi
+// pozycjami. Plik zawiera też opis labiryntu i skrót początkowego zbioru ścian,
+// dzięki czemu punkt kontrolny innego labiryntu nie zostanie wczytany.
+
+// Funkcja zapisuje punkt kontrolny do pliku "path".
+// Plik jest najpierw zapisywany pod nazwą tymczasową, a potem podmieniany,
+// więc przerwanie zapisu nie niszczy poprzedniego punktu kontrolnego.
+// Zwraca "true", jeżeli się to udało i "false" w przeciwnym razie.
+bool saveCheckpoint(char const *path, Labyrinth *labyrinth, Queue *q, 
+                    size_t distance, uint64_t wallHash);
+
+// Funkcja wczytuje punkt kontrolny z pliku "path", pozycje trafiają do
+// następnego poziomu kolejki, a numer poziomu do "distance" ("distance" jest
+// zmieniane tylko wtedy, gdy punkt kontrolny został wczytany). Zwraca:
+// 1, jeżeli punkt kontrolny został wczytany;
+// 0, jeżeli nie ma pasującego punktu kontrolnego (zbiór ścian, kolejka
+//    i "distance" nie zostały zmienione);
+// -1, jeżeli plik jest uszkodzony, a zbiór ścian mógł zostać zmieniony.
+int loadCheckpoint(char const *path, Labyrinth *labyrinth, Queue *q, 
+                   size_t *distance, uint64_t wallHash);
+
+#endif /* CHECKPOINT_H */
\ No newline at end of file
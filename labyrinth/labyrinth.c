@@ -1,17 +1,82 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
 #include "structs.h"
 #include "reading.h"
 #include "bfs.h"
 
-int main() {
+// Domyślny odstęp między punktami kontrolnymi w sekundach.
+#define DEFAULT_CHECKPOINT_INTERVAL 600
+
+// Maksymalna liczba wątków budujących ściany.
+#define MAX_THREADS 256
+
+// Funkcja wypisuje sposób użycia programu i kończy jego działanie.
+static void exitWithUsage(char const *name) {
+   fprintf(stderr, "Usage: %s [-s] [-t threads] [-m frontier_limit_bytes] "
+                   "[-c checkpoint_file [-i checkpoint_interval_seconds]]\n", name);
+   exit(1);
+}
+
+// Funkcja wczytuje nieujemną liczbę z argumentu programu.
+static size_t readNumberOption(char const *argument, char const *name) {
+   char *end;
+   errno = 0;
+   size_t number = strtoull(argument, &end, 10);
+   if (errno != 0 || *end != '\0' || argument[0] == '-' || argument[0] == '\0')
+      exitWithUsage(name);
+   return number;
+}
+
+// Funkcja wczytuje parametry przeszukiwania z argumentów programu.
+static void readOptions(int argc, char *argv[], BfsOptions *options, 
+                        size_t *numberOfThreads) {
+   *numberOfThreads = 1;
+   options->frontierLimit = 0;
+   options->printStats = false;
+   options->checkpointPath = NULL;
+   options->checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL;
+
+   for (int i = 1; i < argc; i++) {
+      if (strcmp(argv[i], "-s") == 0) {
+         options->printStats = true;
+      }
+      else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+         *numberOfThreads = readNumberOption(argv[++i], argv[0]);
+         if (*numberOfThreads == 0 || *numberOfThreads > MAX_THREADS)
+            exitWithUsage(argv[0]);
+      }
+      else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+         options->frontierLimit = readNumberOption(argv[++i], argv[0]);
+      }
+      else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+         options->checkpointPath = argv[++i];
+      }
+      else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+         options->checkpointInterval = readNumberOption(argv[++i], argv[0]);
+      }
+      else {
+         exitWithUsage(argv[0]);
+      }
+   }
+}
+
+int main(int argc, char *argv[]) {
+   BfsOptions options;
+   size_t numberOfThreads;
+   readOptions(argc, argv, &options, &numberOfThreads);
    
    // Wczytanie danych.
-   Labyrinth *labyrinth = readInput();
+   double wallsTime;
+   Labyrinth *labyrinth = readInput(numberOfThreads, &wallsTime);
+   if (options.printStats)
+      fprintf(stderr, "Wall build time: %.6f s (%zu threads)\n", wallsTime, numberOfThreads);
 
    // Przejście labiryntu i wypisanie wyniku.
-   bfs(labyrinth);
+   bfs(labyrinth, &options);
    
    // Zwolnienie pamięci.
    freeLabyrinth(labyrinth); 
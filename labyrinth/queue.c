@@ -1,80 +1,294 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 
-struct Node;
+#define STARTING_SIZE 16
 
-struct Node {
-   size_t position;
-   size_t distance;
-   struct Node *prev;
-   struct Node *next;
-};
+// Poziom przeszukiwania. Pozycje przechowywane są w dwóch częściach:
+// - "bytes" zawiera skompresowane serie - każda seria to liczba jej elementów,
+//   a następnie różnice kolejnych posortowanych pozycji, zapisane w kodowaniu varint;
+// - "positions" zawiera pozycje, które nie zostały jeszcze skompresowane.
+typedef struct Level {
+   size_t *positions;
+   size_t count;
+   size_t size;
+   uint8_t *bytes;
+   size_t bytesCount;
+   size_t bytesSize;
+} Level;
 
 typedef struct Queue {
-   struct Node *front;
-   struct Node *back;
+   Level levels[2];
+   int current;
+   size_t readPosition;   // Indeks w "positions" bieżącego poziomu.
+   size_t readByte;       // Indeks w "bytes" bieżącego poziomu.
+   size_t runRemaining;   // Liczba nieodczytanych elementów bieżącej serii.
+   size_t runPrevious;    // Ostatnio odczytana pozycja bieżącej serii.
+   size_t memoryLimit;
+   size_t peakMemory;
 } Queue;
 
-Queue *createQueue() {
-   Queue *q;
-   q = malloc(sizeof(Queue));
-   if (q != NULL) {
-      q->front = NULL;
-      q->back = NULL;
+static size_t levelMemory(Level *level) {
+   return level->size * sizeof(size_t) + level->bytesSize;
+}
+
+static void updatePeakMemory(Queue *q) {
+   size_t memory = levelMemory(&(q->levels[0])) + levelMemory(&(q->levels[1]));
+   if (memory > q->peakMemory)
+      q->peakMemory = memory;
+}
+
+static int comparePositions(const void *a, const void *b) {
+   size_t x = *(const size_t *)a;
+   size_t y = *(const size_t *)b;
+   return (x > y) - (x < y);
+}
+
+static void writeVarint(Level *level, size_t number) {
+   while (number >= 128) {
+      (level->bytes)[level->bytesCount++] = (uint8_t)(number | 128);
+      number >>= 7;
    }
-   return q;
+   (level->bytes)[level->bytesCount++] = (uint8_t)number;
 }
 
-bool isEmpty(Queue *q) {
-   return (q->front == NULL);
+static size_t readVarint(Level *level, size_t *byte) {
+   size_t number = 0;
+   int shift = 0;
+   uint8_t b;
+   do {
+      b = (level->bytes)[(*byte)++];
+      number |= (size_t)(b & 127) << shift;
+      shift += 7;
+   } while (b & 128);
+   return number;
 }
 
-size_t getFirstPosition(Queue *q) {
-   return (q->front)->position;
+// Funkcja odczytuje liczbę w kodowaniu varint, sprawdzając, czy mieści się
+// ona w skompresowanej części poziomu i w typie size_t.
+// Zwraca "true", jeżeli się to udało i "false" w przeciwnym razie.
+static bool readCheckedVarint(Level *level, size_t *byte, size_t *number) {
+   *number = 0;
+   for (int shift = 0; *byte < level->bytesCount && shift < 64; shift += 7) {
+      uint8_t b = (level->bytes)[(*byte)++];
+      size_t part = (size_t)(b & 127);
+      if ((part << shift) >> shift != part)
+         return false;
+      *number |= part << shift;
+      if (!(b & 128))
+         return true;
+   }
+   return false;
 }
 
-size_t getFirstDistance(Queue *q) {
-   return (q->front)->distance;
+// Funkcja sprawdza, czy skompresowana część poziomu od bajtu "from" składa się
+// z poprawnych serii, a wszystkie pozycje są mniejsze od "limit".
+static bool checkRuns(Level *level, size_t from, size_t limit) {
+   size_t byte = from;
+   while (byte < level->bytesCount) {
+      size_t count;
+      if (!readCheckedVarint(level, &byte, &count))
+         return false;
+
+      size_t position = 0;
+      for (size_t i = 0; i < count; i++) {
+         size_t difference;
+         if (!readCheckedVarint(level, &byte, &difference) || difference >= limit - position)
+            return false;
+         position += difference;
+      }
+   }
+   return true;
+}
+
+static size_t varintLength(size_t number) {
+   size_t length = 1;
+   while (number >= 128) {
+      number >>= 7;
+      length++;
+   }
+   return length;
 }
 
-bool push(Queue *q, size_t position, size_t distance) {
-   struct Node *node = NULL;
-   node = malloc(sizeof(struct Node));
-   if (node == NULL)
+static bool putVarint(FILE *file, size_t number) {
+   while (number >= 128) {
+      if (putc((int)((number & 127) | 128), file) == EOF)
+         return false;
+      number >>= 7;
+   }
+   return (putc((int)number, file) != EOF);
+}
+
+// Funkcja zapewnia, że w skompresowanej części poziomu zmieści się "needed" bajtów.
+static bool reserveBytes(Level *level, size_t needed) {
+   if (needed <= level->bytesSize)
+      return true;
+
+   size_t size = (level->bytesSize == 0 ? STARTING_SIZE : level->bytesSize);
+   while (size < needed)
+      size *= 2;
+   uint8_t *indicator = realloc(level->bytes, size);
+   if (indicator == NULL)
       return false;
-      
-   node->position = position;
-   node->distance = distance;
-   node->prev = NULL;
-   node->next = NULL;
-   if (q->back == NULL) {
-      q->front = node;
-      q->back = node;
+   level->bytes = indicator;
+   level->bytesSize = size;
+   return true;
+}
+
+// Funkcja sortuje nieskompresowane pozycje poziomu i zwraca liczbę bajtów
+// potrzebnych do zapisania ich jako jednej serii.
+static size_t sortRun(Level *level) {
+   qsort(level->positions, level->count, sizeof(size_t), comparePositions);
+
+   size_t needed = varintLength(level->count);
+   size_t previous = 0;
+   for (size_t i = 0; i < level->count; i++) {
+      needed += varintLength((level->positions)[i] - previous);
+      previous = (level->positions)[i];
    }
-   else {
-      (q->back)->next = node;
-      node->prev = q->back;
-      q->back = node;
+   return needed;
+}
+
+// Funkcja sortuje nieskompresowane pozycje poziomu i dopisuje je jako nową serię.
+// Zwraca "true", jeżeli się to udało i "false" w przeciwnym razie.
+static bool compressLevel(Level *level) {
+   size_t needed = level->bytesCount + sortRun(level);
+   if (!reserveBytes(level, needed))
+      return false;
+
+   writeVarint(level, level->count);
+   size_t previous = 0;
+   for (size_t i = 0; i < level->count; i++) {
+      writeVarint(level, (level->positions)[i] - previous);
+      previous = (level->positions)[i];
    }
+   level->count = 0;
    return true;
 }
 
-void pop(Queue *q) {
-   struct Node *node = q->front;
-   if (node->next == NULL) {
-      q->front = NULL;
-      q->back = NULL;
+Queue *createQueue(size_t memoryLimit) {
+   Queue *q;
+   q = calloc(1, sizeof(Queue));
+   if (q != NULL)
+      q->memoryLimit = memoryLimit;
+   return q;
+}
+
+bool push(Queue *q, size_t position) {
+   Level *level = &(q->levels[1 - q->current]);
+   if (level->count == level->size) {
+      if (q->memoryLimit > 0 && level->count > 0
+          && level->count * sizeof(size_t) >= q->memoryLimit) {
+         if (!compressLevel(level))
+            return false;
+      }
+      else {
+         size_t size = (level->size == 0 ? STARTING_SIZE : 2 * level->size);
+         size_t *indicator = realloc(level->positions, size * sizeof(size_t));
+         if (indicator == NULL)
+            return false;
+         level->positions = indicator;
+         level->size = size;
+      }
+      updatePeakMemory(q);
    }
-   else {
-      q->front = node->next;
-      (node->next)->prev = NULL;
+
+   (level->positions)[level->count++] = position;
+   return true;
+}
+
+bool pop(Queue *q, size_t *position) {
+   Level *level = &(q->levels[q->current]);
+   if (q->runRemaining == 0 && q->readByte < level->bytesCount) {
+      q->runRemaining = readVarint(level, &(q->readByte));
+      q->runPrevious = 0;
+   }
+
+   if (q->runRemaining > 0) {
+      q->runPrevious += readVarint(level, &(q->readByte));
+      q->runRemaining--;
+      *position = q->runPrevious;
+      return true;
+   }
+
+   if (q->readPosition < level->count) {
+      *position = (level->positions)[q->readPosition++];
+      return true;
+   }
+   return false;
+}
+
+bool nextLevel(Queue *q) {
+   Level *level = &(q->levels[q->current]);
+   level->count = 0;
+   level->bytesCount = 0;
+
+   q->current = 1 - q->current;
+   q->readPosition = 0;
+   q->readByte = 0;
+   q->runRemaining = 0;
+
+   level = &(q->levels[q->current]);
+   return (level->count > 0 || level->bytesCount > 0);
+}
+
+size_t getPeakMemory(Queue *q) {
+   return q->peakMemory;
+}
+
+bool writeLevel(Queue *q, FILE *file) {
+   Level *level = &(q->levels[q->current]);
+   size_t runBytes = (level->count > 0 ? sortRun(level) : 0);
+   size_t totalBytes = level->bytesCount + runBytes;
+
+   if (fwrite(&totalBytes, sizeof(size_t), 1, file) != 1)
+      return false;
+   if (level->bytesCount > 0
+       && fwrite(level->bytes, 1, level->bytesCount, file) != level->bytesCount)
+      return false;
+
+   if (level->count == 0)
+      return true;
+
+   if (!putVarint(file, level->count))
+      return false;
+   size_t previous = 0;
+   for (size_t i = 0; i < level->count; i++) {
+      if (!putVarint(file, (level->positions)[i] - previous))
+         return false;
+      previous = (level->positions)[i];
+   }
+   return true;
+}
+
+bool readLevel(Queue *q, FILE *file, size_t limit) {
+   Level *level = &(q->levels[1 - q->current]);
+   size_t totalBytes;
+   if (fread(&totalBytes, sizeof(size_t), 1, file) != 1
+       || totalBytes > SIZE_MAX - level->bytesCount
+       || !reserveBytes(level, level->bytesCount + totalBytes))
+      return false;
+
+   if (fread(level->bytes + level->bytesCount, 1, totalBytes, file) != totalBytes)
+      return false;
+
+   // Wczytane bajty są dołączane do poziomu dopiero po sprawdzeniu, więc
+   // uszkodzony plik nie zmienia kolejki.
+   size_t from = level->bytesCount;
+   level->bytesCount += totalBytes;
+   if (limit == 0 || !checkRuns(level, from, limit)) {
+      level->bytesCount = from;
+      return false;
    }
-   free(node);
+   updatePeakMemory(q);
+   return true;
 }
 
 void clearQueue(Queue *q) {
-   while (!isEmpty(q))
-      pop(q);
+   for (int i = 0; i < 2; i++) {
+      free(q->levels[i].positions);
+      free(q->levels[i].bytes);
+   }
    free(q);
 }
\ No newline at end of file
@@ -1,27 +1,42 @@
 #ifndef QUEUE_H
 #define QUEUE_H
 
+// Kolejka przechowuje wierzchołki dwóch kolejnych poziomów przeszukiwania:
+// bieżącego (z którego wierzchołki są zdejmowane) i następnego (do którego
+// są dodawane). Wszystkie wierzchołki jednego poziomu mają ten sam dystans,
+// dlatego kolejka przechowuje tylko pozycje.
 typedef struct Queue Queue;
 
 // Funkcja tworzy nową kolejkę i zwraca wskaźnik na nią.
-Queue *createQueue();
+// memoryLimit - liczba bajtów, po przekroczeniu której nieskompresowane
+// pozycje następnego poziomu są sortowane i kompresowane (0 - bez kompresji).
+Queue *createQueue(size_t memoryLimit);
 
-// Funkcja sprawdza, czy kolejka jest pusta.
-bool isEmpty(Queue *q);
+// Funkcja dodaje wierzchołek do następnego poziomu.
+// Zwraca "true", jeżeli się to udało i "false" w przeciwnym razie.
+bool push(Queue *q, size_t position);
+
+// Funkcja zdejmuje wierzchołek z bieżącego poziomu i zapisuje go w "position".
+// Zwraca "false", jeżeli bieżący poziom jest już pusty.
+bool pop(Queue *q, size_t *position);
 
-// Funkcja zwraca pozycję w labiryncie wierzchołka z początku kolejki.
-size_t getFirstPosition(Queue *q);
+// Funkcja czyni następny poziom bieżącym.
+// Zwraca "false", jeżeli nowy bieżący poziom jest pusty.
+bool nextLevel(Queue *q);
 
-// Funkcja zwraca dystans wierzchołka z początku kolejki.
-size_t getFirstDistance(Queue *q);
+// Funkcja zwraca największą liczbę bajtów zajmowanych jednocześnie przez oba poziomy.
+size_t getPeakMemory(Queue *q);
 
-// Funkcja dodaje wierzchołek na koniec kolejki.
+// Funkcja zapisuje do pliku pozycje bieżącego poziomu w postaci skompresowanej.
+// Może zostać wykonana tylko na granicy poziomów (przed pierwszym wywołaniem "pop").
 // Zwraca "true", jeżeli się to udało i "false" w przeciwnym razie.
-bool push(Queue *q, size_t position, size_t distance);
+bool writeLevel(Queue *q, FILE *file);
 
-// Funkcja usuwa wierzchołek z początku kolejki.
-// Może zostać wykonana tylko na niepustej kolejce.
-void pop(Queue *q);
+// Funkcja wczytuje z pliku pozycje zapisane przez "writeLevel" do następnego poziomu.
+// Wszystkie pozycje muszą być mniejsze od "limit".
+// Zwraca "true", jeżeli się to udało i "false", jeżeli nie udało się wczytać
+// pliku lub zawiera on niepoprawne dane (następny poziom nie jest wtedy zmieniany).
+bool readLevel(Queue *q, FILE *file, size_t limit);
 
 // Funkcja czyszcząca kolejkę.
 void clearQueue(Queue *q);
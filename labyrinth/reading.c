@@ -1,13 +1,51 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <limits.h>
 #include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include "bitset.h"
 #include "structs.h"
 
 #define STARTING_SIZE 4
 
+// Liczba pozycji ścian, które wątek wyznacza w jednej rundzie budowania ścian
+// z opisu z "R", zanim przekaże je wątkom będącym właścicielami ich słów.
+#define ROUND_POSITIONS (1 << 16)
+
+// Dane wspólne dla wątków budujących ściany z opisu z "R".
+typedef struct WallsShared {
+   pthread_mutex_t gate;      // Zatrzymuje wątki do czasu podziału pracy.
+   pthread_barrier_t barrier; // Oddziela wyznaczanie pozycji od ustawiania bitów.
+   size_t numberOfTasks;      // Liczba wątków, które udało się uruchomić.
+   size_t rounds;             // Liczba rund.
+} WallsShared;
+
+// Fragment ścian budowany przez jeden wątek - w postaci szesnastkowej pozycje
+// z przedziału [begin, end), a w postaci z "R" wyrazy s_i dla i z (begin, end].
+typedef struct WallsTask {
+   Bitset *walls;
+   size_t labyrinthSize;
+   size_t begin, end;
+   char const *hexidecimalNumber; // Opis w postaci szesnastkowej.
+   size_t count;                  // Liczba cyfr szesnastkowych.
+   size_t tab[5];                 // Opis w postaci z "R".
+   bool error;                    // Czy w opisie jest ściana spoza labiryntu.
+
+   // Budowanie ścian z opisu z "R" przez wiele wątków. Słowa bitsetu są
+   // podzielone między wątki przez "splitRange" i każde zmienia tylko właściciel.
+   WallsShared *shared;
+   struct WallsTask *tasks;       // Zadania wszystkich wątków.
+   size_t termsInRound;           // Liczba wyrazów ciągu wyznaczanych w rundzie.
+   size_t *positions;             // Pozycje wyznaczone w bieżącej rundzie.
+   size_t *sorted;                // Te same pozycje pogrupowane według właścicieli.
+   size_t *offsets;               // Początki grup w "sorted".
+} WallsTask;
+
 // Pomocnicza struktura
 typedef struct NumberStruct {
    bool endOfLine, error, readedTheNumber;
@@ -200,11 +238,129 @@ static int readHexidecimalString(char **hexidecimalNumber, size_t *count) {
    return 1;
 }
 
-// Funkcja wczytuje opis ścian w postaci z "R". Zwraca:
+// Funkcja zwraca bieżący czas w sekundach.
+static double currentTime() {
+   struct timespec ts;
+   timespec_get(&ts, TIME_UTC);
+   return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Funkcja wyznacza "index"-ty z "parts" rozłącznych fragmentów przedziału
+// [0, total) i zapisuje go jako [*begin, *end). Granice fragmentów są
+// wielokrotnościami "unit", a długości fragmentów różnią się o co najwyżej
+// "unit", więc każdy fragment dostaje pracę, o ile jednostek jest dość.
+static void splitRange(size_t total, size_t unit, size_t parts, size_t index, 
+                       size_t *begin, size_t *end) {
+   size_t units = (total == 0 ? 0 : (total - 1) / unit + 1);
+   size_t base = units / parts, extra = units % parts;
+   size_t first = index * base + (index < extra ? index : extra);
+   size_t last = first + base + (index < extra ? 1 : 0);
+
+   *begin = (first < units ? first * unit : total);
+   *end = (last < units ? last * unit : total);
+}
+
+// Funkcja zwraca indeks fragmentu wyznaczonego przez "splitRange" dla
+// jednostki "unit", w którym znajduje się pozycja "position".
+static size_t rangeOwner(size_t total, size_t unit, size_t parts, size_t position) {
+   size_t units = (total - 1) / unit + 1;
+   size_t base = units / parts, extra = units % parts;
+   size_t index = position / unit;
+
+   if (index < extra * (base + 1))
+      return index / (base + 1);
+   return extra + (index - extra * (base + 1)) / base;
+}
+
+// Funkcja dzieli przedział [0, total) między zadania. Granice fragmentów są
+// wielokrotnościami "unit".
+static void splitTasks(WallsTask *tasks, size_t numberOfTasks, size_t total, size_t unit) {
+   for (size_t i = 0; i < numberOfTasks; i++) {
+      splitRange(total, unit, numberOfTasks, i, &tasks[i].begin, &tasks[i].end);
+      tasks[i].error = false;
+   }
+}
+
+// Funkcja wykonuje zadania, każde w osobnym wątku (pierwsze w wątku wywołującym).
+// Zwraca "true", jeżeli w żadnym fragmencie nie wykryto błędu.
+static bool runTasks(WallsTask *tasks, size_t numberOfTasks, void *(*function)(void *)) {
+   pthread_t threads[numberOfTasks];
+   bool started[numberOfTasks];
+
+   for (size_t i = 1; i < numberOfTasks; i++)
+      started[i] = (pthread_create(&threads[i], NULL, function, &tasks[i]) == 0);
+
+   function(&tasks[0]);
+   bool result = !tasks[0].error;
+
+   for (size_t i = 1; i < numberOfTasks; i++) {
+      if (started[i])
+         pthread_join(threads[i], NULL);
+      else
+         function(&tasks[i]); // Nie udało się utworzyć wątku.
+      if (tasks[i].error)
+         result = false;
+   }
+
+   return result;
+}
+
+// Funkcja zwraca wartość cyfry szesnastkowej.
+static uint64_t hexidecimalDigitValue(char digit) {
+   if (digit >= 'a' && digit <= 'f')
+      return (uint64_t)(10 + digit - 'a');
+   if (digit >= 'A' && digit <= 'F')
+      return (uint64_t)(10 + digit - 'A');
+   return (uint64_t)(digit - '0');
+}
+
+// Funkcja ustawia ściany opisane cyframi szesnastkowymi z fragmentu zadania.
+// Ściany ustawiane są całymi słowami - 16 cyfr na słowo.
+static void *buildHexidecimalWalls(void *argument) {
+   WallsTask *task = argument;
+   size_t const digitsInWord = BITSET_WORD_BITS / 4;
+   size_t const size = task->labyrinthSize;
+
+   for (size_t index = task->begin / BITSET_WORD_BITS; 
+        index < task->end / BITSET_WORD_BITS; index++) {
+      // Cyfra o indeksie k (licząc od końca napisu) opisuje pozycje 4k..4k+3.
+      size_t first = index * digitsInWord;
+      size_t last = (task->count - first < digitsInWord ? task->count : first + digitsInWord);
+      uint64_t word = 0;
+      for (size_t k = first; k < last; k++)
+         word |= hexidecimalDigitValue(task->hexidecimalNumber[task->count - 1 - k]) 
+                 << (4 * (k - first));
+
+      // Słowa za końcem bitsetu mogą zawierać tylko wiodące zera.
+      size_t begin = index * BITSET_WORD_BITS;
+      if (begin >= size) {
+         if (word != 0) {
+            task->error = true;
+            return NULL;
+         }
+         continue;
+      }
+
+      // Ostatnie słowo jest dopisywane w całości, a bity spoza labiryntu są
+      // potem czyszczone - jeżeli któryś był ustawiony, opis jest błędny.
+      uint64_t outside = bitsetMaskFrom(size - begin);
+      bitsetOrWord(task->walls, index, word);
+      bitsetAndNotWord(task->walls, index, outside);
+      if ((word & outside) != 0) {
+         task->error = true;
+         return NULL;
+      }
+   }
+
+   return NULL;
+}
+
+// Funkcja wczytuje opis ścian w postaci szesnastkowej. Zwraca:
 // 1, jeżeli wszystko się udało;
 // 0, jeżeli wystąpił problem z pamięcią;
 // -1, jeżeli wiersz nie spełniał wymagać.
-static int readHexidecimalNumber(Labyrinth *labyrinth, size_t labyrinthSize) {
+static int readHexidecimalNumber(Labyrinth *labyrinth, size_t labyrinthSize, 
+                                 size_t numberOfThreads, double *wallsTime) {
    char *hexidecimalNumber;
    size_t count = 0;
 
@@ -212,37 +368,216 @@ static int readHexidecimalNumber(Labyrinth *labyrinth, size_t labyrinthSize) {
    if (result != 1)
       freeLabyrinthAndExitWithError(labyrinth, (result == 0 ? 0 : 4));
 
-   size_t position = 0;
+   if (count == 0) {
+      free(hexidecimalNumber);
+      return 1;
+   }
 
-   // Rozpatruję indeks o 1 większy, gdyż wyrażenie i >= 0 byłoby zawsze prawdziwe dla i typu size_t.
-   for (size_t i = count; i > 0; i--) {
-      int number = hexidecimalNumber[i - 1] - '0';
-      if (hexidecimalNumber[i - 1] >= 'a' && hexidecimalNumber[i - 1] <= 'f')
-         number = 10 + hexidecimalNumber[i - 1] - 'a';
-      if (hexidecimalNumber[i - 1] >= 'A' && hexidecimalNumber[i - 1] <= 'F')
-         number = 10 + hexidecimalNumber[i - 1] - 'A';
-
-      for (int j = 0; j < 4; j++) {
-         if ((number & (1 << j)) != 0) {
-            if (position + j >= labyrinthSize) {
-               free(hexidecimalNumber);
-               return -1;
-            }
-            setWall(labyrinth, position + j);
-         }
+   double start = currentTime();
+   WallsTask tasks[numberOfThreads];
+   for (size_t i = 0; i < numberOfThreads; i++) {
+      tasks[i].walls = getWalls(labyrinth);
+      tasks[i].labyrinthSize = labyrinthSize;
+      tasks[i].hexidecimalNumber = hexidecimalNumber;
+      tasks[i].count = count;
+   }
+   // Fragmenty składają się z całych słów, więc każde słowo należy do jednego wątku.
+   size_t words = (4 * count - 1) / BITSET_WORD_BITS + 1;
+   splitTasks(tasks, numberOfThreads, words * BITSET_WORD_BITS, BITSET_WORD_BITS);
+   bool correct = runTasks(tasks, numberOfThreads, buildHexidecimalWalls);
+   *wallsTime = currentTime() - start;
+
+   free(hexidecimalNumber);
+   return (correct ? 1 : -1);
+}
+
+// Funkcja zwraca s_k, czyli wynik k-krotnego złożenia s -> (a * s + b) mod m
+// z samym sobą, zastosowanego do "s". Złożenie przekształceń afinicznych jest
+// afiniczne, więc wystarczy O(log k) mnożeń. Wszystkie liczby są mniejsze od
+// 2^32, więc iloczyny mieszczą się w 64 bitach.
+static size_t jumpAhead(size_t a, size_t b, size_t m, size_t s, size_t k) {
+   size_t multiplier = 1 % m, increment = 0; // Złożenie dotychczasowych kroków.
+   a %= m;
+   b %= m;
+   while (k > 0) {
+      if (k & 1) {
+         multiplier = (multiplier * a) % m;
+         increment = (increment * a + b) % m;
+      }
+      b = ((a + 1) * b) % m;
+      a = (a * a) % m;
+      k >>= 1;
+   }
+   return (multiplier * s + increment) % m;
+}
+
+// Funkcja wyznacza pozycje ścian opisanych przez wyrazy s_i dla i z (from, to]
+// i zapisuje je w "positions". Aktualizuje wyraz "s" i zwraca liczbę pozycji.
+static size_t wallsOfTerms(WallsTask const *task, size_t *s, size_t from, size_t to, 
+                           size_t *positions) {
+   size_t a = task->tab[0], b = task->tab[1], m = task->tab[2];
+   size_t x = ((size_t)1 << 32);
+   size_t count = 0;
+
+   for (size_t i = from + 1; i <= to; i++) {
+      *s = (a * *s + b) % m;
+      for (size_t w = *s % task->labyrinthSize; w < task->labyrinthSize; w += x) {
+         positions[count++] = w;
+         if (SIZE_MAX - x < w)
+            break;
+      }
+   }
+
+   return count;
+}
+
+// Funkcja grupuje pozycje wyznaczone w rundzie według wątków, do których należą
+// ich słowa (sortowanie przez zliczanie).
+static void groupByOwner(WallsTask *task, size_t count) {
+   size_t numberOfTasks = task->shared->numberOfTasks;
+   size_t words = task->walls->words;
+   size_t next[numberOfTasks];
+
+   for (size_t o = 0; o <= numberOfTasks; o++)
+      task->offsets[o] = 0;
+   for (size_t j = 0; j < count; j++) {
+      size_t word = task->positions[j] / BITSET_WORD_BITS;
+      task->offsets[rangeOwner(words, 1, numberOfTasks, word) + 1]++;
+   }
+   for (size_t o = 0; o < numberOfTasks; o++) {
+      task->offsets[o + 1] += task->offsets[o];
+      next[o] = task->offsets[o];
+   }
+   for (size_t j = 0; j < count; j++) {
+      size_t word = task->positions[j] / BITSET_WORD_BITS;
+      task->sorted[next[rangeOwner(words, 1, numberOfTasks, word)]++] = task->positions[j];
+   }
+}
+
+// Funkcja ustawia ściany opisane w postaci z "R" przez wyrazy s_i należące do
+// fragmentu zadania. Wątek przeskakuje od razu do wyrazu s_begin, więc każdy
+// wyraz ciągu jest wyznaczany tylko raz. Przy wielu wątkach praca przebiega
+// w rundach: każdy wątek wyznacza pozycje z kolejnej porcji swoich wyrazów
+// i grupuje je według właścicieli słów, a po barierze każdy właściciel ustawia
+// bity ze swoich grup u wszystkich wątków. Słowa nie są więc nigdy zmieniane
+// jednocześnie przez dwa wątki i nie są potrzebne operacje atomowe.
+static void *buildWallsWithR(void *argument) {
+   WallsTask *task = argument;
+   WallsShared *shared = task->shared;
+
+   // Czekanie, aż wątek główny uruchomi pozostałe wątki i podzieli pracę.
+   pthread_mutex_lock(&shared->gate);
+   pthread_mutex_unlock(&shared->gate);
+
+   size_t s = jumpAhead(task->tab[0], task->tab[1], task->tab[2], task->tab[4], task->begin);
+   size_t numberOfTasks = shared->numberOfTasks;
+   size_t self = (size_t)(task - task->tasks);
+   size_t step = task->termsInRound;
+
+   if (numberOfTasks == 1) {
+      for (size_t from = task->begin; from < task->end; from += step) {
+         size_t to = (task->end - from > step ? from + step : task->end);
+         size_t count = wallsOfTerms(task, &s, from, to, task->positions);
+         for (size_t j = 0; j < count; j++)
+            bitsetSet(task->walls, task->positions[j]);
       }
+      return NULL;
+   }
 
-      position += 4;
+   size_t from = task->begin;
+   for (size_t round = 0; round < shared->rounds; round++) {
+      size_t to = (task->end - from > step ? from + step : task->end);
+      groupByOwner(task, wallsOfTerms(task, &s, from, to, task->positions));
+      from = to;
+      pthread_barrier_wait(&shared->barrier);
+
+      for (size_t p = 0; p < numberOfTasks; p++) {
+         WallsTask const *producer = &task->tasks[p];
+         for (size_t j = producer->offsets[self]; j < producer->offsets[self + 1]; j++)
+            bitsetSet(task->walls, producer->sorted[j]);
+      }
+      pthread_barrier_wait(&shared->barrier);
    }
 
-   free(hexidecimalNumber);
-   return 1;
+   return NULL;
+}
+
+// Funkcja dzieli wyrazy ciągu między "numberOfTasks" zadań.
+static void splitWallsWithR(WallsTask *tasks, WallsShared *shared, size_t numberOfTasks) {
+   shared->numberOfTasks = numberOfTasks;
+   splitTasks(tasks, numberOfTasks, tasks[0].tab[3], 1);
+
+   // Pierwsze zadanie ma najwięcej wyrazów.
+   size_t longest = tasks[0].end - tasks[0].begin;
+   shared->rounds = (longest == 0 ? 0 : (longest - 1) / tasks[0].termsInRound + 1);
+}
+
+// Funkcja buduje ściany z opisu z "R" w "numberOfTasks" wątkach (pierwsze
+// zadanie w wątku wywołującym). Jeżeli nie uda się uruchomić wszystkich wątków,
+// praca jest dzielona między te, które działają. Zwraca "false", jeżeli
+// zabrakło pamięci.
+static bool runWallsWithR(WallsTask *tasks, size_t numberOfTasks) {
+   WallsShared shared;
+   pthread_t threads[numberOfTasks];
+   bool result = true;
+
+   // Każdy wyraz ciągu daje co najwyżej "perTerm" pozycji.
+   size_t perTerm = (tasks[0].labyrinthSize - 1) / ((size_t)1 << 32) + 1;
+   size_t termsInRound = (ROUND_POSITIONS > perTerm ? ROUND_POSITIONS / perTerm : 1);
+   for (size_t i = 0; i < numberOfTasks; i++) {
+      tasks[i].shared = &shared;
+      tasks[i].tasks = tasks;
+      tasks[i].termsInRound = termsInRound;
+      tasks[i].positions = malloc(termsInRound * perTerm * sizeof(size_t));
+      tasks[i].sorted = malloc(termsInRound * perTerm * sizeof(size_t));
+      tasks[i].offsets = malloc((numberOfTasks + 1) * sizeof(size_t));
+      if (tasks[i].positions == NULL || tasks[i].sorted == NULL || tasks[i].offsets == NULL)
+         result = false;
+   }
+
+   if (result && pthread_mutex_init(&shared.gate, NULL) == 0) {
+      pthread_mutex_lock(&shared.gate);
+      size_t started = 1;
+      while (started < numberOfTasks 
+             && pthread_create(&threads[started], NULL, buildWallsWithR, &tasks[started]) == 0)
+         started++;
+
+      splitWallsWithR(tasks, &shared, started);
+      bool barrier = (started == 1 
+                      || pthread_barrier_init(&shared.barrier, NULL, (unsigned)started) == 0);
+      if (!barrier) { // Całą pracę wykonuje wątek wywołujący.
+         splitWallsWithR(tasks, &shared, 1);
+         for (size_t i = 1; i < started; i++)
+            tasks[i].begin = tasks[i].end;
+      }
+      pthread_mutex_unlock(&shared.gate);
+
+      buildWallsWithR(&tasks[0]);
+      for (size_t i = 1; i < started; i++)
+         pthread_join(threads[i], NULL);
+
+      if (barrier && started > 1)
+         pthread_barrier_destroy(&shared.barrier);
+      pthread_mutex_destroy(&shared.gate);
+   }
+   else {
+      result = false;
+   }
+
+   for (size_t i = 0; i < numberOfTasks; i++) {
+      free(tasks[i].positions);
+      free(tasks[i].sorted);
+      free(tasks[i].offsets);
+   }
+   return result;
 }
 
 // Funkcja wczytuje opis ścian w postaci z "R". Zwraca:
 // 1, jeżeli wszystko się udało;
+// 0, jeżeli wystąpił problem z pamięcią;
 // -1, jeżeli wiersz nie spełniał wymagać.
-static int readWallsWithR(Labyrinth *labyrinth, size_t labyrinthSize) {
+static int readWallsWithR(Labyrinth *labyrinth, size_t labyrinthSize, 
+                          size_t numberOfThreads, double *wallsTime) {
    size_t tab[5];
    bool endOfLine = false;
 
@@ -265,42 +600,42 @@ static int readWallsWithR(Labyrinth *labyrinth, size_t labyrinthSize) {
          return -1;
    }
 
-   size_t a = tab[0], b = tab[1], m = tab[2], r = tab[3], s = tab[4];
-
-   if (m == 0)
+   if (tab[2] == 0)
       return -1;
-
-   for (size_t i = 1; i <= r; i++) {
-      s = (a * s + b) % m;
-      size_t w = s % labyrinthSize;
-      size_t x = ((size_t)1 << 32);
-      while (w < labyrinthSize) {
-         setWall(labyrinth, w);
-         if (SIZE_MAX - x < w)
-            break;
-         w += x;
-      }
+   if (tab[3] == 0)
+      return 1;
+
+   double start = currentTime();
+   WallsTask tasks[numberOfThreads];
+   for (size_t i = 0; i < numberOfThreads; i++) {
+      tasks[i].walls = getWalls(labyrinth);
+      tasks[i].labyrinthSize = labyrinthSize;
+      for (int j = 0; j < 5; j++)
+         tasks[i].tab[j] = tab[j];
    }
+   bool correct = runWallsWithR(tasks, numberOfThreads);
+   *wallsTime = currentTime() - start;
 
-   return 1;
+   return (correct ? 1 : 0);
 }
 
 // Funkcja wczytuje czwarty wiersz i ustawia ściany. Zwraca:
 // 1, jeżeli wszystko się udało;
 // 0, jeżeli wystąpił problem z pamięcią;
 // -1, jeżeli wiersz nie spełniał wymagać.
-static int readWalls(Labyrinth *labyrinth, size_t labyrinthSize) {
+static int readWalls(Labyrinth *labyrinth, size_t labyrinthSize, 
+                     size_t numberOfThreads, double *wallsTime) {
    int cInt = 0;
    cInt = getchar();
    while (cInt >= 0 && cInt != 10) {
       if (cInt == (int)'R') {
-         return readWallsWithR(labyrinth, labyrinthSize);
+         return readWallsWithR(labyrinth, labyrinthSize, numberOfThreads, wallsTime);
       }
       else if (cInt == (int)'0') {
          cInt = getchar();
          if (cInt != (int)'x')
             return -1;
-         return readHexidecimalNumber(labyrinth, labyrinthSize);
+         return readHexidecimalNumber(labyrinth, labyrinthSize, numberOfThreads, wallsTime);
       }
       else if (isspace(cInt)) {
          cInt = getchar();
@@ -312,7 +647,7 @@ static int readWalls(Labyrinth *labyrinth, size_t labyrinthSize) {
    return -1;
 }
 
-Labyrinth *readInput() {
+Labyrinth *readInput(size_t numberOfThreads, double *wallsTime) {
    // Utworzenie tablicy.
    size_t numberOfDimensions = 0;
    size_t size = STARTING_SIZE;
@@ -341,7 +676,8 @@ Labyrinth *readInput() {
       freeLabyrinthAndExitWithError(labyrinth, 0);
 
    // Wczytanie czwartego wiersza.
-   int resultWall = readWalls(labyrinth, labyrinthSize);
+   *wallsTime = 0;
+   int resultWall = readWalls(labyrinth, labyrinthSize, numberOfThreads, wallsTime);
    if (resultWall != 1)
       freeLabyrinthAndExitWithError(labyrinth, (resultWall == 0 ? 0 : 4));
 
@@ -1,8 +1,9 @@
 #ifndef READING_H
 #define READING_H
 
-// Funkcja wczytuje wejście.
+// Funkcja wczytuje wejście, ściany budowane są przez "numberOfThreads" wątków.
+// W "wallsTime" zapisuje czas budowania ścian w sekundach.
 // Zwraca wskaźnik do structa "Labyrinth" zawierającego opis labiryntu.
-Labyrinth *readInput();
+Labyrinth *readInput(size_t numberOfThreads, double *wallsTime);
 
 #endif /* READING_H */
\ No newline at end of file
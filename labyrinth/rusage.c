@@ -0,0 +1,49 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+// Program uruchamia podane polecenie ze standardowym wejściem i wyjściami
+// odziedziczonymi po sobie, a po jego zakończeniu zapisuje do pliku maksymalne
+// zużycie pamięci (RSS) w kilobajtach odczytane przez getrusage. Zastępuje
+// "/usr/bin/time -f %M -o plik" w test.sh tam, gdzie tego programu nie ma.
+// Użycie: ./rusage plik polecenie [argumenty...]
+// Kod wyjścia jest kodem wyjścia polecenia.
+
+int main(int argc, char *argv[]) {
+   if (argc < 3) {
+      fprintf(stderr, "Usage: %s output_file command [arguments...]\n", argv[0]);
+      return 1;
+   }
+
+   pid_t child = fork();
+   if (child < 0)
+      return 1;
+   if (child == 0) {
+      execvp(argv[2], &argv[2]);
+      _exit(127);
+   }
+
+   int status;
+   if (waitpid(child, &status, 0) != child)
+      return 1;
+
+   struct rusage usage;
+   FILE *file = fopen(argv[1], "w");
+   if (file == NULL || getrusage(RUSAGE_CHILDREN, &usage) != 0) {
+      if (file != NULL)
+         fclose(file);
+      return 1;
+   }
+   // W Linuksie ru_maxrss jest podawane w kilobajtach.
+   fprintf(file, "%ld\n", (long)usage.ru_maxrss);
+   fclose(file);
+
+   if (WIFEXITED(status))
+      return WEXITSTATUS(status);
+   return 128 + WTERMSIG(status);
+}
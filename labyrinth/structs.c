@@ -2,11 +2,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
-
-// Pomocnicza struktura do przechowywania informacji o ścianach.
-typedef struct Bitset {
-   int32_t *table;
-} Bitset;
+#include "bitset.h"
 
 typedef struct Labyrinth {
    size_t *dimensions;
@@ -23,25 +19,17 @@ static Bitset *createBitset(size_t numberOfElements) {
    if (bitset == NULL)
       return NULL;
 
-   bitset->table = calloc((numberOfElements - 1) / 32 + 1, sizeof(int32_t));
-   if (bitset->table == NULL)
+   bitset->size = numberOfElements;
+   bitset->words = (numberOfElements - 1) / BITSET_WORD_BITS + 1;
+   bitset->table = calloc(bitset->words, sizeof(uint64_t));
+   if (bitset->table == NULL) {
+      free(bitset);
       return NULL;
+   }
 
    return bitset;
 }
 
-static bool checkPosition(Bitset *bitset, size_t position) {
-   size_t positionInTable = position / 32;
-   int32_t bitInNumber = (int32_t)(position & 31);
-   return ((bitset->table)[positionInTable] & (int32_t)(1 << bitInNumber));
-}
-
-static void setPosition(Bitset *bitset, size_t position) {
-   size_t positionInTable = position / 32;
-   int32_t bitInNumber = (int32_t)(position & 31);
-   (bitset->table)[positionInTable] |= (int32_t)(1 << bitInNumber);
-}
-
 static void freeBitset(Bitset *bitset) {
    if (bitset != NULL)
       free(bitset->table);
@@ -90,12 +78,44 @@ size_t getLabyrinthSize(Labyrinth *labyrinth) {
    return labyrinth->labyrinthSize;
 }
 
+Bitset *getWalls(Labyrinth *labyrinth) {
+   return labyrinth->bitset;
+}
+
 bool checkWall(Labyrinth *labyrinth, size_t position) {
-   return checkPosition(labyrinth->bitset, position);
+   return bitsetCheck(labyrinth->bitset, position);
 }
 
-void setWall(Labyrinth *labyrinth, size_t position) {
-   setPosition(labyrinth->bitset, position);
+uint64_t hashWalls(Labyrinth *labyrinth) {
+   // Skrót FNV-1a liczony po kolejnych słowach bitsetu.
+   uint64_t hash = 14695981039346656037ULL;
+   Bitset *bitset = labyrinth->bitset;
+   for (size_t i = 0; i < bitset->words; i++) {
+      hash ^= bitsetGetWord(bitset, i);
+      hash *= 1099511628211ULL;
+   }
+   return hash;
+}
+
+size_t getWallsSize(Labyrinth *labyrinth) {
+   return labyrinth->bitset->words * sizeof(uint64_t);
+}
+
+bool saveWalls(Labyrinth *labyrinth, FILE *file) {
+   Bitset *bitset = labyrinth->bitset;
+   return (fwrite(bitset->table, sizeof(uint64_t), bitset->words, file) == bitset->words);
+}
+
+bool loadWalls(Labyrinth *labyrinth, FILE *file) {
+   Bitset *bitset = labyrinth->bitset;
+   if (fread(bitset->table, sizeof(uint64_t), bitset->words, file) != bitset->words)
+      return false;
+
+   // Bity za ostatnią pozycją nie opisują żadnego pola, więc pozostają wyzerowane
+   // niezależnie od zawartości pliku.
+   size_t last = bitset->words - 1;
+   bitsetAndWord(bitset, last, ~bitsetMaskFrom(bitset->size - last * BITSET_WORD_BITS));
+   return true;
 }
 
 void freeLabyrinth(Labyrinth *labyrinth) {
@@ -23,11 +23,26 @@ size_t getNumberOfDimensions(Labyrinth *labyrinth);
 // Funkcja zwraca rozmiar labiryntu.
 size_t getLabyrinthSize(Labyrinth *labyrinth);
 
+// Funkcja zwraca bitset ścian (razem z odwiedzonymi już pozycjami).
+// Operacje na nim są zdefiniowane w "bitset.h" i rozwijane w miejscu wywołania.
+struct Bitset *getWalls(Labyrinth *labyrinth);
+
 // Funkcja sprawdza, czy w danej pozycji jest ściana.
 bool checkWall(Labyrinth *labyrinth, size_t position);
 
-// Funkcja ustawia ścianę w danej pozycji.
-void setWall(Labyrinth *labyrinth, size_t position);
+// Funkcja zwraca skrót zbioru ścian (razem z odwiedzonymi już pozycjami).
+uint64_t hashWalls(Labyrinth *labyrinth);
+
+// Funkcja zwraca liczbę bajtów zajmowanych przez zbiór ścian.
+size_t getWallsSize(Labyrinth *labyrinth);
+
+// Funkcja zapisuje do pliku zbiór ścian (razem z odwiedzonymi już pozycjami).
+// Zwraca "true", jeżeli się to udało i "false" w przeciwnym razie.
+bool saveWalls(Labyrinth *labyrinth, FILE *file);
+
+// Funkcja wczytuje z pliku zbiór ścian zapisany przez "saveWalls".
+// Zwraca "true", jeżeli się to udało i "false" w przeciwnym razie.
+bool loadWalls(Labyrinth *labyrinth, FILE *file);
 
 // Funkcja zwalnia pamięć.
 void freeLabyrinth(Labyrinth *labyrinth);
@@ -1,5 +1,60 @@
 #!/bin/bash
 
+# Użycie:
+#   ./test.sh prog dir
+#      Tryb poprawnościowy: każdy test uruchamiany jest pod valgrindem.
+#   ./test.sh --perf [-n powtórzenia] [-t próg%] [-s zapas_ms] [-r zapas_kB]
+#                [-b plik_bazowy | -c prog_wzorcowy] [-u] prog dir
+#      Tryb wydajnościowy: każdy test uruchamiany jest natywnie kilka razy
+#      (po jednym uruchomieniu rozgrzewającym), mierzona jest mediana czasu
+#      działania i maksymalne zużycie pamięci (RSS), a wyniki porównywane są
+#      z plikiem bazowym. Regresją jest przekroczenie wartości bazowej o więcej
+#      niż próg procentowy powiększony o zapas bezwzględny. Opcja -u zapisuje
+#      zmierzone wartości jako nowy plik bazowy (domyślnie dir/perf.baseline).
+#      Pamięć mierzy /usr/bin/time, a gdy go nie ma - program rusage
+#      budowany przez make (getrusage).
+#      Czasy zależą od komputera, więc plik bazowy nie jest częścią
+#      repozytorium - trzeba go wygenerować na tym samym komputerze, na którym
+#      wykonywane są porównania, np. dla testów z katalogu perf:
+#         make
+#         ./test.sh --perf -u labyrinth perf   # przed zmianą
+#         ./test.sh --perf labyrinth perf      # po zmianie
+#      Opcja -c zamiast pliku bazowego uruchamia na przemian z badanym
+#      programem program wzorcowy (np. zbudowany z poprzedniej wersji kodu)
+#      i porównuje wyniki obu. Zmiany obciążenia komputera w czasie pomiaru
+#      dotyczą wtedy obu programów, więc jest to najpewniejszy sposób
+#      porównywania na zaszumionym komputerze:
+#         ./test.sh --perf -c labyrinth.old labyrinth perf
+
+PERF=0
+RUNS=5
+THRESHOLD=10
+TIME_SLACK=5
+RSS_SLACK=1024
+BASELINE=""
+REFERENCE=""
+UPDATE=0
+
+if [ "$1" == "--perf" ]
+then
+   PERF=1
+   shift
+   while getopts "n:t:s:r:b:c:u" opt
+   do
+      case $opt in
+         n) RUNS=$OPTARG ;;
+         t) THRESHOLD=$OPTARG ;;
+         s) TIME_SLACK=$OPTARG ;;
+         r) RSS_SLACK=$OPTARG ;;
+         b) BASELINE=$OPTARG ;;
+         c) REFERENCE=$OPTARG ;;
+         u) UPDATE=1 ;;
+         *) echo "Niewłaściwy parametr!"; exit 1 ;;
+      esac
+   done
+   shift $((OPTIND - 1))
+fi
+
 if (($# != 2))
 then
   echo "Niewłaściwa ilość parametrów!"
@@ -21,10 +76,177 @@ then
    exit 1
 fi
 
+if [ -n "$REFERENCE" ] && [ ! -e $REFERENCE ]
+then
+   echo "Podany program wzorcowy nie istnieje!"
+   exit 1
+fi
+
 ERRORS=0
 VALGRIND_ERRORS=0
 TESTS=0
 
+# Program mierzący pamięć, gdy nie ma /usr/bin/time.
+RUSAGE="$(dirname "$0")/rusage"
+
+# Funkcja uruchamia program $1 na teście $2 i wypisuje czas działania w
+# milisekundach (z dokładnością do mikrosekund) oraz maksymalne zużycie pamięci
+# w kilobajtach ("-", jeżeli nie da się go zmierzyć).
+measure() {
+   local start=$(date +%s%N)
+   if [ -x /usr/bin/time ]
+   then
+      /usr/bin/time -f "%M" -o temp.time ./$1 <$2 1>test.out 2>test.err
+   elif [ -x "$RUSAGE" ]
+   then
+      "$RUSAGE" temp.time ./$1 <$2 1>test.out 2>test.err
+   else
+      ./$1 <$2 1>test.out 2>test.err
+   fi
+   local end=$(date +%s%N)
+   local time=$(awk -v n="$((end - start))" 'BEGIN { printf "%.3f", n / 1000000 }')
+
+   # Przy niezerowym kodzie wyjścia time dopisuje najpierw komunikat o nim,
+   # więc wynik znajduje się w ostatnim wierszu.
+   if [ -f temp.time ]
+   then
+      echo "$time $(tail -n1 temp.time)"
+      rm temp.time
+   else
+      echo "$time -"
+   fi
+}
+
+# Funkcja wypisuje medianę liczb podanych na standardowym wejściu.
+median() {
+   sort -n | awk '{ a[NR] = $1 } END { print a[int((NR + 1) / 2)] }'
+}
+
+# Funkcja wypisuje większą z wartości $1 i $2 ("-" oznacza brak wartości).
+maximum() {
+   if [ "$2" != "-" ] && { [ "$1" == "-" ] || (($2 > $1)); }
+   then
+      echo "$2"
+   else
+      echo "$1"
+   fi
+}
+
+# Funkcja sprawdza, czy wartość $1 przekracza wartość bazową $2 o więcej niż
+# THRESHOLD procent i dodatkowo o więcej niż zapas bezwzględny $3 - dzięki
+# temu krótkie testy nie zgłaszają regresji z powodu szumu pomiaru.
+regressed() {
+   [ "$1" != "-" ] && [ "$2" != "-" ] \
+      && awk -v v="$1" -v b="$2" -v t="$THRESHOLD" -v s="$3" \
+            'BEGIN { exit !(v > b * (100 + t) / 100 + s) }'
+}
+
+if ((PERF == 1))
+then
+   if [ -z "$BASELINE" ]
+   then
+      BASELINE="$DIR/perf.baseline"
+   fi
+   if [ ! -x /usr/bin/time ] && [ ! -x "$RUSAGE" ]
+   then
+      echo $'Brak /usr/bin/time i programu rusage (make) - pamięć nie będzie mierzona.\n'
+   fi
+   if [ -z "$REFERENCE" ] && [ ! -f "$BASELINE" ] && ((UPDATE == 0))
+   then
+      echo "Brak pliku bazowego $BASELINE - wyniki nie będą porównywane."
+      echo $'Należy go wygenerować na tym komputerze opcją -u.\n'
+   fi
+
+   REGRESSIONS=0
+   NEW_BASELINE=$(mktemp)
+
+   for f in "$DIR/"*.in
+   do
+      ((TESTS++))
+      NAME=$(basename "$f")
+      TIMES=""
+      RSS="-"
+      REF_TIMES=""
+      REF_RSS="-"
+
+      # Pierwsze uruchomienie wczytuje programy i test do pamięci podręcznej.
+      if [ -n "$REFERENCE" ]
+      then
+         measure "$REFERENCE" "$f" >/dev/null
+      fi
+      measure "$PROG" "$f" >/dev/null
+
+      # Badany program jest uruchamiany jako drugi, więc na końcu pętli
+      # test.out i test.err zawierają jego odpowiedź.
+      for ((i = 0; i < RUNS; i++))
+      do
+         if [ -n "$REFERENCE" ]
+         then
+            read T M < <(measure "$REFERENCE" "$f")
+            REF_TIMES+="$T"$'\n'
+            REF_RSS=$(maximum "$REF_RSS" "$M")
+         fi
+         read T M < <(measure "$PROG" "$f")
+         TIMES+="$T"$'\n'
+         RSS=$(maximum "$RSS" "$M")
+      done
+      TIME=$(echo -n "$TIMES" | median)
+
+      # Sprawdzenie poprawności odpowiedzi z ostatniego uruchomienia.
+      if ! diff "${f%in}out" "test.out" >/dev/null 2>&1 \
+         || ! diff "${f%in}err" "test.err" >/dev/null 2>&1
+      then
+         ((ERRORS++))
+         STATUS="błędna odpowiedź"
+      else
+         STATUS="OK"
+      fi
+      rm test.out test.err
+
+      echo "$NAME $TIME $RSS" >>"$NEW_BASELINE"
+
+      if [ -n "$REFERENCE" ]
+      then
+         BASE="$(echo -n "$REF_TIMES" | median) $REF_RSS"
+      else
+         BASE=$(awk -v n="$NAME" '$1 == n { print $2, $3 }' "$BASELINE" 2>/dev/null)
+      fi
+      if [ -z "$BASE" ]
+      then
+         echo "Test $f: ${TIME} ms, ${RSS} kB (brak w pliku bazowym), $STATUS."
+         continue
+      fi
+
+      read BASE_TIME BASE_RSS <<<"$BASE"
+      if regressed "$TIME" "$BASE_TIME" "$TIME_SLACK" \
+         || regressed "$RSS" "$BASE_RSS" "$RSS_SLACK"
+      then
+         ((REGRESSIONS++))
+         STATUS="REGRESJA, $STATUS"
+      fi
+      echo "Test $f: ${TIME} ms (bazowo ${BASE_TIME} ms)," \
+           "${RSS} kB (bazowo ${BASE_RSS} kB), $STATUS."
+   done
+
+   if ((UPDATE == 1))
+   then
+      mv "$NEW_BASELINE" "$BASELINE"
+      echo "Zapisano plik bazowy $BASELINE."
+   else
+      rm "$NEW_BASELINE"
+   fi
+
+   echo "Liczba testów: $TESTS."
+   echo "Liczba błędnych odpowiedzi: $ERRORS."
+   echo "Liczba regresji (próg $THRESHOLD%, zapas $TIME_SLACK ms i $RSS_SLACK kB): $REGRESSIONS."
+
+   if ((REGRESSIONS > 0 || ERRORS > 0))
+   then
+      exit 1
+   fi
+   exit 0
+fi
+
 for f in "$DIR/"*.in 
 do 
    ((TESTS++))
@@ -0,0 +1,73 @@
+#!/bin/bash
+
+# Użycie:
+#   ./walls_bench.sh [-n powtórzenia] [-r liczba_wyrazów] prog [liczby_wątków...]
+#      Benchmark skalowania budowania ścian: dla każdej liczby wątków
+#      (domyślnie 1 2 4 8) program budujący ściany z opisu z "R" uruchamiany
+#      jest kilka razy na labiryncie 1000 x 1000 x 100 i wypisywany jest
+#      najkrótszy czas budowania ścian zgłoszony przez opcję -s oraz
+#      przyspieszenie względem pierwszej liczby wątków.
+#         ./walls_bench.sh labyrinth 1 2 4 8
+
+RUNS=3
+TERMS=33554432
+
+while getopts "n:r:" opt
+do
+   case $opt in
+      n) RUNS=$OPTARG ;;
+      r) TERMS=$OPTARG ;;
+      *) echo "Niewłaściwy parametr!"; exit 1 ;;
+   esac
+done
+shift $((OPTIND - 1))
+
+if (($# < 1))
+then
+   echo "Niewłaściwa ilość parametrów!"
+   exit 1
+fi
+
+PROG=$1
+shift
+THREADS=${@:-1 2 4 8}
+
+if [ ! -e $PROG ]
+then
+   echo "Podany program nie istnieje!"
+   exit 1
+fi
+
+# Pole (1, 1, 1) nie jest ścianą dla tych parametrów ciągu, więc
+# przeszukiwanie kończy się od razu, a mierzone jest tylko budowanie ścian.
+INPUT=$(mktemp)
+printf "1000 1000 100\n1 1 1\n1 1 1\nR 1103515245 12345 2147483648 %s 2\n" "$TERMS" >"$INPUT"
+
+BASE=""
+for t in $THREADS
+do
+   BEST=""
+   for ((i = 0; i < RUNS; i++))
+   do
+      T=$(./$PROG -s -t "$t" <"$INPUT" 2>&1 >/dev/null \
+          | awk '/^Wall build time:/ { print $4 }')
+      if [ -z "$T" ]
+      then
+         echo "Program nie wypisał czasu budowania ścian!"
+         rm "$INPUT"
+         exit 1
+      fi
+      if [ -z "$BEST" ] || awk -v a="$T" -v b="$BEST" 'BEGIN { exit !(a < b) }'
+      then
+         BEST=$T
+      fi
+   done
+   if [ -z "$BASE" ]
+   then
+      BASE=$BEST
+   fi
+   awk -v t="$t" -v v="$BEST" -v b="$BASE" \
+       'BEGIN { printf "Wątki: %3d, czas: %.6f s, przyspieszenie: %.2f\n", t, v, b / v }'
+done
+
+rm "$INPUT"
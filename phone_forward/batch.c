@@ -0,0 +1,184 @@
+/** @file
+ * Implementacja wyznaczania przekierowań wielu numerów.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "phone_forward.h"
+#include "trie.h"
+#include "frozen.h"
+
+/** @struct BatchItem
+ * To jest struktura opisująca numer przetwarzany przez @ref phfwdGetBatch.
+ */
+typedef struct BatchItem {
+   char const *number; ///< Wskaźnik na numer.
+   size_t length;      ///< Długość numeru.
+   size_t index;       ///< Indeks numeru w tablicy wejściowej.
+} BatchItem;
+
+/** @struct BatchStep
+ * To jest struktura opisująca stan przejścia po drzewie po przeczytaniu
+ * określonej liczby cyfr numeru.
+ */
+typedef struct BatchStep {
+   Node const *node;      ///< Osiągnięty wierzchołek (NULL - ścieżka się urwała).
+   Target const *forward; ///< Najgłębsze przekierowanie na ścieżce (lub NULL).
+   size_t forwardDepth;   ///< Głębokość tego przekierowania.
+} BatchStep;
+
+/** @brief Porównuje dwa numery przetwarzane przez @ref phfwdGetBatch.
+ * Do zgrupowania numerów o wspólnych prefiksach wystarcza dowolny porządek
+ * leksykograficzny, dlatego porównujemy kody znaków.
+ * @param[in] item1 - wskaźnik na pierwszy numer.
+ * @param[in] item2 - wskaźnik na drugi numer.
+ * @return Wynik funkcji strcmp dla numerów.
+ */
+static int batchItemComparator(void const *item1, void const *item2) {
+   return strcmp(((BatchItem const *)item1)->number, 
+                 ((BatchItem const *)item2)->number);
+}
+
+/** @brief Wyznacza długość najdłuższego wspólnego prefiksu numerów.
+ * @param[in] item1 - wskaźnik na pierwszy numer.
+ * @param[in] item2 - wskaźnik na drugi numer.
+ * @return Długość najdłuższego wspólnego prefiksu.
+ */
+static size_t commonPrefix(BatchItem const *item1, BatchItem const *item2) {
+   size_t length = 0;
+   while (length < item1->length && length < item2->length
+          && (item1->number)[length] == (item2->number)[length])
+      length++;
+   return length;
+}
+
+/** @brief Wyznacza przekierowania wielu numerów w postaci zamrożonej.
+ * @param[in] frozen   - wskaźnik na postać zamrożoną.
+ * @param[in,out] pnum - wskaźnik na strukturę, w której zapisywane są wyniki.
+ * @param[in] items    - tablica numerów.
+ * @param[in] count    - liczba numerów.
+ * @return Wartość @p true, jeśli działanie funkcji przebiegło pomyślnie.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool frozenBatch(Frozen const *frozen, PhoneNumbers *pnum,
+                        BatchItem const *items, size_t const count) {
+   for (size_t k = 0; k < count; k++) {
+      size_t longest;
+      FlatTarget const *target = frozenLookup(frozen, items[k].number, &longest);
+      char const *prefix = (target != NULL ? frozen->chars + target->offset : NULL);
+      size_t const prefixLength = (target != NULL ? target->length : 0);
+      if (!phnumWrite(pnum, prefix, prefixLength, items[k].number + longest,
+                      items[k].length - longest, &((pnum->numbers)[items[k].index])))
+         return false;
+   }
+   return true;
+}
+
+PhoneNumbers * phfwdGetBatch(PhoneForward const *pf, char const * const *nums, 
+                             size_t const count) {
+   if (pf == NULL || (nums == NULL && count > 0))
+      return NULL;
+
+   PhoneNumbers *pnum = phnumCreate();
+   if (pnum == NULL || count == 0)
+      return pnum;
+
+   BatchItem *items = malloc(count * sizeof(BatchItem));
+   if (items == NULL 
+       || !reserveArray((void**)&(pnum->numbers), &(pnum->size), count, sizeof(NumberRef))) {
+      free(items);
+      phnumDelete(pnum);
+      return NULL;
+   }
+
+   size_t valid = 0;
+   size_t maxLength = 0;
+   for (size_t i = 0; i < count; i++) {
+      size_t const length = numberLength(nums[i]);
+      (pnum->numbers)[i].offset = NO_NUMBER;
+      if (length > 0) {
+         items[valid].number = nums[i];
+         items[valid].length = length;
+         items[valid].index = i;
+         valid++;
+      }
+      if (length > maxLength)
+         maxLength = length;
+   }
+   pnum->count = count;
+
+   if (pf->frozen != NULL) {
+      bool const success = frozenBatch(pf->frozen, pnum, items, valid);
+      free(items);
+      if (success)
+         return pnum;
+      phnumDelete(pnum);
+      return NULL;
+   }
+
+   BatchStep *steps = malloc((maxLength + 1) * sizeof(BatchStep));
+   if (steps == NULL) {
+      free(items);
+      phnumDelete(pnum);
+      return NULL;
+   }
+
+   // Po posortowaniu kolejny numer zaczyna przejście od miejsca, w którym
+   // jego ścieżka odchodzi od ścieżki poprzedniego numeru.
+   qsort(items, valid, sizeof(BatchItem), batchItemComparator);
+   size_t slot;
+   Version const *version = beginRead(pf, &slot);
+   steps[0].node = version->node;
+   steps[0].forward = NULL;
+   steps[0].forwardDepth = 0;
+   size_t reached = 0; // Liczba cyfr, dla których stan w steps jest aktualny.
+   bool success = true;
+
+   for (size_t k = 0; k < valid && success; k++) {
+      BatchItem const *item = &(items[k]);
+      size_t depth = (k == 0 ? 0 : commonPrefix(&(items[k - 1]), item));
+      if (depth > reached)
+         depth = reached;
+
+      // Wierzchołek, od którego zacznie następny numer, może być już znany -
+      // wtedy pobieramy jego syna, zanim zaczniemy przechodzić bieżący numer.
+      if (k + 1 < valid) {
+         size_t const next = commonPrefix(item, &(items[k + 1]));
+         if (next <= depth && next < items[k + 1].length && steps[next].node != NULL)
+            PREFETCH(getChild(steps[next].node, digitID((items[k + 1].number)[next])));
+      }
+
+      while (depth < item->length && steps[depth].node != NULL) {
+         Node const *child = getChild(steps[depth].node, digitID((item->number)[depth]));
+         steps[depth + 1].node = child;
+         if (child != NULL && child->forward != NULL) {
+            steps[depth + 1].forward = child->forward;
+            steps[depth + 1].forwardDepth = depth + 1;
+         }
+         else {
+            steps[depth + 1].forward = steps[depth].forward;
+            steps[depth + 1].forwardDepth = steps[depth].forwardDepth;
+         }
+         depth++;
+      }
+      reached = depth;
+
+      BatchStep const *step = &(steps[depth]);
+      success = phnumWriteForward(pnum, step->forward, item->number + step->forwardDepth,
+                                  item->length - step->forwardDepth,
+                                  &((pnum->numbers)[item->index]));
+   }
+   endRead(pf, slot);
+
+   free(steps);
+   free(items);
+   if (!success) {
+      phnumDelete(pnum);
+      return NULL;
+   }
+   return pnum;
+}
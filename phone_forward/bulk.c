@@ -0,0 +1,570 @@
+/** @file
+ * Implementacja dodawania wielu przekierowań naraz.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "phone_forward.h"
+#include "trie.h"
+
+/** Liczba początkowych znaków klucza upakowanych w polu @p prefix struktury
+ * @ref BulkKey - po 4 bity na znak.
+ */
+#define PACKED_DIGITS 16
+
+/** @struct BulkKey
+ * To jest struktura opisująca klucz wstawiany przez @ref phfwdAddBulk.
+ * W drzewie przekierowań kluczem jest numer przekierowywany, a w indeksie
+ * odwrotnym - numer docelowy, separator i numer przekierowywany.
+ */
+typedef struct BulkKey {
+   PhoneForwardPair const *pair; ///< Przekierowanie.
+   size_t sourceLength;          ///< Długość numeru przekierowywanego.
+   size_t targetLength;          ///< Długość numeru docelowego.
+   uint64_t prefix;              ///< Początek klucza indeksu odwrotnego.
+   size_t shared;                ///< Długość wspólnego prefiksu z poprzednim kluczem.
+} BulkKey;
+
+/** @struct BulkScratch
+ * To jest struktura przechowująca tablice pomocnicze @ref phfwdAddBulk.
+ * Każda z nich ma po jednym elemencie (lub grupie elementów) na każdą
+ * głębokość wierzchołka, jaka może wystąpić w drzewach.
+ */
+typedef struct BulkScratch {
+   Node ***path;           ///< Miejsca wierzchołków na ścieżce poprzedniego klucza.
+   Node **levels;          ///< Gotowi synowie, po @ref NUMBER_OF_SYMBOLS na głębokość.
+   int *counts;            ///< Liczby zbudowanych synów na kolejnych głębokościach.
+   BulkKey const **ending; ///< Klucze kończące się w budowanych wierzchołkach.
+} BulkScratch;
+
+/** @brief Wyznacza długość klucza.
+ * @param[in] key     - wskaźnik na klucz.
+ * @param[in] reverse - czy jest to klucz indeksu odwrotnego.
+ * @return Długość klucza.
+ */
+static inline size_t keyLength(BulkKey const *key, bool const reverse) {
+   return (reverse ? key->targetLength + 1 + key->sourceLength : key->sourceLength);
+}
+
+/** @brief Zwraca znak klucza.
+ * @param[in] key      - wskaźnik na klucz.
+ * @param[in] reverse  - czy jest to klucz indeksu odwrotnego.
+ * @param[in] position - pozycja znaku, mniejsza od długości klucza.
+ * @return Znak klucza na pozycji @p position.
+ */
+static inline char keyDigit(BulkKey const *key, bool const reverse, size_t const position) {
+   if (!reverse)
+      return (key->pair->num1)[position];
+   if (position < key->targetLength)
+      return (key->pair->num2)[position];
+   if (position == key->targetLength)
+      return SEPARATOR;
+   return (key->pair->num1)[position - key->targetLength - 1];
+}
+
+/** @brief Wyznacza długości wspólnych prefiksów kolejnych kluczy.
+ * Klucze indeksu odwrotnego mają upakowane początki, więc zwykle wystarcza
+ * porównać liczby.
+ * @param[in,out] keys - tablica kluczy.
+ * @param[in] count    - liczba kluczy.
+ * @param[in] reverse  - czy są to klucze indeksu odwrotnego.
+ */
+static void markShared(BulkKey *keys, size_t const count, bool const reverse) {
+   for (size_t i = 0; i < count; i++) {
+      size_t length = 0;
+      if (i == 0) {
+         keys[i].shared = 0;
+         continue;
+      }
+
+      BulkKey const *previous = &(keys[i - 1]), *key = &(keys[i]);
+      if (reverse) {
+         uint64_t const difference = previous->prefix ^ key->prefix;
+         while (length < PACKED_DIGITS && (difference >> (60 - 4 * length)) == 0)
+            length++;
+         if (length < PACKED_DIGITS) {
+            keys[i].shared = length;
+            continue;
+         }
+      }
+
+      size_t const length1 = keyLength(previous, reverse), length2 = keyLength(key, reverse);
+      if (length > length1)
+         length = length1;
+      while (length < length1 && length < length2
+             && keyDigit(previous, reverse, length) == keyDigit(key, reverse, length))
+         length++;
+      keys[i].shared = length;
+   }
+}
+
+/** @brief Pakuje początek klucza indeksu odwrotnego.
+ * Znak jest zapisywany jako identyfikator powiększony o 1, a brak znaku -
+ * jako 0, dzięki czemu porządek liczb zgadza się z porządkiem kluczy.
+ * @param[in] key - wskaźnik na klucz.
+ * @return Pierwsze @ref PACKED_DIGITS znaków klucza, po 4 bity na znak.
+ */
+static uint64_t packPrefix(BulkKey const *key) {
+   size_t const length = keyLength(key, true);
+   uint64_t prefix = 0;
+   for (size_t i = 0; i < PACKED_DIGITS; i++) {
+      prefix <<= 4;
+      if (i < length)
+         prefix |= (uint64_t)(digitID(keyDigit(key, true, i)) + 1);
+   }
+   return prefix;
+}
+
+/** @brief Porównuje klucze indeksu odwrotnego.
+ * Zwykle wystarcza porównanie upakowanych początków, więc sortowanie rzadko
+ * sięga do numerów.
+ * @param[in] key1 - wskaźnik na pierwszy klucz.
+ * @param[in] key2 - wskaźnik na drugi klucz.
+ * @return Wartość ujemna, zero lub dodatnia, jeśli pierwszy klucz jest
+ *         odpowiednio mniejszy, równy lub większy od drugiego.
+ */
+static int bulkKeyComparator(void const *key1, void const *key2) {
+   BulkKey const *first = key1, *second = key2;
+   if (first->prefix != second->prefix)
+      return (first->prefix < second->prefix ? -1 : 1);
+
+   size_t const length1 = keyLength(first, true), length2 = keyLength(second, true);
+   for (size_t i = PACKED_DIGITS; i < length1 && i < length2; i++) {
+      int const id1 = digitID(keyDigit(first, true, i));
+      int const id2 = digitID(keyDigit(second, true, i));
+      if (id1 != id2)
+         return (id1 < id2 ? -1 : 1);
+   }
+   return (length1 > length2) - (length1 < length2);
+}
+
+/** @brief Sortuje klucze indeksu odwrotnego.
+ * Sortuje pozycyjnie według upakowanych początków, od najmniej znaczącego
+ * bajtu, pomijając bajty równe we wszystkich kluczach. Klucze o równych
+ * początkach są potem porządkowane przez @ref bulkKeyComparator.
+ * @param[in,out] keys - tablica kluczy.
+ * @param[in] count    - liczba kluczy.
+ * @return Wartość @p true, jeśli klucze zostały posortowane.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool sortKeys(BulkKey *keys, size_t const count) {
+   if (count < 2)
+      return true;
+   BulkKey *buffer = malloc(count * sizeof(BulkKey));
+   if (buffer == NULL)
+      return false;
+
+   BulkKey *from = keys, *to = buffer;
+   for (int shift = 0; shift < 64; shift += 8) {
+      size_t counts[256] = {0};
+      for (size_t i = 0; i < count; i++)
+         counts[(from[i].prefix >> shift) & 0xFF]++;
+      if (counts[(from[0].prefix >> shift) & 0xFF] == count)
+         continue;
+
+      size_t position = 0;
+      for (int digit = 0; digit < 256; digit++) {
+         size_t const size = counts[digit];
+         counts[digit] = position;
+         position += size;
+      }
+      for (size_t i = 0; i < count; i++)
+         to[counts[(from[i].prefix >> shift) & 0xFF]++] = from[i];
+      BulkKey *swap = from;
+      from = to;
+      to = swap;
+   }
+   if (from != keys)
+      memcpy(keys, from, count * sizeof(BulkKey));
+   free(buffer);
+
+   for (size_t begin = 0, end; begin < count; begin = end) {
+      end = begin + 1;
+      while (end < count && keys[end].prefix == keys[begin].prefix)
+         end++;
+      if (end - begin > 1)
+         qsort(keys + begin, end - begin, sizeof(BulkKey), bulkKeyComparator);
+   }
+   return true;
+}
+
+/** @brief Wybiera przekierowania, które nie są zastępowane przez kolejne.
+ * Przekierowania o tym samym numerze przekierowywanym leżą obok siebie,
+ * więc z każdej takiej grupy wybierane jest ostatnie.
+ * @param[out] keys  - tablica, w której zapisywane są klucze wybranych
+ *                     przekierowań.
+ * @param[in] pairs  - tablica przekierowań posortowana według numerów
+ *                     przekierowywanych.
+ * @param[in] count  - liczba przekierowań.
+ * @return Liczba wybranych przekierowań.
+ */
+static size_t lastWrites(BulkKey *keys, PhoneForwardPair const *pairs, size_t const count) {
+   size_t chosen = 0;
+   for (size_t i = 0; i < count; i++) {
+      if (i + 1 < count && strcmp(pairs[i].num1, pairs[i + 1].num1) == 0)
+         continue;
+      keys[chosen].pair = &(pairs[i]);
+      keys[chosen].sourceLength = strlen(pairs[i].num1);
+      keys[chosen].targetLength = strlen(pairs[i].num2);
+      keys[chosen].prefix = 0;
+      keys[chosen].shared = 0;
+      chosen++;
+   }
+   return chosen;
+}
+
+/** @brief Zapisuje klucz w wierzchołku, w którym się kończy.
+ * W drzewie przekierowań zastępuje przekierowanie wierzchołka i usuwa
+ * z indeksu odwrotnego parę odpowiadającą poprzedniemu.
+ * @param[in,out] pf   - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in,out] node - wskaźnik na wierzchołek udostępniony do zmiany.
+ * @param[in] key      - wskaźnik na klucz.
+ * @param[in] reverse  - czy jest to klucz indeksu odwrotnego.
+ * @return Wartość @p true, jeśli klucz został zapisany.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool endKey(PhoneForward *pf, Node *node, BulkKey const *key, bool const reverse) {
+   if (reverse) {
+      node->isSource = true;
+      return true;
+   }
+
+   Target *forward = internAcquire(pf->targets, key->pair->num2, key->targetLength);
+   if (forward == NULL)
+      return false;
+   if (node->forward == forward) { // Takie przekierowanie już istnieje.
+      internRelease(pf->targets, forward);
+      return true;
+   }
+   if (node->forward != NULL && !reserveRetired(pf, 1)) {
+      internRelease(pf->targets, forward);
+      return false;
+   }
+   if (node->forward != NULL) {
+      reverseEraseForward(pf, node->forward, key->pair->num1, key->sourceLength);
+      releaseTarget(pf, node->forward);
+   }
+   else {
+      countForward(pf, key->sourceLength, true);
+   }
+   node->forward = forward;
+   return true;
+}
+
+/** @brief Tworzy wierzchołek, którego wszyscy synowie są już zbudowani.
+ * @param[in,out] pf  - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] digit   - cyfra reprezentująca wierzchołek.
+ * @param[in] subtrees - tablica synów.
+ * @param[in] count   - liczba synów.
+ * @param[in] ending  - wskaźnik na klucz kończący się w wierzchołku lub NULL.
+ * @param[in] reverse - czy wierzchołek należy do indeksu odwrotnego.
+ * @return Wskaźnik na utworzony wierzchołek lub NULL, gdy nie udało się
+ *         alokować pamięci (synowie nie są wtedy zwalniani).
+ */
+static Node * closeNode(PhoneForward *pf, char const digit, Node * const *subtrees,
+                        int const count, BulkKey const *ending, bool const reverse) {
+   Node *node = allocNode(pf, count);
+   if (node == NULL)
+      return NULL;
+
+   node->forward = NULL;
+   node->generation = pf->generation;
+   node->children = 0;
+   node->digit = digit;
+   node->isSource = false;
+   for (int i = 0; i < count; i++)
+      node->children |= (uint16_t)(1u << digitID(subtrees[i]->digit));
+   for (int i = 0; i < count; i++)
+      (node->subtrees)[childPosition(node, digitID(subtrees[i]->digit))] = subtrees[i];
+
+   if (ending != NULL && !endKey(pf, node, ending, reverse)) {
+      freeNode(pf, node, count);
+      return NULL;
+   }
+   return node;
+}
+
+/** @brief Odejmuje od liczników przekierowania przechowywane w poddrzewie.
+ * Wywoływana przed usunięciem zbudowanego poddrzewa, które nie zostało
+ * dołączone do drzewa.
+ * @param[in,out] pf  - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] subtree - wskaźnik na korzeń poddrzewa.
+ * @param[in] depth   - głębokość korzenia poddrzewa.
+ */
+static void uncountSubtree(PhoneForward *pf, Node const *subtree, size_t const depth) {
+   Node const **stack = (Node const **)(pf->stack);
+   size_t top = 0;
+   stack[0] = subtree;
+   int startingSubtreeID = 0;
+
+   while (true) {
+      Node const *node = stack[top];
+      if (startingSubtreeID == 0 && node->forward != NULL)
+         countForward(pf, depth + top, false);
+
+      int const subtreeID = nextChild(node, startingSubtreeID);
+      if (subtreeID < NUMBER_OF_SYMBOLS) {
+         stack[++top] = getChild(node, subtreeID);
+         startingSubtreeID = 0;
+      }
+      else if (top == 0) {
+         break;
+      }
+      else {
+         startingSubtreeID = digitID(node->digit) + 1;
+         top--;
+      }
+   }
+}
+
+/** @brief Buduje nowe poddrzewo z posortowanych kluczy.
+ * Wierzchołek jest tworzony dopiero wtedy, gdy kolejne klucze już do niego
+ * nie prowadzą, więc znane są wszyscy jego synowie i każdy wierzchołek jest
+ * alokowany raz, od razu w docelowym rozmiarze.
+ * @param[in,out] pf      - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] keys        - tablica kluczy, które mają wspólny prefiks
+ *                          długości @p depth + 1.
+ * @param[in] count       - liczba kluczy.
+ * @param[in] depth       - głębokość ojca korzenia poddrzewa.
+ * @param[in] maxLength   - długość najdłuższego klucza w drzewie.
+ * @param[in] reverse     - czy są to klucze indeksu odwrotnego.
+ * @param[in,out] scratch - wskaźnik na tablice pomocnicze.
+ * @return Wskaźnik na korzeń poddrzewa lub NULL, gdy nie udało się alokować
+ *         pamięci (zbudowane wierzchołki są wtedy usuwane).
+ */
+static Node * buildSubtree(PhoneForward *pf, BulkKey const *keys, size_t const count,
+                           size_t const depth, size_t const maxLength, bool const reverse,
+                           BulkScratch *scratch) {
+   Node **levels = scratch->levels;
+   int *counts = scratch->counts;
+   bool success = true;
+   for (size_t i = 0; i < count && success; i++) {
+      BulkKey const *key = &(keys[i]);
+      size_t const length = keyLength(key, reverse);
+      size_t const next = (i + 1 < count ? keys[i + 1].shared : depth);
+      (scratch->ending)[length] = key;
+
+      // Wierzchołki głębsze niż wspólny prefiks z następnym kluczem są gotowe.
+      for (size_t level = length; level > next; level--) {
+         Node *node = closeNode(pf, keyDigit(key, reverse, level - 1),
+                                levels + (level + 1) * NUMBER_OF_SYMBOLS,
+                                counts[level + 1], (scratch->ending)[level], reverse);
+         if (node == NULL) {
+            success = false;
+            break;
+         }
+         counts[level + 1] = 0;
+         (scratch->ending)[level] = NULL;
+         levels[level * NUMBER_OF_SYMBOLS + (size_t)(counts[level]++)] = node;
+      }
+   }
+
+   Node *root = levels[(depth + 1) * NUMBER_OF_SYMBOLS];
+   if (success) {
+      counts[depth + 1] = 0;
+      return root;
+   }
+
+   for (size_t level = depth + 1; level <= maxLength + 1; level++) {
+      for (int i = 0; i < counts[level]; i++) {
+         Node *node = levels[level * NUMBER_OF_SYMBOLS + (size_t)i];
+         if (!reverse)
+            uncountSubtree(pf, node, level);
+         deleteNode(pf, node, pf->stack);
+      }
+      counts[level] = 0;
+      (scratch->ending)[level] = NULL;
+   }
+   return NULL;
+}
+
+/** @brief Wstawia posortowane klucze do drzewa.
+ * Kolejny klucz jest wstawiany od końca wspólnego prefiksu z poprzednim,
+ * którego ścieżka jest pamiętana w @p scratch, a nie od korzenia. Klucze,
+ * które dochodzą do brakującego syna, tworzą nowe poddrzewo budowane
+ * w całości przez @ref buildSubtree.
+ * @param[in,out] pf      - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in,out] root    - wskaźnik na miejsce przechowywania korzenia drzewa.
+ * @param[in] keys        - tablica kluczy posortowana w kolejności cyfr.
+ * @param[in] count       - liczba kluczy.
+ * @param[in] maxLength   - długość najdłuższego klucza w drzewie.
+ * @param[in] reverse     - czy są to klucze indeksu odwrotnego.
+ * @param[in,out] scratch - wskaźnik na tablice pomocnicze.
+ * @return Liczba kluczy wstawionych przed niepowodzeniem alokacji pamięci
+ *         (@p count, jeśli wstawiono wszystkie).
+ */
+static size_t insertKeys(PhoneForward *pf, Node **root, BulkKey const *keys,
+                         size_t const count, size_t const maxLength, bool const reverse,
+                         BulkScratch *scratch) {
+   Node ***path = scratch->path;
+   size_t known = 0; // Długość zapamiętanej ścieżki poprzedniego klucza.
+   path[0] = root;
+   size_t i = 0;
+   while (i < count) {
+      BulkKey const *key = &(keys[i]);
+      size_t const length = keyLength(key, reverse);
+      size_t depth = (i == 0 ? 0 : key->shared);
+      if (depth > known)
+         depth = known;
+
+      Node **slot = path[depth];
+      Node *node;
+      while ((node = writableNode(pf, slot)) != NULL) {
+         path[depth] = slot;
+         if (depth == length)
+            break;
+         int const id = digitID(keyDigit(key, reverse, depth));
+         if (!(node->children & (1u << id)))
+            break;
+         slot = &((node->subtrees)[childPosition(node, id)]);
+         depth++;
+      }
+      if (node == NULL)
+         return i;
+      known = depth;
+
+      if (depth == length) {
+         if (!endKey(pf, node, key, reverse))
+            return i;
+         i++;
+         continue;
+      }
+
+      // Klucze o wspólnym prefiksie długości depth + 1 leżą obok siebie.
+      size_t end = i + 1;
+      while (end < count && keys[end].shared > depth)
+         end++;
+      Node *subtree = buildSubtree(pf, key, end - i, depth, maxLength, reverse, scratch);
+      if (subtree == NULL)
+         return i;
+      if (insertChild(pf, path[depth], subtree) == NULL) {
+         if (!reverse)
+            uncountSubtree(pf, subtree, depth + 1);
+         deleteNode(pf, subtree, pf->stack);
+         return i;
+      }
+      i = end;
+   }
+   return count;
+}
+
+/** @brief Usuwa z indeksu odwrotnego pary przekierowań nieobecnych w drzewie.
+ * Przywraca zgodność indeksu odwrotnego z drzewem przekierowań po
+ * niepowodzeniu alokacji w trakcie @ref addSorted.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] keys   - tablica kluczy przekierowań.
+ * @param[in] count  - liczba kluczy.
+ */
+static void undoReverse(PhoneForward *pf, BulkKey const *keys, size_t const count) {
+   for (size_t i = 0; i < count; i++) {
+      PhoneForwardPair const *pair = keys[i].pair;
+      Node const *node = findPath(pf->writing->node, pair->num1, keys[i].sourceLength);
+      Target const *forward = (node != NULL ? node->forward : NULL);
+      if (forward == NULL || !internEqual(forward, pair->num2, keys[i].targetLength))
+         reverseErase(pf, pair->num2, keys[i].targetLength,
+                      pair->num1, keys[i].sourceLength);
+   }
+}
+
+/** @brief Dodaje posortowane przekierowania w trwającej zmianie.
+ * Najpierw dodaje pary do indeksu odwrotnego w kolejności jego kluczy, potem
+ * przekierowania do drzewa w kolejności numerów przekierowywanych. W razie
+ * niepowodzenia alokacji część przekierowań może zostać dodana, ale indeks
+ * odwrotny pozostaje zgodny z drzewem.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] pairs  - tablica poprawnych przekierowań posortowana według
+ *                     numerów przekierowywanych.
+ * @param[in] count  - liczba przekierowań.
+ * @return Wartość @p true, jeśli przekierowania zostały dodane.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool addSorted(PhoneForward *pf, PhoneForwardPair const *pairs, size_t const count) {
+   size_t const maxLength = pf->maxTargetLength + 1 + pf->maxSourceLength;
+   BulkScratch scratch;
+   BulkKey *keys = malloc(count * sizeof(BulkKey));
+   scratch.path = malloc((maxLength + 1) * sizeof(Node**));
+   scratch.levels = malloc((maxLength + 2) * NUMBER_OF_SYMBOLS * sizeof(Node*));
+   scratch.counts = calloc(maxLength + 2, sizeof(int));
+   scratch.ending = calloc(maxLength + 2, sizeof(BulkKey const *));
+   bool success = (keys != NULL && scratch.path != NULL && scratch.levels != NULL
+                   && scratch.counts != NULL && scratch.ending != NULL);
+
+   size_t chosen = 0;
+   if (success) {
+      chosen = lastWrites(keys, pairs, count);
+      for (size_t i = 0; i < chosen; i++)
+         keys[i].prefix = packPrefix(&(keys[i]));
+      success = sortKeys(keys, chosen);
+   }
+   if (success) {
+      markShared(keys, chosen, true);
+      size_t const inserted = insertKeys(pf, &(pf->writing->reverse), keys, chosen,
+                                         maxLength, true, &scratch);
+      success = (inserted == chosen);
+      if (!success)
+         undoReverse(pf, keys, inserted);
+   }
+   if (success) {
+      lastWrites(keys, pairs, count);
+      markShared(keys, chosen, false);
+      size_t const added = insertKeys(pf, &(pf->writing->node), keys, chosen,
+                                      maxLength, false, &scratch);
+      success = (added == chosen);
+      if (!success)
+         undoReverse(pf, keys + added, chosen - added);
+   }
+
+   free(keys);
+   free(scratch.path);
+   free(scratch.levels);
+   free(scratch.counts);
+   free(scratch.ending);
+   return success;
+}
+
+bool phfwdAddBulk(PhoneForward *pf, PhoneForwardPair const *pairs, size_t const count) {
+   if (pf == NULL || (pairs == NULL && count > 0))
+      return false;
+
+   size_t maxSource = 0, maxTarget = 0;
+   bool sorted = true;
+   for (size_t i = 0; i < count; i++) {
+      size_t const sourceLength = numberLength(pairs[i].num1);
+      size_t const targetLength = numberLength(pairs[i].num2);
+      if (sourceLength == 0 || targetLength == 0
+          || strcmp(pairs[i].num1, pairs[i].num2) == 0)
+         return false;
+      if (sourceLength > maxSource)
+         maxSource = sourceLength;
+      if (targetLength > maxTarget)
+         maxTarget = targetLength;
+      if (i > 0 && numberComparator(pairs[i - 1].num1, pairs[i].num1) > 0)
+         sorted = false;
+   }
+   if (count == 0)
+      return true;
+
+   if (!beginChange(pf))
+      return false;
+   bool success = reserveBuffers(pf, maxSource, maxTarget);
+   if (success && sorted)
+      success = addSorted(pf, pairs, count);
+
+   // Nieposortowane przekierowania dodajemy po kolei.
+   for (size_t i = 0; i < count && success && !sorted; i++)
+      success = addForward(pf, pairs[i].num1, strlen(pairs[i].num1),
+                           pairs[i].num2, strlen(pairs[i].num2));
+
+   // Po niepowodzeniu nie wiadomo, które przekierowania zostały dodane.
+   for (size_t i = 0; i < count && success && pf->journal != NULL; i++)
+      journalAppend(pf->journal, pairs[i].num1, strlen(pairs[i].num1),
+                    pairs[i].num2, strlen(pairs[i].num2));
+   if (!success && pf->journal != NULL)
+      journalFail(pf->journal);
+   endChange(pf);
+   return success;
+}
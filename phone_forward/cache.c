@@ -0,0 +1,175 @@
+/** @file
+ * Implementacja pamięci podręcznej wyników wyszukiwania przekierowań.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "cache.h"
+#include "intern.h"
+
+/** Rozmiar upakowanego numeru najdłuższego zapamiętywanego numeru. */
+#define KEY_SIZE PACKED_SIZE(CACHE_MAX_LENGTH)
+
+/** Liczba wpisów w zbiorze - numer może trafić tylko do wpisów jednego zbioru. */
+#define WAYS 4
+
+/** Mnożniki mieszające słowa klucza (z funkcji mieszającej splitmix64). */
+#define MIX1 0xbf58476d1ce4e5b9ULL
+/** Drugi mnożnik mieszający. */
+#define MIX2 0x94d049bb133111ebULL
+
+/** @struct CacheSlot
+ * To jest struktura wpisu razem z jego kluczem.
+ */
+typedef struct CacheSlot {
+   CacheEntry entry;       ///< Zapamiętany wynik.
+   uint32_t hash;          ///< Skrót klucza.
+   uint8_t length;         ///< Długość numeru (0 - wpis jest wolny).
+   bool referenced;        ///< Czy odwołano się do wpisu od przejścia wskazówki.
+   uint8_t key[KEY_SIZE];  ///< Numer upakowany po 4 bity na cyfrę.
+} CacheSlot;
+
+struct LookupCache {
+   CacheSlot *slots;  ///< Wpisy - kolejne zbiory po @ref WAYS wpisów.
+   uint8_t *hands;    ///< Położenia wskazówek zegara w zbiorach.
+   size_t sets;       ///< Liczba zbiorów (potęga dwójki).
+   CacheStats stats;  ///< Liczniki odwołań.
+   atomic_flag busy;  ///< Czy pamięć podręczna jest zajęta przez któryś wątek.
+};
+
+/** @brief Wyznacza skrót klucza.
+ * @param[in] key    - wskaźnik na upakowany numer dopełniony zerami.
+ * @param[in] length - długość numeru.
+ * @return Skrót klucza.
+ */
+static uint32_t hashKey(uint8_t const *key, size_t const length) {
+   uint64_t low, high;
+   memcpy(&low, key, sizeof(uint64_t));
+   memcpy(&high, key + sizeof(uint64_t), sizeof(uint64_t));
+   uint64_t hash = (low ^ (uint64_t)length) * MIX1 + high * MIX2;
+   hash ^= hash >> 31;
+   hash *= MIX1;
+   return (uint32_t)(hash >> 32);
+}
+
+LookupCache * cacheNew(size_t const capacity) {
+   if (capacity == 0 || capacity >= (size_t)1 << 31)
+      return NULL;
+
+   LookupCache *cache = malloc(sizeof(LookupCache));
+   if (cache == NULL)
+      return NULL;
+
+   size_t sets = 1;
+   while (sets * WAYS < capacity)
+      sets *= 2;
+   cache->slots = malloc(sets * WAYS * sizeof(CacheSlot));
+   cache->hands = malloc(sets);
+   if (cache->slots == NULL || cache->hands == NULL) {
+      free(cache->slots);
+      free(cache->hands);
+      free(cache);
+      return NULL;
+   }
+
+   cache->sets = sets;
+   memset(&(cache->stats), 0, sizeof(CacheStats));
+   atomic_flag_clear(&(cache->busy));
+   cacheClear(cache);
+   return cache;
+}
+
+void cacheDelete(LookupCache *cache) {
+   if (cache == NULL)
+      return;
+
+   free(cache->slots);
+   free(cache->hands);
+   free(cache);
+}
+
+void cacheClear(LookupCache *cache) {
+   for (size_t i = 0; i < cache->sets * WAYS; i++)
+      (cache->slots)[i].length = 0;
+   memset(cache->hands, 0, cache->sets);
+}
+
+/** @brief Wybiera wpis zbioru do zastąpienia.
+ * Wybiera wolny wpis, a jeśli takiego nie ma, przesuwa wskazówkę zegara
+ * zbioru, odbierając mijanym wpisom drugą szansę, aż trafi na wpis, do
+ * którego nie odwołano się od poprzedniego przejścia.
+ * @param[in] set    - wskaźnik na pierwszy wpis zbioru.
+ * @param[in,out] hand - wskaźnik na położenie wskazówki zegara zbioru.
+ * @return Wskaźnik na wybrany wpis.
+ */
+static CacheSlot * evict(CacheSlot *set, uint8_t *hand) {
+   for (int i = 0; i < WAYS; i++) {
+      if (set[i].length == 0)
+         return &(set[i]);
+   }
+
+   while (set[*hand].referenced) {
+      set[*hand].referenced = false;
+      *hand = (uint8_t)((*hand + 1) % WAYS);
+   }
+   CacheSlot *victim = &(set[*hand]);
+   *hand = (uint8_t)((*hand + 1) % WAYS);
+   return victim;
+}
+
+CacheEntry * cacheLookup(LookupCache *cache, char const *number, size_t const length,
+                         bool *found) {
+   if (length > CACHE_MAX_LENGTH)
+      return NULL;
+
+   uint8_t key[KEY_SIZE] = {0};
+   internPack(key, number, length);
+   uint32_t const hash = hashKey(key, length);
+   size_t const index = hash & (cache->sets - 1);
+   CacheSlot *set = &((cache->slots)[index * WAYS]);
+
+   for (int i = 0; i < WAYS; i++) {
+      CacheSlot *slot = &(set[i]);
+      if (slot->hash == hash && slot->length == length
+          && memcmp(slot->key, key, KEY_SIZE) == 0) {
+         slot->referenced = true;
+         *found = true;
+         return &(slot->entry);
+      }
+   }
+
+   // Nowy wpis nie dostaje od razu drugiej szansy, więc numery wyszukane
+   // tylko raz są zastępowane przed tymi, do których się odwołujemy.
+   CacheSlot *slot = evict(set, &((cache->hands)[index]));
+   slot->hash = hash;
+   slot->length = (uint8_t)length;
+   slot->referenced = false;
+   memcpy(slot->key, key, KEY_SIZE);
+   *found = false;
+   return &(slot->entry);
+}
+
+bool cacheAcquire(LookupCache *cache) {
+   return !atomic_flag_test_and_set_explicit(&(cache->busy), memory_order_acquire);
+}
+
+void cacheRelease(LookupCache *cache) {
+   atomic_flag_clear_explicit(&(cache->busy), memory_order_release);
+}
+
+CacheStats * cacheStats(LookupCache *cache) {
+   return &(cache->stats);
+}
+
+size_t cacheBytes(LookupCache const *cache) {
+   return sizeof(LookupCache) + cache->sets * (WAYS * sizeof(CacheSlot) + 1);
+}
+
+size_t cacheCapacity(LookupCache const *cache) {
+   return cache->sets * WAYS;
+}
@@ -0,0 +1,122 @@
+/** @file
+ * Interfejs pamięci podręcznej wyników wyszukiwania przekierowań.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Długość najdłuższego numeru, którego wynik może być zapamiętany. */
+#define CACHE_MAX_LENGTH 32
+
+/** @struct CacheEntry
+ * To jest struktura opisująca zapamiętany wynik. Pamięć podręczna nie
+ * interpretuje jej pól - wypełnia je i sprawdza ich aktualność użytkownik.
+ */
+typedef struct CacheEntry {
+   void const *node;    ///< Wierzchołek, od którego zależy wynik.
+   uint32_t generation; ///< Numer zmiany wierzchołka w chwili zapamiętania wyniku.
+   uint32_t depth;      ///< Długość prefiksu numeru zastąpionego przekierowaniem.
+} CacheEntry;
+
+/** @struct CacheStats
+ * To jest struktura z licznikami odwołań do pamięci podręcznej.
+ */
+typedef struct CacheStats {
+   size_t hits;   ///< Liczba wyników odczytanych z pamięci podręcznej.
+   size_t misses; ///< Liczba wyników, których nie było w pamięci podręcznej.
+   size_t stale;  ///< Liczba zapamiętanych wyników nieaktualnych po zmianach.
+} CacheStats;
+
+/** @struct LookupCache
+ * To jest struktura pamięci podręcznej o stałej liczbie wpisów.
+ * Wpisy są podzielone na małe zbiory leżące obok siebie w pamięci, a skrót
+ * upakowanego numeru wyznacza zbiór, w którym może się znajdować jego wpis.
+ * Przy braku miejsca w zbiorze wpis do zastąpienia jest wybierany
+ * algorytmem zegarowym (CLOCK) - wpis, do którego odwołano się od
+ * ostatniego przejścia wskazówki, dostaje drugą szansę.
+ */
+struct LookupCache;
+/** @typedef LookupCache
+ * Definicja structury LookupCache.
+ */
+typedef struct LookupCache LookupCache;
+
+/** @brief Tworzy nową pamięć podręczną.
+ * @param[in] capacity – najmniejsza liczba wpisów (dodatnia, mniejsza niż
+ *                       2^31); jest zaokrąglana w górę tak, żeby liczba
+ *                       zbiorów była potęgą dwójki.
+ * @return Wskaźnik na utworzoną pamięć podręczną lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+LookupCache * cacheNew(size_t capacity);
+
+/** @brief Usuwa pamięć podręczną.
+ * Nic nie robi, jeśli wskaźnik @p cache ma wartość NULL.
+ * @param[in] cache – wskaźnik na usuwaną pamięć podręczną.
+ */
+void cacheDelete(LookupCache *cache);
+
+/** @brief Wyszukuje wpis numeru.
+ * Jeśli numeru nie ma w pamięci podręcznej, zajmuje dla niego wpis,
+ * w razie potrzeby zastępując inny. Pola nowego wpisu musi wypełnić
+ * wywołujący.
+ * @param[in,out] cache – wskaźnik na pamięć podręczną;
+ * @param[in] number    – wskaźnik na numer;
+ * @param[in] length    – długość numeru;
+ * @param[out] found    – czy numer był już w pamięci podręcznej.
+ * @return Wskaźnik na wpis numeru, ważny do kolejnego wywołania funkcji,
+ *         lub NULL, jeśli numer jest dłuższy niż @ref CACHE_MAX_LENGTH.
+ */
+CacheEntry * cacheLookup(LookupCache *cache, char const *number, size_t length,
+                         bool *found);
+
+/** @brief Próbuje zająć pamięć podręczną.
+ * Wpisy i liczniki może zmieniać naraz tylko jeden wątek. Funkcja nie czeka
+ * na zwolnienie pamięci podręcznej przez inny wątek - wywołujący może wtedy
+ * obejść się bez niej.
+ * @param[in,out] cache – wskaźnik na pamięć podręczną.
+ * @return Wartość @p true, jeśli pamięć podręczna została zajęta i musi być
+ *         zwolniona za pomocą @ref cacheRelease.
+ *         Wartość @p false, jeśli zajmuje ją inny wątek.
+ */
+bool cacheAcquire(LookupCache *cache);
+
+/** @brief Zwalnia pamięć podręczną zajętą przez @ref cacheAcquire.
+ * @param[in,out] cache – wskaźnik na pamięć podręczną.
+ */
+void cacheRelease(LookupCache *cache);
+
+/** @brief Usuwa wszystkie wpisy.
+ * Nie zmienia liczników odwołań.
+ * @param[in,out] cache – wskaźnik na pamięć podręczną.
+ */
+void cacheClear(LookupCache *cache);
+
+/** @brief Udostępnia liczniki odwołań.
+ * Liczniki zwiększa wywołujący, bo tylko on wie, czy wpis jest aktualny.
+ * @param[in] cache – wskaźnik na pamięć podręczną.
+ * @return Wskaźnik na liczniki.
+ */
+CacheStats * cacheStats(LookupCache *cache);
+
+/** @brief Wyznacza rozmiar pamięci podręcznej.
+ * @param[in] cache – wskaźnik na pamięć podręczną.
+ * @return Liczba bajtów zajmowanych przez pamięć podręczną.
+ */
+size_t cacheBytes(LookupCache const *cache);
+
+/** @brief Zwraca liczbę wpisów.
+ * @param[in] cache – wskaźnik na pamięć podręczną.
+ * @return Liczba wpisów pamięci podręcznej.
+ */
+size_t cacheCapacity(LookupCache const *cache);
+
+#endif /* __CACHE_H__ */
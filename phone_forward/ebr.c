@@ -0,0 +1,174 @@
+/** @file
+ * Implementacja odroczonego zwalniania obiektów czytanych współbieżnie.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include "ebr.h"
+
+/** Liczba odczytów, które mogą jednocześnie trwać w trybie współbieżnym.
+ * Kolejne odczyty czekają na zwolnienie miejsca.
+ */
+#define MAX_READERS 64
+
+/** Liczba odczytów rozpoczętych przez @ref ebrPin, które mogą trwać
+ * jednocześnie. Pozostałe miejsca są zawsze dostępne dla krótkich odczytów.
+ */
+#define MAX_PINNED (MAX_READERS / 2)
+
+/** Rozmiar linii pamięci podręcznej. */
+#define CACHE_LINE 64
+
+/** Początkowy rozmiar tablicy obiektów czekających na zwolnienie. */
+#define INITIAL_RETIRED 16
+
+/** @struct ReaderSlot
+ * To jest struktura, w której wątek czytający ogłasza epokę, w której
+ * zaczął czytać. Zajmuje całą linię pamięci podręcznej, żeby wątki
+ * czytające nie unieważniały sobie nawzajem linii.
+ */
+typedef struct ReaderSlot {
+   _Atomic uint64_t epoch; ///< Ogłoszona epoka lub 0, jeśli miejsce jest wolne.
+   char padding[CACHE_LINE - sizeof(uint64_t)]; ///< Dopełnienie do rozmiaru linii.
+} ReaderSlot;
+
+/** @struct Retired
+ * To jest struktura opisująca obiekt, który nie należy już do bieżącej
+ * wersji, ale może być jeszcze czytany przez inne wątki.
+ */
+typedef struct Retired {
+   void *object;   ///< Wskaźnik na obiekt.
+   uint64_t epoch; ///< Epoka, od której obiekt jest niewidoczny (0 - zmiana trwa).
+   int kind;       ///< Rodzaj obiektu.
+} Retired;
+
+struct EpochDomain {
+   ReaderSlot *readers;    ///< Epoki ogłoszone przez wątki czytające.
+   _Atomic uint64_t epoch; ///< Bieżąca epoka.
+   atomic_size_t pinned;   ///< Liczba trwających odczytów z @ref ebrPin.
+   Retired *retired;       ///< Obiekty czekające na zwolnienie.
+   size_t retiredCount;    ///< Liczba obiektów czekających na zwolnienie.
+   size_t retiredSize;     ///< Rozmiar tablicy @p retired.
+   size_t reserved;        ///< Liczba miejsc zarezerwowanych w trwającej zmianie.
+};
+
+/** Podpowiedź, które miejsce ogłaszania epoki wątek zajmował ostatnio. */
+static _Thread_local size_t readerHint;
+
+EpochDomain * ebrNew(void) {
+   EpochDomain *domain = malloc(sizeof(EpochDomain));
+   ReaderSlot *readers = aligned_alloc(CACHE_LINE, MAX_READERS * sizeof(ReaderSlot));
+   if (domain == NULL || readers == NULL) {
+      free(domain);
+      free(readers);
+      return NULL;
+   }
+
+   for (size_t i = 0; i < MAX_READERS; i++)
+      atomic_init(&(readers[i].epoch), 0);
+   domain->readers = readers;
+   atomic_init(&(domain->epoch), 1);
+   atomic_init(&(domain->pinned), 0);
+   domain->retired = NULL;
+   domain->retiredCount = 0;
+   domain->retiredSize = 0;
+   domain->reserved = 0;
+   return domain;
+}
+
+void ebrDelete(EpochDomain *domain) {
+   if (domain == NULL)
+      return;
+
+   free(domain->readers);
+   free(domain->retired);
+   free(domain);
+}
+
+size_t ebrEnter(EpochDomain *domain) {
+   size_t i = readerHint;
+   while (true) {
+      for (size_t tries = 0; tries < MAX_READERS; tries++) {
+         uint64_t expected = 0;
+         if (atomic_compare_exchange_strong(&((domain->readers)[i].epoch), &expected,
+                                            atomic_load(&(domain->epoch)))) {
+            readerHint = i;
+            return i;
+         }
+         i = (i + 1) % MAX_READERS;
+      }
+      // Wszystkie miejsca są zajęte przez inne wątki.
+      sched_yield();
+   }
+}
+
+void ebrLeave(EpochDomain *domain, size_t const slot) {
+   atomic_store_explicit(&((domain->readers)[slot].epoch), 0, memory_order_release);
+}
+
+bool ebrPin(EpochDomain *domain, size_t *slot) {
+   if (atomic_fetch_add(&(domain->pinned), 1) >= MAX_PINNED) {
+      atomic_fetch_sub(&(domain->pinned), 1);
+      return false;
+   }
+   *slot = ebrEnter(domain);
+   return true;
+}
+
+void ebrUnpin(EpochDomain *domain, size_t const slot) {
+   ebrLeave(domain, slot);
+   atomic_fetch_sub(&(domain->pinned), 1);
+}
+
+bool ebrReserve(EpochDomain *domain, size_t const count) {
+   size_t const needed = domain->retiredCount + domain->reserved + count;
+   if (needed > domain->retiredSize) {
+      size_t size = (domain->retiredSize == 0 ? INITIAL_RETIRED : domain->retiredSize);
+      while (size < needed)
+         size *= 2;
+      Retired *retired = realloc(domain->retired, size * sizeof(Retired));
+      if (retired == NULL)
+         return false;
+      domain->retired = retired;
+      domain->retiredSize = size;
+   }
+   domain->reserved += count;
+   return true;
+}
+
+void ebrRetire(EpochDomain *domain, void *object, int const kind) {
+   (domain->reserved)--;
+   (domain->retired)[domain->retiredCount++] = (Retired){object, 0, kind};
+}
+
+void ebrAdvance(EpochDomain *domain, EpochRelease release, void *context) {
+   // Wątek, który ogłosi nową epokę, zobaczy już wynik zmiany.
+   uint64_t const epoch = atomic_fetch_add(&(domain->epoch), 1) + 1;
+   domain->reserved = 0;
+   for (size_t i = domain->retiredCount; i > 0 && (domain->retired)[i - 1].epoch == 0; i--)
+      (domain->retired)[i - 1].epoch = epoch;
+
+   // Obiekt odłożony w epoce e może czytać tylko wątek, który ogłosił
+   // wcześniejszą epokę.
+   uint64_t oldest = UINT64_MAX;
+   for (size_t i = 0; i < MAX_READERS; i++) {
+      uint64_t const announced = atomic_load(&((domain->readers)[i].epoch));
+      if (announced != 0 && announced < oldest)
+         oldest = announced;
+   }
+
+   size_t kept = 0;
+   for (size_t i = 0; i < domain->retiredCount; i++) {
+      if ((domain->retired)[i].epoch > oldest)
+         (domain->retired)[kept++] = (domain->retired)[i];
+      else
+         release(context, (domain->retired)[i].object, (domain->retired)[i].kind);
+   }
+   domain->retiredCount = kept;
+}
@@ -0,0 +1,117 @@
+/** @file
+ * Interfejs odroczonego zwalniania obiektów czytanych współbieżnie
+ * (ang. epoch-based reclamation).
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#ifndef __EBR_H__
+#define __EBR_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @struct EpochDomain
+ * To jest struktura opisująca epoki wątków czytających i obiekty czekające
+ * na zwolnienie. Wątek czytający ogłasza epokę, w której zaczął czytać,
+ * a obiekt usunięty przez zmianę jest zwalniany dopiero wtedy, gdy każdy
+ * wątek, który mógł go zobaczyć, skończył czytać. Zmiany muszą być
+ * szeregowane przez wywołującego.
+ */
+struct EpochDomain;
+/** @typedef EpochDomain
+ * Definicja structury EpochDomain.
+ */
+typedef struct EpochDomain EpochDomain;
+
+/** @typedef EpochRelease
+ * Funkcja zwalniająca obiekt, którego nie może już czytać żaden wątek.
+ * Dostaje kontekst przekazany do @ref ebrAdvance, obiekt i jego rodzaj
+ * przekazany do @ref ebrRetire.
+ */
+typedef void (*EpochRelease)(void *context, void *object, int kind);
+
+/** @brief Tworzy nową domenę epok.
+ * @return Wskaźnik na utworzoną domenę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+EpochDomain * ebrNew(void);
+
+/** @brief Usuwa domenę epok.
+ * Obiekty czekające na zwolnienie nie są zwalniane - należą do
+ * wywołującego. Nic nie robi, jeśli wskaźnik @p domain ma wartość NULL.
+ * @param[in] domain – wskaźnik na usuwaną domenę.
+ */
+void ebrDelete(EpochDomain *domain);
+
+/** @brief Rozpoczyna odczyt.
+ * Ogłasza bieżącą epokę w wolnym miejscu, dzięki czemu obiekty widoczne
+ * po powrocie z funkcji nie zostaną zwolnione przed wywołaniem
+ * @ref ebrLeave. Nie blokuje się na zmianach - czeka tylko wtedy, gdy
+ * wszystkie miejsca zajmują inne wątki.
+ * @param[in,out] domain – wskaźnik na domenę.
+ * @return Indeks zajętego miejsca.
+ */
+size_t ebrEnter(EpochDomain *domain);
+
+/** @brief Kończy odczyt rozpoczęty przez @ref ebrEnter.
+ * @param[in,out] domain – wskaźnik na domenę;
+ * @param[in] slot       – indeks miejsca zajętego przez @ref ebrEnter.
+ */
+void ebrLeave(EpochDomain *domain, size_t slot);
+
+/** @brief Rozpoczyna odczyt, który może trwać dowolnie długo.
+ * Działa jak @ref ebrEnter, ale takich odczytów może jednocześnie trwać
+ * tylko połowa liczby miejsc, dzięki czemu nie mogą zablokować krótkich
+ * odczytów na stałe. Zamiast czekać na zwolnienie miejsca, zgłasza
+ * niepowodzenie.
+ * @param[in,out] domain – wskaźnik na domenę;
+ * @param[out] slot      – wskaźnik na indeks zajętego miejsca.
+ * @return Wartość @p true, jeśli odczyt został rozpoczęty.
+ *         Wartość @p false, jeśli trwa już największa liczba takich odczytów.
+ */
+bool ebrPin(EpochDomain *domain, size_t *slot);
+
+/** @brief Kończy odczyt rozpoczęty przez @ref ebrPin.
+ * @param[in,out] domain – wskaźnik na domenę;
+ * @param[in] slot       – indeks miejsca zajętego przez @ref ebrPin.
+ */
+void ebrUnpin(EpochDomain *domain, size_t slot);
+
+/** @brief Rezerwuje miejsce na obiekty do zwolnienia.
+ * Zapewnia miejsce na @p count kolejnych obiektów odkładanych przez
+ * @ref ebrRetire, ponad miejsca zarezerwowane wcześniej w tej samej zmianie.
+ * Wywołujący rezerwuje miejsce, zanim odłączy obiekty od bieżącej wersji,
+ * dzięki czemu niepowodzenie alokacji może zgłosić, zanim cokolwiek zmieni.
+ * Niewykorzystane rezerwacje wygasają w @ref ebrAdvance.
+ * @param[in,out] domain – wskaźnik na domenę;
+ * @param[in] count      – liczba rezerwowanych miejsc.
+ * @return Wartość @p true, jeśli miejsce zostało zarezerwowane.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+bool ebrReserve(EpochDomain *domain, size_t count);
+
+/** @brief Odkłada obiekt do zwolnienia.
+ * Obiekt zostanie zwolniony, gdy żaden wątek nie będzie mógł go już czytać,
+ * ale nie wcześniej niż w pierwszym wywołaniu @ref ebrAdvance. Zajmuje
+ * miejsce zarezerwowane wcześniej przez @ref ebrReserve, więc nie może się
+ * nie udać.
+ * @param[in,out] domain – wskaźnik na domenę;
+ * @param[in] object     – wskaźnik na obiekt;
+ * @param[in] kind       – rodzaj obiektu, przekazywany funkcji zwalniającej.
+ */
+void ebrRetire(EpochDomain *domain, void *object, int kind);
+
+/** @brief Kończy zmianę i zwalnia obiekty, których nie może już czytać żaden wątek.
+ * Musi być wywołana po opublikowaniu wyniku zmiany. Rozpoczyna nową epokę -
+ * obiekty odłożone w trakcie zmiany może czytać tylko wątek, który ogłosił
+ * wcześniejszą epokę. Niewykorzystane rezerwacje wygasają.
+ * @param[in,out] domain – wskaźnik na domenę;
+ * @param[in] release    – funkcja zwalniająca obiekty;
+ * @param[in] context    – kontekst przekazywany funkcji @p release.
+ */
+void ebrAdvance(EpochDomain *domain, EpochRelease release, void *context);
+
+#endif /* __EBR_H__ */
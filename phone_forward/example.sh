@@ -0,0 +1,60 @@
+#!/bin/bash
+
+# Użycie:
+#   ./example.sh [prog [dir]]
+#      Uruchamia program (domyślnie ./phone_forward) na każdym pliku dir/*.in
+#      (domyślnie examples/*.in) i porównuje standardowe wyjście z plikiem .out,
+#      a wyjście diagnostyczne z plikiem .err. Kod wyjścia programu musi być
+#      równy 1, jeśli plik .err nie jest pusty, i 0 w przeciwnym razie.
+
+PROG=${1:-./phone_forward}
+DIR=${2:-examples}
+
+if [ ! -x "$PROG" ]
+then
+   echo "Podany program nie istnieje!"
+   exit 1
+fi
+
+if [ ! -d "$DIR" ]
+then
+   echo "Podana ścieżka nie istnieje!"
+   exit 1
+fi
+
+ERRORS=0
+TESTS=0
+
+for f in "$DIR/"*.in
+do
+   ((TESTS++))
+
+   "$PROG" "$f" 1>test.out 2>test.err
+   CODE=$?
+   EXPECTED=0
+   if [ -s "${f%in}err" ]
+   then
+      EXPECTED=1
+   fi
+
+   if diff "${f%in}out" test.out >/dev/null 2>&1 \
+      && diff "${f%in}err" test.err >/dev/null 2>&1 \
+      && ((CODE == EXPECTED))
+   then
+      echo "Test $f: OK."
+   else
+      echo "Test $f: błędna odpowiedź."
+      ((ERRORS++))
+   fi
+
+   rm test.out test.err
+done
+
+echo "Liczba testów: $TESTS."
+echo "Liczba błędnych odpowiedzi: $ERRORS."
+
+if ((ERRORS > 0))
+then
+   exit 1
+fi
+exit 0
@@ -0,0 +1,164 @@
+/** @file
+ * Implementacja postaci zamrożonej drzew przekierowań.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "frozen.h"
+#include "intern.h"
+
+/** @struct TargetSlot
+ * To jest struktura miejsca w tablicy haszującej, która przypisuje
+ * numerom docelowym indeksy w postaci zamrożonej.
+ */
+typedef struct TargetSlot {
+   Target const *target; ///< Wskaźnik na numer docelowy (NULL - wolne miejsce).
+   uint32_t index;       ///< Indeks numeru w postaci zamrożonej.
+} TargetSlot;
+
+Frozen * frozenNew(Node const *root, Node const *reverseRoot, size_t const distinctTargets,
+                   size_t const maxSourceLength, size_t const maxTargetLength) {
+   size_t capacity = 1;
+   while (capacity < 2 * distinctTargets)
+      capacity *= 2;
+
+   Frozen *frozen = calloc(1, sizeof(Frozen));
+   TargetSlot *map = calloc(capacity, sizeof(TargetSlot));
+   Node const **order = NULL;
+   FlatNode *nodes = NULL;
+   FlatTarget *targets = NULL;
+   char *chars = NULL;
+   size_t orderSize = 0, nodesSize = 0, targetsSize = 0, charsSize = 0;
+   size_t count = 1, targetCount = 0, charsCount = 0, reverse = 0;
+   bool success = (frozen != NULL && map != NULL
+                   && reserveArray((void**)&order, &orderSize, 1, sizeof(Node*)));
+   if (success)
+      order[0] = root;
+
+   // Kolejka order jest jednocześnie wynikową kolejnością wierzchołków:
+   // synowie wierzchołka trafiają na jej koniec, więc ich indeksy są kolejne.
+   for (size_t i = 0; success; i++) {
+      if (i == count) { // Drzewo przekierowań jest przetworzone.
+         if (reverse != 0)
+            break;
+         success = reserveArray((void**)&order, &orderSize, count + 1, sizeof(Node*));
+         if (!success)
+            break;
+         reverse = count;
+         order[count++] = reverseRoot;
+      }
+      if (i + PREFETCH_DISTANCE < count)
+         PREFETCH(order[i + PREFETCH_DISTANCE]);
+
+      Node const *node = order[i];
+      size_t const children = (size_t)nonEmptySubtrees(node);
+      success = reserveArray((void**)&order, &orderSize, count + children, sizeof(Node*))
+                && reserveArray((void**)&nodes, &nodesSize, i + 1, sizeof(FlatNode))
+                && count + children < NO_INDEX;
+      if (!success)
+         break;
+
+      nodes[i].subtrees = (uint32_t)count;
+      nodes[i].forward = NO_INDEX;
+      nodes[i].children = node->children;
+      nodes[i].digit = node->digit;
+      nodes[i].isSource = node->isSource;
+      memcpy(order + count, node->subtrees, children * sizeof(Node*));
+      count += children;
+
+      Target const *target = node->forward;
+      if (target == NULL)
+         continue;
+      size_t position = target->hash & (capacity - 1);
+      while (map[position].target != NULL && map[position].target != target)
+         position = (position + 1) & (capacity - 1);
+      if (map[position].target == NULL) { // Pierwsze wystąpienie numeru.
+         success = reserveArray((void**)&targets, &targetsSize, targetCount + 1,
+                                sizeof(FlatTarget))
+                   && reserveArray((void**)&chars, &charsSize,
+                                   charsCount + target->length + 1, sizeof(char))
+                   && charsCount + target->length + 1 <= UINT32_MAX;
+         if (!success)
+            break;
+         map[position].target = target;
+         map[position].index = (uint32_t)targetCount;
+         targets[targetCount].offset = (uint32_t)charsCount;
+         targets[targetCount].length = (uint32_t)(target->length);
+         internUnpack(chars + charsCount, target->digits, target->length);
+         chars[charsCount + target->length] = '\0';
+         targetCount++;
+         charsCount += target->length + 1;
+      }
+      nodes[i].forward = map[position].index;
+   }
+
+   // Wszystkie tablice trafiają do jednego bloku.
+   size_t const nodesBytes = count * sizeof(FlatNode);
+   size_t const targetsBytes = targetCount * sizeof(FlatTarget);
+   void *block = (success ? realloc(nodes, nodesBytes + targetsBytes + charsCount) : NULL);
+   if (block == NULL) {
+      free(nodes);
+      free(targets);
+      free(chars);
+      free(order);
+      free(map);
+      free(frozen);
+      return NULL;
+   }
+   if (targetCount > 0)
+      memcpy((char*)block + nodesBytes, targets, targetsBytes);
+   if (charsCount > 0)
+      memcpy((char*)block + nodesBytes + targetsBytes, chars, charsCount);
+
+   frozen->block = block;
+   frozen->nodes = block;
+   frozen->targets = (FlatTarget const *)((char*)block + nodesBytes);
+   frozen->chars = (char const *)block + nodesBytes + targetsBytes;
+   frozen->nodeCount = (uint32_t)count;
+   frozen->reverse = (uint32_t)reverse;
+   frozen->targetCount = (uint32_t)targetCount;
+   frozen->charsCount = (uint32_t)charsCount;
+   frozen->maxSourceLength = maxSourceLength;
+   frozen->maxTargetLength = maxTargetLength;
+   frozen->users = 1;
+   free(targets);
+   free(chars);
+   free(order);
+   free(map);
+   return frozen;
+}
+
+void frozenRelease(Frozen *frozen) {
+   if (frozen == NULL || --(frozen->users) > 0)
+      return;
+   if (frozen->mapped > 0)
+      munmap(frozen->block, frozen->mapped);
+   else
+      free(frozen->block);
+   free(frozen);
+}
+
+FlatTarget const * frozenLookup(Frozen const *frozen, char const *num, size_t *longest) {
+   FlatTarget const *target = NULL;
+   FlatNode const *node = frozen->nodes;
+   size_t position = 0;
+   *longest = 0;
+
+   while (node != NULL && isDigit(num[position])) {
+      node = frozenChild(frozen, node, digitID(num[position]));
+      position++;
+
+      if (node != NULL && node->forward != NO_INDEX) {
+         *longest = position;
+         target = &((frozen->targets)[node->forward]);
+      }
+   }
+   return target;
+}
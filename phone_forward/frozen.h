@@ -0,0 +1,111 @@
+/** @file
+ * Interfejs postaci zamrożonej drzew przekierowań.
+ * Nie jest częścią interfejsu klasy przechowującej przekierowania.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#ifndef __FROZEN_H__
+#define __FROZEN_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "trie.h"
+
+/** Indeks oznaczający brak wierzchołka lub przekierowania w postaci zamrożonej. */
+#define NO_INDEX UINT32_MAX
+
+/** @struct FlatNode
+ * To jest struktura wierzchołka drzewa w postaci zamrożonej. Wierzchołki
+ * drzewa leżą w tablicy w kolejności poziomów, dlatego synowie wierzchołka
+ * zajmują kolejne pozycje tablicy i wystarczy pamiętać pozycję pierwszego.
+ */
+typedef struct FlatNode {
+   uint32_t subtrees; ///< Indeks pierwszego syna w tablicy wierzchołków.
+   uint32_t forward;  ///< Indeks przekierowania lub @ref NO_INDEX.
+   uint16_t children; ///< Mapa bitowa istniejących synów.
+   char digit;        ///< Cyfra reprezentująca wierzchołek.
+   bool isSource;     ///< Czy wierzchołek indeksu odwrotnego kończy klucz.
+} FlatNode;
+
+/** @struct FlatTarget
+ * To jest struktura opisująca numer docelowy w postaci zamrożonej.
+ */
+typedef struct FlatTarget {
+   uint32_t offset; ///< Położenie numeru w tablicy znaków.
+   uint32_t length; ///< Długość numeru.
+} FlatTarget;
+
+/** @struct Frozen
+ * To jest struktura przechowująca przekierowania w postaci zamrożonej.
+ * Wierzchołki obu drzew, numery docelowe i ich znaki leżą w jednym bloku
+ * pamięci i odwołują się do siebie wyłącznie za pomocą indeksów, dlatego
+ * blok nie zależy od adresu, pod którym się znajduje. Blok może być
+ * częścią odwzorowanego w pamięci pliku z migawką.
+ */
+typedef struct Frozen {
+   void *block;              ///< Blok pamięci z tablicami lub odwzorowany plik.
+   size_t mapped;            ///< Rozmiar odwzorowanego pliku (0 - blok z malloc).
+   FlatNode const *nodes;    ///< Wierzchołki; drzewo przekierowań zaczyna się od 0.
+   FlatTarget const *targets; ///< Numery docelowe.
+   char const *chars;        ///< Znaki numerów docelowych, każdy zakończony '\0'.
+   uint32_t nodeCount;       ///< Liczba wierzchołków.
+   uint32_t reverse;         ///< Indeks korzenia indeksu odwrotnego.
+   uint32_t targetCount;     ///< Liczba numerów docelowych.
+   uint32_t charsCount;      ///< Liczba znaków numerów docelowych.
+   size_t maxSourceLength;   ///< Długość najdłuższego numeru przekierowywanego.
+   size_t maxTargetLength;   ///< Długość najdłuższego numeru docelowego.
+   size_t users;             ///< Liczba struktur korzystających z postaci zamrożonej.
+} Frozen;
+
+/** @brief Tworzy postać zamrożoną drzew.
+ * Drzewa są przechodzone wszerz w jednym przebiegu - kolejka wierzchołków
+ * wyznacza jednocześnie ich indeksy w postaci zamrożonej. Każdy numer
+ * docelowy jest zapisywany raz, niezależnie od liczby przekierowań, które
+ * go używają.
+ * @param[in] root            – wskaźnik na korzeń drzewa przekierowań;
+ * @param[in] reverseRoot     – wskaźnik na korzeń indeksu odwrotnego;
+ * @param[in] distinctTargets – liczba różnych numerów docelowych;
+ * @param[in] maxSourceLength – długość najdłuższego numeru przekierowywanego;
+ * @param[in] maxTargetLength – długość najdłuższego numeru docelowego.
+ * @return Wskaźnik na postać zamrożoną, z której korzysta jedna struktura,
+ *         lub NULL, gdy nie udało się alokować pamięci albo drzewa nie
+ *         mieszczą się w 32-bitowych indeksach.
+ */
+Frozen * frozenNew(Node const *root, Node const *reverseRoot, size_t distinctTargets,
+                   size_t maxSourceLength, size_t maxTargetLength);
+
+/** @brief Zwalnia postać zamrożoną.
+ * Postać zamrożona jest zwalniana dopiero wtedy, gdy nie korzysta z niej
+ * już żadna struktura. Nic nie robi, jeśli wskaźnik @p frozen ma wartość NULL.
+ * @param[in] frozen – wskaźnik na postać zamrożoną.
+ */
+void frozenRelease(Frozen *frozen);
+
+/** @brief Zwraca syna wierzchołka postaci zamrożonej.
+ * @param[in] frozen – wskaźnik na postać zamrożoną.
+ * @param[in] node   – wskaźnik na wierzchołek.
+ * @param[in] id     – identyfikator krawędzi prowadzącej do syna.
+ * @return Wskaźnik na syna lub NULL, jeśli taki syn nie istnieje.
+ */
+static inline FlatNode const * frozenChild(Frozen const *frozen, FlatNode const *node,
+                                           int const id) {
+   if (!(node->children & (1u << id)))
+      return NULL;
+   return &((frozen->nodes)[node->subtrees
+                            + (uint32_t)popcount(node->children & ((1u << id) - 1))]);
+}
+
+/** @brief Wyznacza najgłębsze przekierowanie na ścieżce numeru.
+ * @param[in] frozen   – wskaźnik na postać zamrożoną.
+ * @param[in] num      – wskaźnik na numer.
+ * @param[out] longest – wskaźnik na długość prefiksu, dla którego istnieje
+ *                       przekierowanie (0, jeśli nie istnieje żadne).
+ * @return Wskaźnik na numer docelowy przekierowania lub NULL.
+ */
+FlatTarget const * frozenLookup(Frozen const *frozen, char const *num, size_t *longest);
+
+#endif /* __FROZEN_H__ */
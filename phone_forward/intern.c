@@ -0,0 +1,251 @@
+/** @file
+ * Implementacja tablicy współdzielonych numerów docelowych przekierowań.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "intern.h"
+
+/** Początkowa liczba miejsc w tablicy (potęga dwójki). */
+#define INITIAL_CAPACITY 64
+
+/** Tablica jest powiększana, gdy zajętych jest więcej niż połowa miejsc. */
+#define MAX_LOAD_NUMERATOR 1
+/** Mianownik maksymalnego wypełnienia tablicy. */
+#define MAX_LOAD_DENOMINATOR 2
+
+/** Podstawa skrótu FNV-1a. */
+#define FNV_OFFSET 14695981039346656037ULL
+/** Mnożnik skrótu FNV-1a. */
+#define FNV_PRIME 1099511628211ULL
+
+struct InternTable {
+   SlabAllocator *allocator; ///< Alokator numerów docelowych.
+   Target **slots;           ///< Miejsca tablicy (adresowanie otwarte).
+   size_t capacity;          ///< Liczba miejsc.
+   size_t count;             ///< Liczba przechowywanych numerów.
+   size_t bytes;             ///< Łączny rozmiar przechowywanych numerów.
+   uint8_t *packed;          ///< Bufor na upakowany wyszukiwany numer.
+   size_t packedSize;        ///< Rozmiar bufora @p packed.
+};
+
+/** Znaki odpowiadające kolejnym wartościom upakowanej cyfry. */
+static char const symbols[] = "0123456789*#";
+
+/** @brief Wyznacza skrót numeru.
+ * @param[in] number - wskaźnik na numer.
+ * @param[in] length - długość numeru.
+ * @return Skrót FNV-1a numeru.
+ */
+static uint64_t hashNumber(char const *number, size_t const length) {
+   uint64_t hash = FNV_OFFSET;
+   for (size_t i = 0; i < length; i++) {
+      hash ^= (unsigned char)number[i];
+      hash *= FNV_PRIME;
+   }
+   return hash;
+}
+
+/** @brief Wyznacza wartość upakowanej cyfry.
+ * @param[in] digit - znak cyfry.
+ * @return Wartość cyfry - 10 dla '*' i 11 dla '#'.
+ */
+static inline uint8_t digitValue(char const digit) {
+   if (digit == '*')
+      return 10;
+   if (digit == '#')
+      return 11;
+   return (uint8_t)(digit - '0');
+}
+
+void internPack(uint8_t *packed, char const *number, size_t const length) {
+   for (size_t i = 0; i + 1 < length; i += 2)
+      packed[i / 2] = (uint8_t)((digitValue(number[i]) << 4) | digitValue(number[i + 1]));
+   if (length % 2 == 1)
+      packed[length / 2] = (uint8_t)(digitValue(number[length - 1]) << 4);
+}
+
+void internUnpack(char *number, uint8_t const *packed, size_t const length) {
+   for (size_t i = 0; i + 1 < length; i += 2) {
+      number[i] = symbols[packed[i / 2] >> 4];
+      number[i + 1] = symbols[packed[i / 2] & 0x0F];
+   }
+   if (length % 2 == 1)
+      number[length - 1] = symbols[packed[length / 2] >> 4];
+}
+
+bool internEqual(Target const *target, char const *number, size_t const length) {
+   if (target->length != length)
+      return false;
+   for (size_t i = 0; i + 1 < length; i += 2) {
+      if ((target->digits)[i / 2]
+          != (uint8_t)((digitValue(number[i]) << 4) | digitValue(number[i + 1])))
+         return false;
+   }
+   return (length % 2 == 0
+           || ((target->digits)[length / 2] >> 4) == digitValue(number[length - 1]));
+}
+
+bool internPackedEqual(uint8_t const *packed1, uint8_t const *packed2, size_t const length) {
+   size_t const bytes = length / 2;
+   size_t i = 0;
+   for (; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t)) {
+      uint64_t word1, word2;
+      memcpy(&word1, packed1 + i, sizeof(uint64_t));
+      memcpy(&word2, packed2 + i, sizeof(uint64_t));
+      if (word1 != word2)
+         return false;
+   }
+   if (memcmp(packed1 + i, packed2 + i, bytes - i) != 0)
+      return false;
+   return (length % 2 == 0 || (packed1[bytes] >> 4) == (packed2[bytes] >> 4));
+}
+
+/** @brief Wstawia numer docelowy do tablicy.
+ * Zakłada, że numeru nie ma w tablicy i jest w niej wolne miejsce.
+ * @param[in,out] slots - miejsca tablicy.
+ * @param[in] capacity  - liczba miejsc.
+ * @param[in] target    - wskaźnik na numer docelowy.
+ */
+static void insertSlot(Target **slots, size_t const capacity, Target *target) {
+   size_t index = (size_t)(target->hash) & (capacity - 1);
+   while (slots[index] != NULL)
+      index = (index + 1) & (capacity - 1);
+   slots[index] = target;
+}
+
+/** @brief Dwukrotnie powiększa tablicę.
+ * @param[in,out] table - wskaźnik na tablicę.
+ * @return Wartość @p true, jeśli tablica została powiększona.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool grow(InternTable *table) {
+   size_t const capacity = 2 * table->capacity;
+   Target **slots = calloc(capacity, sizeof(Target*));
+   if (slots == NULL)
+      return false;
+
+   for (size_t i = 0; i < table->capacity; i++) {
+      if ((table->slots)[i] != NULL)
+         insertSlot(slots, capacity, (table->slots)[i]);
+   }
+   free(table->slots);
+   table->slots = slots;
+   table->capacity = capacity;
+   return true;
+}
+
+InternTable * internNew(SlabAllocator *allocator) {
+   InternTable *table = malloc(sizeof(InternTable));
+   if (table == NULL)
+      return NULL;
+
+   table->allocator = allocator;
+   table->capacity = INITIAL_CAPACITY;
+   table->count = 0;
+   table->bytes = 0;
+   table->packed = NULL;
+   table->packedSize = 0;
+   table->slots = calloc(table->capacity, sizeof(Target*));
+   if (table->slots == NULL) {
+      free(table);
+      return NULL;
+   }
+   return table;
+}
+
+void internDelete(InternTable *table) {
+   if (table == NULL)
+      return;
+
+   free(table->slots);
+   free(table->packed);
+   free(table);
+}
+
+Target * internAcquire(InternTable *table, char const *number, size_t const length) {
+   size_t const size = PACKED_SIZE(length);
+   if (size > table->packedSize) {
+      uint8_t *packed = realloc(table->packed, size);
+      if (packed == NULL)
+         return NULL;
+      table->packed = packed;
+      table->packedSize = size;
+   }
+   internPack(table->packed, number, length);
+
+   uint64_t const hash = hashNumber(number, length);
+   size_t index = (size_t)hash & (table->capacity - 1);
+   while ((table->slots)[index] != NULL) {
+      Target *target = (table->slots)[index];
+      if (target->hash == hash && target->length == length
+          && memcmp(target->digits, table->packed, size) == 0) {
+         (target->references)++;
+         return target;
+      }
+      index = (index + 1) & (table->capacity - 1);
+   }
+
+   if ((table->count + 1) * MAX_LOAD_DENOMINATOR > table->capacity * MAX_LOAD_NUMERATOR
+       && !grow(table))
+      return NULL;
+
+   Target *target = slabAlloc(table->allocator, sizeof(Target) + size);
+   if (target == NULL)
+      return NULL;
+
+   target->references = 1;
+   target->length = length;
+   target->hash = hash;
+   memcpy(target->digits, table->packed, size);
+
+   insertSlot(table->slots, table->capacity, target);
+   (table->count)++;
+   table->bytes += sizeof(Target) + size;
+   return target;
+}
+
+void internRetain(Target *target) {
+   (target->references)++;
+}
+
+void internRelease(InternTable *table, Target *target) {
+   if (target == NULL || --(target->references) > 0)
+      return;
+
+   size_t const mask = table->capacity - 1;
+   size_t index = (size_t)(target->hash) & mask;
+   while ((table->slots)[index] != target)
+      index = (index + 1) & mask;
+
+   // Usunięcie z przesunięciem wstecz - elementy, które przy wstawianiu
+   // ominęły zwolnione miejsce, są do niego przesuwane.
+   size_t hole = index;
+   index = (index + 1) & mask;
+   while ((table->slots)[index] != NULL) {
+      size_t const home = (size_t)((table->slots)[index]->hash) & mask;
+      if (((index - home) & mask) >= ((index - hole) & mask)) {
+         (table->slots)[hole] = (table->slots)[index];
+         hole = index;
+      }
+      index = (index + 1) & mask;
+   }
+   (table->slots)[hole] = NULL;
+   (table->count)--;
+   table->bytes -= sizeof(Target) + PACKED_SIZE(target->length);
+
+   slabFree(table->allocator, target, sizeof(Target) + PACKED_SIZE(target->length));
+}
+
+size_t internCount(InternTable const *table) {
+   return table->count;
+}
+
+size_t internBytes(InternTable const *table) {
+   return table->bytes + table->capacity * sizeof(Target*);
+}
@@ -0,0 +1,130 @@
+/** @file
+ * Interfejs tablicy współdzielonych numerów docelowych przekierowań.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#ifndef __INTERN_H__
+#define __INTERN_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "slab.h"
+
+/** Rozmiar w bajtach numeru długości @p length upakowanego po 4 bity na cyfrę. */
+#define PACKED_SIZE(length) (((length) + 1) / 2)
+
+/** @struct Target
+ * To jest struktura przechowująca numer docelowy przekierowania.
+ * Każdy numer występuje w tablicy co najwyżej raz, dlatego dwa numery
+ * docelowe są równe wtedy i tylko wtedy, gdy wskaźniki na nie są równe.
+ * Cyfry są upakowane po dwie w bajcie - wcześniejsza w starszych bitach,
+ * '*' jako 10, a '#' jako 11 - a nieużywane bity ostatniego bajtu są
+ * zerami. Porządek bajtów zgadza się więc z porządkiem cyfr.
+ */
+typedef struct Target {
+   size_t references; ///< Liczba przekierowań korzystających z numeru.
+   size_t length;     ///< Długość numeru.
+   uint64_t hash;     ///< Skrót numeru.
+   uint8_t digits[];  ///< Cyfry numeru, po 4 bity.
+} Target;
+
+/** @struct InternTable
+ * To jest struktura tablicy haszującej przechowującej numery docelowe.
+ */
+struct InternTable;
+/** @typedef InternTable
+ * Definicja structury InternTable.
+ */
+typedef struct InternTable InternTable;
+
+/** @brief Tworzy nową tablicę.
+ * Numery docelowe są przydzielane przez alokator @p allocator.
+ * @param[in] allocator – wskaźnik na alokator.
+ * @return Wskaźnik na utworzoną tablicę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+InternTable * internNew(SlabAllocator *allocator);
+
+/** @brief Usuwa tablicę.
+ * Nie zwalnia numerów docelowych - są one zwalniane razem z alokatorem.
+ * Nic nie robi, jeśli wskaźnik @p table ma wartość NULL.
+ * @param[in] table – wskaźnik na usuwaną tablicę.
+ */
+void internDelete(InternTable *table);
+
+/** @brief Udostępnia numer docelowy.
+ * Wyszukuje numer w tablicy, a jeśli go tam nie ma - dodaje go. Zwiększa
+ * liczbę odwołań do numeru.
+ * @param[in,out] table – wskaźnik na tablicę;
+ * @param[in] number    – wskaźnik na numer;
+ * @param[in] length    – długość numeru.
+ * @return Wskaźnik na numer docelowy lub NULL, gdy nie udało się alokować
+ *         pamięci.
+ */
+Target * internAcquire(InternTable *table, char const *number, size_t length);
+
+/** @brief Dodaje odwołanie do numeru docelowego.
+ * @param[in,out] target – wskaźnik na numer docelowy znajdujący się w tablicy.
+ */
+void internRetain(Target *target);
+
+/** @brief Zwalnia odwołanie do numeru docelowego.
+ * Zmniejsza liczbę odwołań do numeru i usuwa go, jeśli była to ostatnia
+ * z nich. Nic nie robi, jeśli wskaźnik @p target ma wartość NULL.
+ * @param[in,out] table – wskaźnik na tablicę;
+ * @param[in] target    – wskaźnik na numer docelowy.
+ */
+void internRelease(InternTable *table, Target *target);
+
+/** @brief Pakuje numer.
+ * @param[out] packed – wskaźnik na bufor rozmiaru @ref PACKED_SIZE(@p length);
+ * @param[in] number  – wskaźnik na numer;
+ * @param[in] length  – długość numeru.
+ */
+void internPack(uint8_t *packed, char const *number, size_t length);
+
+/** @brief Rozpakowuje numer.
+ * Nie dopisuje znaku '\0'.
+ * @param[out] number – wskaźnik na bufor na @p length znaków;
+ * @param[in] packed  – wskaźnik na upakowany numer;
+ * @param[in] length  – długość numeru.
+ */
+void internUnpack(char *number, uint8_t const *packed, size_t length);
+
+/** @brief Sprawdza, czy numer docelowy jest równy numerowi.
+ * @param[in] target – wskaźnik na numer docelowy;
+ * @param[in] number – wskaźnik na numer;
+ * @param[in] length – długość numeru.
+ * @return Wartość @p true, jeśli numery są równe.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool internEqual(Target const *target, char const *number, size_t length);
+
+/** @brief Porównuje początki upakowanych numerów.
+ * Porównuje po 16 cyfr naraz.
+ * @param[in] packed1 – wskaźnik na pierwszy upakowany numer;
+ * @param[in] packed2 – wskaźnik na drugi upakowany numer;
+ * @param[in] length  – liczba porównywanych cyfr (nie większa niż długość
+ *                      żadnego z numerów).
+ * @return Wartość @p true, jeśli pierwsze @p length cyfr numerów jest równe.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool internPackedEqual(uint8_t const *packed1, uint8_t const *packed2, size_t length);
+
+/** @brief Wyznacza liczbę numerów docelowych.
+ * @param[in] table – wskaźnik na tablicę.
+ * @return Liczba różnych numerów docelowych przechowywanych w tablicy.
+ */
+size_t internCount(InternTable const *table);
+
+/** @brief Wyznacza rozmiar tablicy.
+ * @param[in] table – wskaźnik na tablicę.
+ * @return Liczba bajtów zajmowanych przez numery docelowe i miejsca tablicy.
+ */
+size_t internBytes(InternTable const *table);
+
+#endif /* __INTERN_H__ */
@@ -0,0 +1,407 @@
+/** @file
+ * Implementacja iteratora po przeciwobrazach numerów.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "phone_forward.h"
+#include "trie.h"
+#include "frozen.h"
+
+/** Początkowa liczba miejsc w puli przesunięć strumienia @ref IterStream. */
+#define INITIAL_POOL_SIZE 16
+
+/** @struct IterFrame
+ * To jest struktura opisująca wierzchołek na ścieżce przeglądanej przez
+ * strumień @ref IterStream. Oczekujące numery to numery @p x + @p suffix
+ * strumienia, których początek @p x jest przodkiem wierzchołka, a dalsza
+ * część ścieżki zgadza się z początkiem @p suffix - zamiast numeru
+ * pamiętamy długość tego początku. Wierzchołek, do którego prowadzą tylko
+ * oczekujące numery, nie należy do drzewa (pole @p node ma wartość NULL).
+ */
+typedef struct IterFrame {
+   void const *node;    ///< Wierzchołek (Node lub FlatNode) lub NULL.
+   size_t pending;      ///< Położenie przesunięć oczekujących numerów w puli.
+   size_t pendingCount; ///< Liczba oczekujących numerów.
+   unsigned int mask;   ///< Identyfikatory znaków, po których schodzimy niżej.
+   int nextId;          ///< Najmniejszy identyfikator znaku do przejrzenia.
+   bool visited;        ///< Czy rozpatrzono numer kończący się w wierzchołku.
+} IterFrame;
+
+/** @struct IterStream
+ * To jest struktura strumienia numerów @p x + @p suffix, gdzie @p x jest
+ * przekierowany na prefiks numeru, którego przeciwobraz wyznaczamy, a
+ * @p suffix jest resztą tego numeru. Strumień przegląda drzewo numerów @p x
+ * w głąb, wstawiając numer @p x + @p suffix tam, gdzie leżałby w drzewie,
+ * dzięki czemu zwraca numery w porządku rosnącym.
+ */
+typedef struct IterStream {
+   char const *suffix;  ///< Wspólny koniec numerów strumienia.
+   size_t suffixLength; ///< Długość końca numerów.
+   IterFrame *frames;   ///< Stos wierzchołków ścieżki.
+   size_t depth;        ///< Głębokość bieżącego wierzchołka.
+   size_t *pool;        ///< Przesunięcia oczekujących numerów wierzchołków ze stosu.
+   size_t poolCount;    ///< Liczba zajętych miejsc puli.
+   size_t poolSize;     ///< Rozmiar puli.
+   char *buffer;        ///< Ścieżka, a po wyznaczeniu numeru - ten numer.
+   size_t length;       ///< Długość bieżącego numeru.
+   bool finished;       ///< Czy strumień się skończył.
+} IterStream;
+
+struct ReverseIterator {
+   PhoneForward const *pf; ///< Struktura przechowująca przekierowania.
+   Version const *version; ///< Czytana wersja (NULL - iterator zwraca kopię wyniku).
+   size_t slot;            ///< Miejsce zajęte przez @ref beginPinnedRead.
+   PhoneNumbers *copy;     ///< Kopia wyniku lub NULL.
+   size_t copied;          ///< Liczba zwróconych numerów kopii wyniku.
+   Frozen const *frozen;   ///< Postać zamrożona lub NULL.
+   char *num;              ///< Kopia numeru, którego przeciwobraz wyznaczamy.
+   uint8_t *packed;        ///< Upakowany numer.
+   size_t numLength;       ///< Długość numeru.
+   bool numPending;        ///< Czy sam numer nie został jeszcze zwrócony.
+   IterStream *streams;    ///< Strumienie dla kolejnych prefiksów numeru.
+   size_t streamCount;     ///< Liczba strumieni.
+   char *current;          ///< Ostatnio zwrócony numer.
+   size_t currentSize;     ///< Rozmiar bufora na zwracany numer.
+   bool returned;          ///< Czy zwrócono już jakiś numer.
+   size_t remaining;       ///< Liczba numerów, które można jeszcze zwrócić.
+};
+
+/** @brief Rozpoczyna odczyt przekierowań, który może trwać dowolnie długo.
+ * Działa jak @ref beginRead, ale w trybie współbieżnym takich odczytów może
+ * trwać tylko ograniczona liczba, żeby nie zajęły miejsc krótkich odczytów.
+ * @param[in] pf    - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[out] slot - wskaźnik na indeks zajętego miejsca.
+ * @return Wskaźnik na bieżącą wersję lub NULL, jeśli trwa już największa
+ *         liczba takich odczytów.
+ */
+static Version const * beginPinnedRead(PhoneForward const *pf, size_t *slot) {
+   if (!(pf->concurrent))
+      return beginRead(pf, slot);
+   if (!ebrPin(pf->epochs, slot))
+      return NULL;
+   return atomic_load(&(pf->version));
+}
+
+
+/** @brief Kończy odczyt przekierowań rozpoczęty przez @ref beginPinnedRead.
+ * @param[in] pf   - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] slot - indeks miejsca zajętego przez @ref beginPinnedRead.
+ */
+static void endPinnedRead(PhoneForward const *pf, size_t const slot) {
+   if (pf->concurrent)
+      ebrUnpin(pf->epochs, slot);
+}
+
+/** @brief Zwraca mapę bitową synów wierzchołka.
+ * @param[in] frozen - wskaźnik na postać zamrożoną lub NULL.
+ * @param[in] node   - wskaźnik na wierzchołek lub NULL.
+ * @return Mapa bitowa synów (0 dla wierzchołka spoza drzewa).
+ */
+static inline unsigned int iterChildren(Frozen const *frozen, void const *node) {
+   if (node == NULL)
+      return 0;
+   if (frozen != NULL)
+      return ((FlatNode const *)node)->children;
+   return ((Node const *)node)->children;
+}
+
+/** @brief Zwraca syna wierzchołka.
+ * @param[in] frozen - wskaźnik na postać zamrożoną lub NULL.
+ * @param[in] node   - wskaźnik na wierzchołek lub NULL.
+ * @param[in] id     - identyfikator krawędzi prowadzącej do syna.
+ * @return Wskaźnik na syna lub NULL, jeśli taki syn nie istnieje.
+ */
+static inline void const * iterChild(Frozen const *frozen, void const *node, int const id) {
+   if (node == NULL)
+      return NULL;
+   if (frozen != NULL)
+      return frozenChild(frozen, node, id);
+   return getChild(node, id);
+}
+
+/** @brief Sprawdza, czy w wierzchołku kończy się numer przekierowywany.
+ * @param[in] frozen - wskaźnik na postać zamrożoną lub NULL.
+ * @param[in] node   - wskaźnik na wierzchołek.
+ * @return Wartość pola @p isSource wierzchołka.
+ */
+static inline bool iterIsSource(Frozen const *frozen, void const *node) {
+   if (frozen != NULL)
+      return ((FlatNode const *)node)->isSource;
+   return ((Node const *)node)->isSource;
+}
+
+/** @brief Wkłada wierzchołek na stos strumienia.
+ * Oczekujące numery wierzchołka to te oczekujące numery ojca, których
+ * kolejny znak odpowiada wierzchołkowi, oraz numer zaczynający się
+ * w wierzchołku. Przesunięcia są w puli malejące, więc numer kończący się
+ * w wierzchołku jest pierwszy.
+ * @param[in,out] stream - wskaźnik na strumień.
+ * @param[in] frozen     - wskaźnik na postać zamrożoną lub NULL.
+ * @param[in] node       - wskaźnik na wierzchołek lub NULL.
+ * @param[in] depth      - głębokość wierzchołka.
+ * @param[in] id         - identyfikator znaku prowadzącego do wierzchołka
+ *                         (nieużywany dla korzenia).
+ * @return Wartość @p true, jeśli wierzchołek został włożony.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool iterPush(IterStream *stream, Frozen const *frozen, void const *node,
+                     size_t const depth, int const id) {
+   IterFrame const *parent = (depth > 0 ? &((stream->frames)[depth - 1]) : NULL);
+   size_t const limit = stream->poolCount + (parent != NULL ? parent->pendingCount : 0) + 1;
+   if (!reserveArray((void**)&(stream->pool), &(stream->poolSize), limit, sizeof(size_t)))
+      return false;
+
+   IterFrame *frame = &((stream->frames)[depth]);
+   frame->node = node;
+   frame->pending = stream->poolCount;
+   frame->nextId = 0;
+   frame->visited = false;
+   frame->mask = iterChildren(frozen, node);
+   for (size_t i = 0; parent != NULL && i < parent->pendingCount; i++) {
+      size_t const offset = (stream->pool)[parent->pending + i];
+      if (offset < stream->suffixLength && digitID((stream->suffix)[offset]) == id)
+         (stream->pool)[(stream->poolCount)++] = offset + 1;
+   }
+   if (node != NULL && iterIsSource(frozen, node))
+      (stream->pool)[(stream->poolCount)++] = 0;
+   frame->pendingCount = stream->poolCount - frame->pending;
+
+   for (size_t i = 0; i < frame->pendingCount; i++) {
+      size_t const offset = (stream->pool)[frame->pending + i];
+      if (offset < stream->suffixLength)
+         frame->mask |= 1u << digitID((stream->suffix)[offset]);
+   }
+   stream->depth = depth;
+   return true;
+}
+
+/** @brief Wyznacza kolejny numer strumienia.
+ * Numer jest zapisywany w buforze strumienia. Jeśli strumień się skończył,
+ * ustawia pole @p finished.
+ * @param[in,out] stream - wskaźnik na strumień.
+ * @param[in] frozen     - wskaźnik na postać zamrożoną lub NULL.
+ * @return Wartość @p true, jeśli działanie funkcji przebiegło pomyślnie.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool iterAdvance(IterStream *stream, Frozen const *frozen) {
+   while (!(stream->finished)) {
+      size_t const depth = stream->depth;
+      IterFrame *frame = &((stream->frames)[depth]);
+      if (!(frame->visited)) {
+         frame->visited = true;
+         // Numer równy ścieżce poprzedza wszystkie numery z poddrzewa.
+         if (frame->pendingCount > 0
+             && (stream->pool)[frame->pending] == stream->suffixLength) {
+            (stream->buffer)[depth] = '\0';
+            stream->length = depth;
+            return true;
+         }
+      }
+
+      unsigned int const mask = (frame->nextId < NUMBER_OF_SYMBOLS ?
+                                 frame->mask >> frame->nextId : 0);
+      if (mask == 0) {
+         stream->poolCount = frame->pending;
+         if (depth == 0)
+            stream->finished = true;
+         else
+            stream->depth = depth - 1;
+         continue;
+      }
+
+      int const id = frame->nextId + popcount((mask & (~mask + 1)) - 1);
+      frame->nextId = id + 1;
+      void const *child = iterChild(frozen, frame->node, id);
+      if (!iterPush(stream, frozen, child, depth + 1, id))
+         return false;
+
+      IterFrame const *top = &((stream->frames)[depth + 1]);
+      if (child != NULL) {
+         (stream->buffer)[depth] = (frozen != NULL ? ((FlatNode const *)child)->digit
+                                                   : ((Node const *)child)->digit);
+      }
+      else {
+         // Wierzchołek spoza drzewa - znak wyznacza oczekujący numer.
+         size_t const offset = (stream->pool)[top->pending];
+         (stream->buffer)[depth] = (stream->suffix)[offset - 1];
+      }
+   }
+   return true;
+}
+
+/** @brief Tworzy strumień numerów przekierowanych na prefiks numeru.
+ * @param[out] stream  - wskaźnik na strumień.
+ * @param[in] frozen   - wskaźnik na postać zamrożoną lub NULL.
+ * @param[in] sources  - wskaźnik na wierzchołek, od którego zaczynają się
+ *                       numery przekierowane na prefiks.
+ * @param[in] suffix   - wskaźnik na resztę numeru.
+ * @param[in] suffixLength   - długość reszty numeru.
+ * @param[in] maxSourceLength - długość najdłuższego numeru przekierowywanego.
+ * @return Wartość @p true, jeśli strumień został utworzony i wyznaczył
+ *         pierwszy numer.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool iterStreamInit(IterStream *stream, Frozen const *frozen, void const *sources,
+                           char const *suffix, size_t const suffixLength,
+                           size_t const maxSourceLength) {
+   size_t const maxDepth = maxSourceLength + suffixLength;
+   memset(stream, 0, sizeof(IterStream));
+   stream->suffix = suffix;
+   stream->suffixLength = suffixLength;
+   stream->frames = malloc((maxDepth + 1) * sizeof(IterFrame));
+   stream->buffer = malloc(maxDepth + 1);
+   stream->poolSize = INITIAL_POOL_SIZE;
+   stream->pool = malloc(stream->poolSize * sizeof(size_t));
+   return (stream->frames != NULL && stream->buffer != NULL && stream->pool != NULL
+           && iterPush(stream, frozen, sources, 0, 0) && iterAdvance(stream, frozen));
+}
+
+void phfwdReverseIterDelete(ReverseIterator *it) {
+   if (it == NULL)
+      return;
+
+   for (size_t i = 0; i < it->streamCount; i++) {
+      free((it->streams)[i].frames);
+      free((it->streams)[i].pool);
+      free((it->streams)[i].buffer);
+   }
+   free(it->streams);
+   it->streams = NULL;
+   free(it->num);
+   it->num = NULL;
+   free(it->packed);
+   it->packed = NULL;
+   free(it->current);
+   it->current = NULL;
+   phnumDelete(it->copy);
+   it->copy = NULL;
+   if (it->version != NULL)
+      endPinnedRead(it->pf, it->slot);
+   free(it);
+   it = NULL;
+}
+
+ReverseIterator * phfwdReverseIter(PhoneForward const *pf, char const *num, size_t const limit) {
+   if (pf == NULL)
+      return NULL;
+
+   ReverseIterator *it = calloc(1, sizeof(ReverseIterator));
+   if (it == NULL)
+      return NULL;
+   it->pf = pf;
+   it->numLength = numberLength(num);
+   if (it->numLength == 0) // Pusty iterator.
+      return it;
+   it->remaining = (limit == 0 ? SIZE_MAX : limit);
+
+   // Gdy trwa już najwięcej odczytów iteratorów, iterator nie zajmuje
+   // miejsca - od razu wyznacza cały wynik i zwraca jego kopię.
+   it->version = beginPinnedRead(pf, &(it->slot));
+   if (it->version == NULL) {
+      it->copy = phfwdReverse(pf, num);
+      if (it->copy == NULL) {
+         phfwdReverseIterDelete(it);
+         return NULL;
+      }
+      return it;
+   }
+   it->frozen = pf->frozen;
+   it->numPending = true;
+   it->num = malloc(it->numLength + 1);
+   it->packed = malloc(PACKED_SIZE(it->numLength));
+   it->streams = malloc(it->numLength * sizeof(IterStream));
+   bool success = (it->num != NULL && it->packed != NULL && it->streams != NULL
+                   && reallocNumber(&(it->current), it->numLength));
+   if (success) {
+      memcpy(it->num, num, it->numLength + 1);
+      internPack(it->packed, num, it->numLength);
+      it->currentSize = it->numLength + 1;
+   }
+
+   Frozen const *frozen = it->frozen;
+   size_t const maxSourceLength = (frozen != NULL ? frozen->maxSourceLength
+                                                  : it->version->maxSourceLength);
+   void const *node = (frozen != NULL ? (void const *)&((frozen->nodes)[frozen->reverse])
+                                      : (void const *)(it->version->reverse));
+   for (size_t position = 0; position < it->numLength && node != NULL && success; position++) {
+      node = iterChild(frozen, node, digitID(num[position]));
+      void const *sources = iterChild(frozen, node, digitID(SEPARATOR));
+      if (sources == NULL)
+         continue;
+      IterStream *stream = &((it->streams)[(it->streamCount)++]);
+      success = iterStreamInit(stream, frozen, sources, it->num + position + 1,
+                               it->numLength - position - 1, maxSourceLength);
+   }
+
+   if (!success) {
+      phfwdReverseIterDelete(it);
+      return NULL;
+   }
+   return it;
+}
+
+char const * phfwdReverseNext(ReverseIterator *it) {
+   if (it == NULL)
+      return NULL;
+   if (it->copy != NULL) {
+      char const *number = (it->remaining > 0 ? phnumGet(it->copy, it->copied) : NULL);
+      if (number == NULL) {
+         it->remaining = 0;
+         return NULL;
+      }
+      (it->copied)++;
+      (it->remaining)--;
+      return number;
+   }
+
+   while (it->remaining > 0) {
+      // Najmniejszy z pierwszych numerów strumieni i samego numeru.
+      char const *best = (it->numPending ? it->num : NULL);
+      size_t bestLength = it->numLength;
+      IterStream *from = NULL;
+      for (size_t i = 0; i < it->streamCount; i++) {
+         IterStream *stream = &((it->streams)[i]);
+         if (!(stream->finished)
+             && (best == NULL || numberComparator(stream->buffer, best) < 0)) {
+            best = stream->buffer;
+            bestLength = stream->length;
+            from = stream;
+         }
+      }
+      if (best == NULL)
+         break;
+
+      bool const duplicate = (it->returned && strcmp(best, it->current) == 0);
+      // Nieaktualne pary indeksu odwrotnego nie są wynikiem.
+      bool const stale = (from != NULL && it->frozen == NULL
+                          && (it->version->staleReverse || it->version->erasing)
+                          && !isForwardedTo(it->version->node, best, bestLength,
+                                            it->num, it->packed, it->numLength, false));
+      bool const accepted = (!duplicate && !stale);
+      if (accepted) {
+         if (bestLength + 1 > it->currentSize) {
+            if (!reallocNumber(&(it->current), bestLength))
+               break;
+            it->currentSize = bestLength + 1;
+         }
+         memcpy(it->current, best, bestLength + 1);
+      }
+
+      if (from == NULL)
+         it->numPending = false;
+      else if (!iterAdvance(from, it->frozen))
+         break;
+      if (accepted) {
+         it->returned = true;
+         (it->remaining)--;
+         return it->current;
+      }
+   }
+   it->remaining = 0;
+   return NULL;
+}
@@ -0,0 +1,369 @@
+/** @file
+ * Implementacja dziennika zmian przekierowań zapisywanego przed ich
+ * wykonaniem.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "journal.h"
+
+/** Znacznik początku pliku z dziennikiem. */
+#define JOURNAL_MAGIC "PHFWDLOG"
+
+/** Wersja formatu dziennika. Zmienia się przy każdej zmianie układu pliku. */
+#define JOURNAL_VERSION 1
+
+/** Wartość, po której odczytaniu rozpoznajemy kolejność bajtów zapisującego. */
+#define JOURNAL_BYTE_ORDER 0x01020304u
+
+/** Początkowy rozmiar bufora zmian w bajtach. */
+#define INITIAL_BUFFER_SIZE 4096
+
+/** Podstawa skrótu FNV-1a. */
+#define FNV_OFFSET 14695981039346656037ULL
+/** Mnożnik skrótu FNV-1a. */
+#define FNV_PRIME 1099511628211ULL
+
+/** @struct JournalHeader
+ * To jest struktura nagłówka pliku z dziennikiem.
+ */
+typedef struct JournalHeader {
+   char magic[8];      ///< Znacznik @ref JOURNAL_MAGIC bez znaku '\0'.
+   uint32_t version;   ///< Wersja formatu.
+   uint32_t byteOrder; ///< Wartość @ref JOURNAL_BYTE_ORDER.
+} JournalHeader;
+
+/** @struct RecordHeader
+ * To jest struktura nagłówka zmiany zapisanej w dzienniku.
+ * Za nagłówkiem leżą znaki numeru przekierowywanego, a po nich - numeru
+ * docelowego. Usunięcie przekierowań ma numer docelowy długości 0.
+ */
+typedef struct RecordHeader {
+   uint64_t checksum;     ///< Skrót długości i znaków numerów.
+   uint32_t sourceLength; ///< Długość numeru przekierowywanego.
+   uint32_t targetLength; ///< Długość numeru docelowego.
+} RecordHeader;
+
+struct Journal {
+   int descriptor; ///< Deskryptor pliku.
+   char *buffer;   ///< Zmiany, które nie zostały jeszcze zapisane do pliku.
+   size_t used;    ///< Liczba zajętych bajtów bufora.
+   size_t size;    ///< Rozmiar bufora.
+   size_t pending; ///< Liczba zmian w buforze.
+   size_t batch;   ///< Liczba zmian utrwalanych jednym wywołaniem fdatasync.
+   bool failed;    ///< Czy dziennik jest w stanie błędu.
+};
+
+/** @brief Wyznacza skrót zmiany.
+ * @param[in] header - wskaźnik na nagłówek zmiany.
+ * @param[in] chars  - wskaźnik na znaki numerów.
+ * @return Skrót FNV-1a długości i znaków numerów.
+ */
+static uint64_t recordChecksum(RecordHeader const *header, char const *chars) {
+   uint32_t const lengths[2] = {header->sourceLength, header->targetLength};
+   unsigned char const *bytes = (unsigned char const *)lengths;
+   uint64_t hash = FNV_OFFSET;
+   for (size_t i = 0; i < sizeof(lengths); i++) {
+      hash ^= bytes[i];
+      hash *= FNV_PRIME;
+   }
+   size_t const length = (size_t)(header->sourceLength) + header->targetLength;
+   for (size_t i = 0; i < length; i++) {
+      hash ^= (unsigned char)chars[i];
+      hash *= FNV_PRIME;
+   }
+   return hash;
+}
+
+/** @brief Zapewnia, że bufor pomieści podaną liczbę bajtów.
+ * @param[in,out] journal - wskaźnik na dziennik.
+ * @param[in] size        - wymagany rozmiar bufora.
+ * @return Wartość @p true, jeśli bufor jest wystarczająco duży.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool reserve(Journal *journal, size_t const size) {
+   if (size <= journal->size)
+      return true;
+   size_t newSize = journal->size;
+   while (newSize < size)
+      newSize *= 2;
+   char *buffer = realloc(journal->buffer, newSize);
+   if (buffer == NULL)
+      return false;
+   journal->buffer = buffer;
+   journal->size = newSize;
+   return true;
+}
+
+/** @brief Zapisuje dane do pliku.
+ * @param[in] descriptor - deskryptor pliku.
+ * @param[in] data       - wskaźnik na dane.
+ * @param[in] size       - rozmiar danych w bajtach.
+ * @return Wartość @p true, jeśli zapisano wszystkie dane.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool writeAll(int const descriptor, void const *data, size_t size) {
+   char const *bytes = data;
+   while (size > 0) {
+      ssize_t const written = write(descriptor, bytes, size);
+      if (written < 0 && errno == EINTR)
+         continue;
+      if (written <= 0)
+         return false;
+      bytes += written;
+      size -= (size_t)written;
+   }
+   return true;
+}
+
+/** @brief Zapisuje bufor do pliku i go utrwala.
+ * Jedno wywołanie fdatasync utrwala wszystkie zmiany z bufora.
+ * @param[in,out] journal - wskaźnik na dziennik.
+ * @return Wartość @p true, jeśli zmiany zostały utrwalone.
+ *         Wartość @p false, jeśli wystąpił błąd zapisu.
+ */
+static bool flush(Journal *journal) {
+   if (journal->used > 0
+       && (!writeAll(journal->descriptor, journal->buffer, journal->used)
+           || fdatasync(journal->descriptor) != 0))
+      journal->failed = true;
+   journal->used = 0;
+   journal->pending = 0;
+   return !(journal->failed);
+}
+
+/** @brief Wypełnia nagłówek pliku z dziennikiem.
+ * @param[out] header - wskaźnik na nagłówek.
+ */
+static void initHeader(JournalHeader *header) {
+   memset(header, 0, sizeof(JournalHeader));
+   memcpy(header->magic, JOURNAL_MAGIC, sizeof(header->magic));
+   header->version = JOURNAL_VERSION;
+   header->byteOrder = JOURNAL_BYTE_ORDER;
+}
+
+/** @brief Wykonuje zmiany zapisane w pliku.
+ * Czyta zmiany po kolei aż do końca pliku albo pierwszej niepełnej lub
+ * uszkodzonej zmiany.
+ * @param[in,out] journal - wskaźnik na dziennik, którego bufor przechowuje
+ *                          odczytywane numery.
+ * @param[in] file        - plik ustawiony za nagłówkiem.
+ * @param[in] size        - rozmiar pliku w bajtach.
+ * @param[in] replay      - funkcja wykonująca zmiany.
+ * @param[in] context     - pierwszy argument funkcji @p replay.
+ * @param[out] valid      - wskaźnik na miejsce, gdzie zapisywany jest rozmiar
+ *                          początku pliku zawierającego poprawne zmiany.
+ * @return Wartość @p true, jeśli wykonano wszystkie poprawne zmiany.
+ *         Wartość @p false, jeśli nie udało się wykonać zmiany lub alokować
+ *         pamięci.
+ */
+static bool replayRecords(Journal *journal, FILE *file, uint64_t const size,
+                          JournalReplay replay, void *context, uint64_t *valid) {
+   RecordHeader header;
+   *valid = sizeof(JournalHeader);
+   while (fread(&header, sizeof(RecordHeader), 1, file) == 1) {
+      uint64_t const length = (uint64_t)(header.sourceLength) + header.targetLength;
+      // Długość z uszkodzonego nagłówka mogłaby przekraczać rozmiar pliku.
+      if (header.sourceLength == 0 || length > size - *valid - sizeof(RecordHeader))
+         break;
+      if (!reserve(journal, (size_t)length + 2))
+         return false;
+
+      char *chars = journal->buffer;
+      if (fread(chars, 1, (size_t)length, file) != length
+          || recordChecksum(&header, chars) != header.checksum)
+         break;
+
+      // Numery są rozdzielane znakami '\0', więc numer docelowy przesuwamy.
+      char *target = chars + header.sourceLength + 1;
+      memmove(target, chars + header.sourceLength, header.targetLength);
+      chars[header.sourceLength] = '\0';
+      target[header.targetLength] = '\0';
+      if (!replay(context, chars, (header.targetLength > 0 ? target : NULL)))
+         return false;
+      *valid += sizeof(RecordHeader) + length;
+   }
+   return true;
+}
+
+/** @brief Czyta i wykonuje zawartość pliku z dziennikiem.
+ * @param[in,out] journal - wskaźnik na dziennik z otwartym plikiem.
+ * @param[in] replay      - funkcja wykonująca zmiany.
+ * @param[in] context     - pierwszy argument funkcji @p replay.
+ * @param[out] valid      - wskaźnik na miejsce, gdzie zapisywany jest rozmiar
+ *                          poprawnego początku pliku (0, jeśli plik nie ma
+ *                          jeszcze pełnego nagłówka).
+ * @return Wartość @p true, jeśli plik jest dziennikiem i wykonano wszystkie
+ *         jego poprawne zmiany.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool readJournal(Journal *journal, JournalReplay replay, void *context,
+                        uint64_t *valid) {
+   struct stat status;
+   int const descriptor = dup(journal->descriptor);
+   FILE *file = (descriptor >= 0 ? fdopen(descriptor, "rb") : NULL);
+   if (file == NULL) {
+      if (descriptor >= 0)
+         close(descriptor);
+      return false;
+   }
+
+   JournalHeader expected, header;
+   initHeader(&expected);
+   bool success = (fstat(journal->descriptor, &status) == 0);
+   uint64_t const size = (success ? (uint64_t)(status.st_size) : 0);
+   size_t const read = (success ? fread(&header, 1, sizeof(JournalHeader), file) : 0);
+   *valid = 0;
+   if (read < sizeof(JournalHeader)) {
+      // Plik utworzony przez przerwane otwarcie dziennika - zaczynamy od nowa.
+      success = success && memcmp(&header, &expected, read) == 0;
+   }
+   else if (memcmp(&header, &expected, sizeof(JournalHeader)) != 0) {
+      success = false;
+   }
+   else {
+      success = replayRecords(journal, file, size, replay, context, valid);
+   }
+   fclose(file);
+   return success;
+}
+
+Journal * journalOpen(char const *path, size_t const batch, JournalReplay replay,
+                      void *context) {
+   if (path == NULL || batch == 0 || replay == NULL)
+      return NULL;
+
+   Journal *journal = calloc(1, sizeof(Journal));
+   if (journal == NULL)
+      return NULL;
+   journal->batch = batch;
+   journal->size = INITIAL_BUFFER_SIZE;
+   journal->buffer = malloc(journal->size);
+   journal->descriptor = open(path, O_RDWR | O_CREAT, 0644);
+
+   uint64_t valid = 0;
+   bool success = (journal->buffer != NULL && journal->descriptor >= 0
+                   && readJournal(journal, replay, context, &valid));
+   if (success && valid == 0) {
+      JournalHeader header;
+      initHeader(&header);
+      valid = sizeof(JournalHeader);
+      success = (ftruncate(journal->descriptor, 0) == 0
+                 && lseek(journal->descriptor, 0, SEEK_SET) == 0
+                 && writeAll(journal->descriptor, &header, sizeof(JournalHeader))
+                 && fdatasync(journal->descriptor) == 0
+                 && journalSyncDirectory(path));
+   }
+   else if (success) {
+      // Usuwamy końcówkę pozostawioną przez przerwany zapis, żeby kolejne
+      // zmiany nie trafiły za nią.
+      struct stat status;
+      success = (fstat(journal->descriptor, &status) == 0
+                 && ((uint64_t)(status.st_size) == valid
+                     || (ftruncate(journal->descriptor, (off_t)valid) == 0
+                         && fdatasync(journal->descriptor) == 0))
+                 && lseek(journal->descriptor, (off_t)valid, SEEK_SET) == (off_t)valid);
+   }
+
+   if (!success) {
+      if (journal->descriptor >= 0)
+         close(journal->descriptor);
+      free(journal->buffer);
+      free(journal);
+      return NULL;
+   }
+   return journal;
+}
+
+bool journalClose(Journal *journal) {
+   if (journal == NULL)
+      return true;
+
+   bool const success = flush(journal);
+   close(journal->descriptor);
+   free(journal->buffer);
+   journal->buffer = NULL;
+   free(journal);
+   journal = NULL;
+   return success;
+}
+
+bool journalAppend(Journal *journal, char const *num1, size_t const length1,
+                   char const *num2, size_t const length2) {
+   if (journal->failed)
+      return false;
+   if (length1 > UINT32_MAX || length2 > UINT32_MAX
+       || !reserve(journal, journal->used + sizeof(RecordHeader) + length1 + length2)) {
+      journal->failed = true;
+      return false;
+   }
+
+   RecordHeader header;
+   header.sourceLength = (uint32_t)length1;
+   header.targetLength = (uint32_t)length2;
+   char *record = journal->buffer + journal->used;
+   char *chars = record + sizeof(RecordHeader);
+   memcpy(chars, num1, length1);
+   if (length2 > 0)
+      memcpy(chars + length1, num2, length2);
+   header.checksum = recordChecksum(&header, chars);
+   memcpy(record, &header, sizeof(RecordHeader));
+   journal->used += sizeof(RecordHeader) + length1 + length2;
+
+   if (++(journal->pending) >= journal->batch)
+      return flush(journal);
+   return true;
+}
+
+void journalFail(Journal *journal) {
+   journal->failed = true;
+}
+
+bool journalSync(Journal *journal) {
+   if (journal->failed)
+      return false;
+   return flush(journal);
+}
+
+bool journalTruncate(Journal *journal) {
+   journal->used = 0;
+   journal->pending = 0;
+   off_t const start = (off_t)sizeof(JournalHeader);
+   journal->failed = !(ftruncate(journal->descriptor, start) == 0
+                       && lseek(journal->descriptor, start, SEEK_SET) == start
+                       && fdatasync(journal->descriptor) == 0);
+   return !(journal->failed);
+}
+
+bool journalSyncDirectory(char const *path) {
+   char const *slash = strrchr(path, '/');
+   size_t const length = (slash == NULL ? 1 : (slash == path ? 1 : (size_t)(slash - path)));
+   char *directory = malloc(length + 1);
+   if (directory == NULL)
+      return false;
+   if (slash == NULL)
+      directory[0] = '.';
+   else
+      memcpy(directory, path, length);
+   directory[length] = '\0';
+
+   int const descriptor = open(directory, O_RDONLY);
+   free(directory);
+   if (descriptor < 0)
+      return false;
+   bool const success = (fsync(descriptor) == 0);
+   close(descriptor);
+   return success;
+}
@@ -0,0 +1,110 @@
+/** @file
+ * Interfejs dziennika zmian przekierowań zapisywanego przed ich wykonaniem
+ * (ang. write-ahead log).
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @struct Journal
+ * To jest struktura dziennika zmian.
+ * Zmiany są dopisywane do bufora w pamięci i zapisywane do pliku grupami,
+ * a każda grupa jest utrwalana jednym wywołaniem fdatasync.
+ */
+struct Journal;
+/** @typedef Journal
+ * Definicja structury Journal.
+ */
+typedef struct Journal Journal;
+
+/** @typedef JournalReplay
+ * Funkcja wykonująca zmianę odczytaną z dziennika. Dla dodania
+ * przekierowania @p num1 jest numerem przekierowywanym, a @p num2 -
+ * docelowym. Dla usunięcia przekierowań @p num2 ma wartość NULL.
+ * Zwraca wartość @p false, jeśli nie udało się wykonać zmiany.
+ */
+typedef bool (*JournalReplay)(void *context, char const *num1, char const *num2);
+
+/** @brief Otwiera dziennik.
+ * Tworzy plik, jeśli go nie ma. W przeciwnym przypadku wykonuje po kolei
+ * wszystkie zapisane w nim zmiany, a niepełną lub uszkodzoną końcówkę pliku,
+ * pozostawioną przez przerwany zapis, usuwa.
+ * @param[in] path    – ścieżka do pliku;
+ * @param[in] batch   – liczba zmian utrwalanych jednym wywołaniem fdatasync
+ *                      (dodatnia);
+ * @param[in] replay  – funkcja wykonująca zmiany odczytane z pliku;
+ * @param[in] context – pierwszy argument funkcji @p replay.
+ * @return Wskaźnik na otwarty dziennik lub NULL, gdy nie udało się otworzyć
+ *         pliku, plik nie jest dziennikiem, nie udało się wykonać którejś ze
+ *         zmian albo alokować pamięci.
+ */
+Journal * journalOpen(char const *path, size_t batch, JournalReplay replay,
+                      void *context);
+
+/** @brief Zamyka dziennik.
+ * Utrwala zmiany czekające w buforze i zwalnia dziennik.
+ * Nic nie robi, jeśli wskaźnik @p journal ma wartość NULL.
+ * @param[in] journal – wskaźnik na zamykany dziennik.
+ * @return Wartość @p true, jeśli wszystkie zmiany zostały utrwalone.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool journalClose(Journal *journal);
+
+/** @brief Dopisuje zmianę do dziennika.
+ * Zmiana trafia do bufora, a co @p batch zmian bufor jest zapisywany do pliku
+ * i utrwalany. Po pierwszym błędzie dziennik przestaje zapisywać zmiany aż
+ * do wywołania @ref journalTruncate, bo kolejne zmiany nie dałyby się
+ * odtworzyć bez utraconej.
+ * @param[in,out] journal – wskaźnik na dziennik;
+ * @param[in] num1        – numer przekierowywany lub usuwany prefiks;
+ * @param[in] length1     – długość numeru @p num1;
+ * @param[in] num2        – numer docelowy lub NULL dla usunięcia;
+ * @param[in] length2     – długość numeru @p num2 (0 dla usunięcia).
+ * @return Wartość @p true, jeśli zmiana została dopisana.
+ *         Wartość @p false, jeśli dziennik jest w stanie błędu.
+ */
+bool journalAppend(Journal *journal, char const *num1, size_t length1,
+                   char const *num2, size_t length2);
+
+/** @brief Oznacza dziennik jako niezgodny ze strukturą.
+ * Służy do zgłoszenia zmiany, której nie da się zapisać w dzienniku, np.
+ * częściowo wykonanej. Dziennik pozostaje w stanie błędu aż do wywołania
+ * @ref journalTruncate.
+ * @param[in,out] journal – wskaźnik na dziennik.
+ */
+void journalFail(Journal *journal);
+
+/** @brief Utrwala zmiany czekające w buforze.
+ * @param[in,out] journal – wskaźnik na dziennik.
+ * @return Wartość @p true, jeśli wszystkie dopisane zmiany są utrwalone.
+ *         Wartość @p false, jeśli dziennik jest w stanie błędu.
+ */
+bool journalSync(Journal *journal);
+
+/** @brief Opróżnia dziennik.
+ * Odrzuca zmiany czekające w buforze i usuwa zmiany zapisane w pliku.
+ * Wywoływana po utrwaleniu migawki, która zawiera wszystkie te zmiany.
+ * Kończy stan błędu dziennika, jeśli plik udało się opróżnić.
+ * @param[in,out] journal – wskaźnik na dziennik.
+ * @return Wartość @p true, jeśli dziennik został opróżniony.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool journalTruncate(Journal *journal);
+
+/** @brief Utrwala wpis katalogu zawierającego plik.
+ * Po utworzeniu pliku lub zmianie jego nazwy dopiero utrwalenie katalogu
+ * gwarantuje, że plik będzie widoczny pod nową nazwą po awarii systemu.
+ * @param[in] path – ścieżka do pliku.
+ * @return Wartość @p true, jeśli katalog został utrwalony.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool journalSyncDirectory(char const *path);
+
+#endif /* __JOURNAL_H__ */
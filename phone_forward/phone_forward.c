@@ -6,9 +6,27 @@
  * @date 2022
  */
  
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
 #include "phone_forward.h"
+#include "slab.h"
+#include "intern.h"
+#include "journal.h"
+#include "cache.h"
+#include "share.h"
+#include "trie.h"
+#include "frozen.h"
+#include "snapshot.h"
+#include "ebr.h"
+#include "reclaim.h"
 
 /** Początkowa wielkość tablicy.
  * Wynikiem funkcji @ref phfwdGet jest struktura @p PhoneNumbers zawierająca co
@@ -16,41 +34,19 @@
  */
 #define INITIAL_SIZE_OF_THE_ARRAY 1
 
-/** Liczba cyfr.
- * Numer składa się z cyfr 0..9, *, #.
- */
-#define NUMBER_OF_DIGITS 12
-
-/** @brief Sprawdza, czy podany znak jest cyfrą numeru.
- * @param[in] digit - znak, dla którego sprawdzamy poprawność.
- * @return Wartość @p true, jeśli podany znak jest cyfrą numeru.
- *         Wartość @p false, w przeciwnym przypadku.
- */
-static bool isDigit(char const digit) {
-   return (digit >= '0' && digit <= '9') || digit == '*' || digit == '#';
-}
-
-/** @brief Zwraca identyfikator znaku.
- * Zwraca identyfikator znaku zgodnie z treścią zadania - cyfry 0..9 
- * reprezentują same siebie, * reprezentuje cyfrę 10, # reprezentuje cyfrę 11.
- * @param[in] digit - znak, dla którego wyznaczamy identyfikator.
- * @return Identyfikator znaku.
- */
-static int digitID(char const digit) {
-   if (digit == '*')
-      return 10;
-   if (digit == '#')
-      return 11;
-   return digit - '0';
-}
-
-/** @brief Wyznacza długość numeru.
- * @param[in] number - wskaźnik na napis reprezentujący numer.
- * @return Długość napisu reprezentującego numer telefonu
- *         (jeżeli wskaźnik na napis ma wartość NULL lub podany 
- *         napis nie jest poprawnym numerem, to zwraca 0).
- */
-static size_t numberLength(char const *number) {
+#ifdef PHONE_FORWARD_STATS
+/** Rozpoczyna pomiar czasu operacji - deklaruje zmienną @p start. */
+#define TIMER_START(start) uint64_t const start = nanoseconds()
+/** Kończy pomiar czasu operacji i zapisuje go w statystykach struktury. */
+#define TIMER_STOP(pf, operation, start) recordLatency((pf), (operation), (start))
+#else
+/** Bez makra @p PHONE_FORWARD_STATS czas operacji nie jest mierzony. */
+#define TIMER_START(start) ((void)0)
+/** Bez makra @p PHONE_FORWARD_STATS czas operacji nie jest mierzony. */
+#define TIMER_STOP(pf, operation, start) ((void)0)
+#endif
+
+size_t numberLength(char const *number) {
    if (number == NULL)
       return 0;
    
@@ -63,15 +59,7 @@ static size_t numberLength(char const *number) {
    return length;
 }
 
-/** @brief Zmienia długość numeru.
- * Alokuje odpowiednią ilość pamięci, tak żeby @p number przechowywał 
- * wskaźnik na numer długości @p length. 
- * @param[in,out] number - wskaźnik na numer.
- * @param[in] length     - docelowa długość numeru.
- * @return Wartość @p true, jeśli alokacja pamięci się powiodła.
- *         Wartość @p false, w przeciwnym przypadku.
- */
-static bool reallocNumber(char **number, size_t const length) {
+bool reallocNumber(char **number, size_t const length) {
    if (*number == NULL) {
       *number = malloc((length + 1) * sizeof(char));
       if (*number == NULL)
@@ -87,128 +75,318 @@ static bool reallocNumber(char **number, size_t const length) {
    return true;
 }
 
-/** @brief Porównuje dwa numery.
- * @param[in] number1 - wskaźnik na pierwszy numer.
- * @param[in] number2 - wskaźnik na drugi numer.
- * @return Wartość @p -1, jeśli pierwszy numer jest mniejszy leksykograficznie.
- *         Wartość @p 0, jeśli podane numery są równe.
- *         Wartość @p 1, jeśli drugi numer jest mniejszy leksykograficznie.
- */
-static int numberComparator(char const **number1, char const **number2) {
+int numberComparator(char const *number1, char const *number2) {
    size_t pos = 0;
-   while ((*number1)[pos] != '\0' && (*number2)[pos] != '\0') {
-      if (digitID((*number1)[pos]) < digitID((*number2)[pos]))
+   while (number1[pos] != '\0' && number2[pos] != '\0') {
+      if (digitID(number1[pos]) < digitID(number2[pos]))
          return -1;
-      if (digitID((*number1)[pos]) > digitID((*number2)[pos]))
+      if (digitID(number1[pos]) > digitID(number2[pos]))
          return 1;
       pos++;
    }
 
-   if ((*number1)[pos] == '\0' && (*number2)[pos] == '\0')
+   if (number1[pos] == '\0' && number2[pos] == '\0')
       return 0;
-   return ((*number1)[pos] == '\0' ? -1 : 1);
+   return (number1[pos] == '\0' ? -1 : 1);
 }
 
-struct PhoneNumbers {
-   size_t size;      ///< Rozmiar tablicy.
-   size_t count;     ///< Liczba elementów w tablicy.
-   char **numbers;   ///< Tablica numerów.
-};
-
-/** @brief Tworzy nową strukturę.
- * Tworzy nową strukturę niezawierającą żadnych numerów.
- * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
- *         alokować pamięci.
- */
-static PhoneNumbers * phnumCreate(void) {
+PhoneNumbers * phnumCreate(void) {
    PhoneNumbers *pnum;
    pnum = malloc(sizeof(PhoneNumbers));
    if (pnum == NULL)
       return NULL;
    
-   pnum->size = INITIAL_SIZE_OF_THE_ARRAY;
+   pnum->chars = NULL;
+   pnum->charsCount = 0;
+   pnum->charsSize = 0;
+   pnum->numbers = NULL;
    pnum->count = 0;
-   pnum->numbers = malloc((pnum->size) * sizeof(char*));
-   if (pnum->numbers == NULL) {
-      free(pnum);
-      pnum = NULL;
-      return NULL;
-   }
-   
+   pnum->size = 0;
    return pnum;
 }
 
+bool reserveArray(void **array, size_t *size, size_t const needed,
+                  size_t const elementSize) {
+   if (needed <= *size)
+      return true;
+
+   size_t newSize = (*size == 0 ? INITIAL_SIZE_OF_THE_ARRAY : *size);
+   while (newSize < needed)
+      newSize *= 2;
+   void *indicator = realloc(*array, newSize * elementSize);
+   if (indicator == NULL)
+      return false;
+   *array = indicator;
+   *size = newSize;
+   return true;
+}
+
+bool phnumWrite(PhoneNumbers *pnum, char const *prefix, size_t const prefixLength,
+                char const *suffix, size_t const suffixLength, NumberRef *ref) {
+   size_t const length = prefixLength + suffixLength;
+   if (!reserveArray((void**)&(pnum->chars), &(pnum->charsSize), 
+                     pnum->charsCount + length + 1, sizeof(char)))
+      return false;
+
+   char *number = pnum->chars + pnum->charsCount;
+   if (prefix != NULL && prefixLength > 0)
+      memcpy(number, prefix, prefixLength);
+   if (suffixLength > 0)
+      memcpy(number + prefixLength, suffix, suffixLength);
+   number[length] = '\0';
+
+   ref->offset = pnum->charsCount;
+   pnum->charsCount += length + 1;
+   return true;
+}
+
+bool phnumWriteForward(PhoneNumbers *pnum, Target const *forward, char const *suffix,
+                       size_t const suffixLength, NumberRef *ref) {
+   if (forward == NULL)
+      return phnumWrite(pnum, NULL, 0, suffix, suffixLength, ref);
+   if (!phnumWrite(pnum, NULL, forward->length, suffix, suffixLength, ref))
+      return false;
+   internUnpack(pnum->chars + ref->offset, forward->digits, forward->length);
+   return true;
+}
+
 /** @brief Dodaje numer.
- * Dodaje numer do struktury.
- * @param[in,out] pnum - wskaźnik na strukturę przechowującą numery.
- * @param[in] number   - wskaźnik na napis reprezentujący numer.
- * @param[in] length   - długość numeru.
+ * Dodaje do struktury numer powstały ze sklejenia napisów @p prefix
+ * i @p suffix. Numer jest zapisywany bezpośrednio w tablicy znaków struktury.
+ * @param[in,out] pnum     - wskaźnik na strukturę przechowującą numery.
+ * @param[in] prefix       - wskaźnik na początek numeru.
+ * @param[in] prefixLength - długość początku numeru.
+ * @param[in] suffix       - wskaźnik na koniec numeru.
+ * @param[in] suffixLength - długość końca numeru.
  * @return Wartość @p true, jeśli numer został dodany.
  *         Wartość @p false, jeśli wystąpił błąd, np. wskaźnik @p pnum
  *         ma wartość NULL lub nie udało się alokować pamięci.
  */
-static bool phnumAdd(PhoneNumbers *pnum, 
-                     char const *number, size_t const length) {
-   if (pnum == NULL || length == 0)
+static bool phnumAdd(PhoneNumbers *pnum, char const *prefix, size_t const prefixLength,
+                     char const *suffix, size_t const suffixLength) {
+   if (pnum == NULL || prefixLength + suffixLength == 0)
       return false;
    
-   if (pnum->size == pnum->count) {
-      char **indicator;
-      indicator = realloc(pnum->numbers, 2 * (pnum->size) * sizeof(char*));
-      if (indicator == NULL)
-         return false;
-      pnum->size *= 2;
-      pnum->numbers = indicator;
-   }
-
-   (pnum->numbers)[pnum->count] = NULL;
-   if (!reallocNumber(&((pnum->numbers)[pnum->count]), length))
+   if (!reserveArray((void**)&(pnum->numbers), &(pnum->size), pnum->count + 1, 
+                     sizeof(NumberRef))
+       || !phnumWrite(pnum, prefix, prefixLength, suffix, suffixLength, 
+                      &((pnum->numbers)[pnum->count])))
       return false;
 
-   for (size_t i = 0; i <= length; i++)
-      (pnum->numbers)[pnum->count][i] = number[i];
+   (pnum->count)++;
+   return true;
+}
+
+/** @brief Dodaje numer zaczynający się od numeru docelowego.
+ * @param[in,out] pnum     - wskaźnik na strukturę przechowującą numery.
+ * @param[in] forward      - wskaźnik na numer docelowy.
+ * @param[in] suffix       - wskaźnik na koniec numeru.
+ * @param[in] suffixLength - długość końca numeru.
+ * @return Wartość @p true, jeśli numer został dodany.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool phnumAddForward(PhoneNumbers *pnum, Target const *forward, char const *suffix,
+                            size_t const suffixLength) {
+   if (!reserveArray((void**)&(pnum->numbers), &(pnum->size), pnum->count + 1,
+                     sizeof(NumberRef))
+       || !phnumWriteForward(pnum, forward, suffix, suffixLength,
+                             &((pnum->numbers)[pnum->count])))
+      return false;
 
    (pnum->count)++;
    return true;
 }
 
+/** @brief Porównuje dwa położenia numerów.
+ * @param[in] ref1 - wskaźnik na pierwsze położenie (pole @p pointer).
+ * @param[in] ref2 - wskaźnik na drugie położenie (pole @p pointer).
+ * @return Wynik funkcji @ref numberComparator dla wskazywanych numerów.
+ */
+static int refComparator(void const *ref1, void const *ref2) {
+   return numberComparator(((NumberRef const *)ref1)->pointer, 
+                           ((NumberRef const *)ref2)->pointer);
+}
+
+/** Liczba kubełków sortowania pozycyjnego - koniec numeru i 12 cyfr. */
+#define SORT_BUCKETS (NUMBER_OF_DIGITS + 1)
+
+/** Fragmenty tablicy nie dłuższe są sortowane przez wstawianie. */
+#define INSERTION_SORT_THRESHOLD 16
+
+/** Kubełki znaków w kolejności identyfikatorów, koniec numeru jest pierwszy. */
+static unsigned char const sortBucket[256] = {
+   ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5, ['5'] = 6,
+   ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10, ['*'] = 11, ['#'] = 12
+};
+
+/** @struct SortRange
+ * To jest struktura opisująca fragment tablicy numerów, które mają wspólny
+ * prefiks długości @p depth, czekający na posortowanie.
+ */
+typedef struct SortRange {
+   size_t begin; ///< Początek fragmentu.
+   size_t end;   ///< Koniec fragmentu (pierwszy element za nim).
+   size_t depth; ///< Długość wspólnego prefiksu.
+} SortRange;
+
+/** @brief Porównuje numery o wspólnym prefiksie.
+ * @param[in] number1 - wskaźnik na pierwszy numer.
+ * @param[in] number2 - wskaźnik na drugi numer.
+ * @param[in] depth   - długość wspólnego prefiksu numerów.
+ * @return Wartość ujemna, zero lub dodatnia, jeśli pierwszy numer jest
+ *         odpowiednio mniejszy, równy lub większy od drugiego.
+ */
+static inline int compareFrom(char const *number1, char const *number2, size_t const depth) {
+   unsigned char const *first = (unsigned char const *)number1 + depth;
+   unsigned char const *second = (unsigned char const *)number2 + depth;
+   while (*first == *second && *first != '\0') {
+      first++;
+      second++;
+   }
+   return (int)sortBucket[*first] - (int)sortBucket[*second];
+}
+
+/** @brief Sortuje przez wstawianie fragment tablicy numerów.
+ * Powtórzenia numeru poza pierwszym są oznaczane wskaźnikiem NULL.
+ * @param[in,out] refs - wskaźnik na początek fragmentu.
+ * @param[in] count    - długość fragmentu.
+ * @param[in] depth    - długość wspólnego prefiksu numerów.
+ */
+static void insertionSort(NumberRef *refs, size_t const count, size_t const depth) {
+   for (size_t i = 1; i < count; i++) {
+      NumberRef const ref = refs[i];
+      size_t j = i;
+      while (j > 0 && compareFrom(refs[j - 1].pointer, ref.pointer, depth) > 0) {
+         refs[j] = refs[j - 1];
+         j--;
+      }
+      refs[j] = ref;
+   }
+
+   for (size_t i = count; i > 1; i--) {
+      if (compareFrom(refs[i - 2].pointer, refs[i - 1].pointer, depth) == 0)
+         refs[i - 1].pointer = NULL;
+   }
+}
+
+/** @brief Sortuje pozycyjnie tablicę numerów i oznacza powtórzenia.
+ * Sortowanie zaczyna od najbardziej znaczącego znaku i rozdziela numery
+ * między kubełki kolejnych znaków, przestawiając tylko wskaźniki. Numery
+ * z kubełka końca numeru są równe, więc wszystkie poza pierwszym są
+ * powtórzeniami i są oznaczane wskaźnikiem NULL.
+ * @param[in,out] refs - tablica wskaźników na numery.
+ * @param[in] count    - liczba numerów.
+ * @return Wartość @p true, jeśli tablica została posortowana.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci (tablica
+ *         zawiera wtedy te same numery w nieokreślonej kolejności).
+ */
+static bool radixSort(NumberRef *refs, size_t const count) {
+   NumberRef *buffer = malloc(count * sizeof(NumberRef));
+   unsigned char *buckets = malloc(count);
+   SortRange *ranges = NULL;
+   size_t rangesSize = 0, rangesCount = 0;
+   bool success = (buffer != NULL && buckets != NULL
+                   && reserveArray((void**)&ranges, &rangesSize, 1, sizeof(SortRange)));
+   if (success)
+      ranges[rangesCount++] = (SortRange){0, count, 0};
+
+   while (success && rangesCount > 0) {
+      SortRange const range = ranges[--rangesCount];
+      size_t const length = range.end - range.begin;
+      NumberRef *part = refs + range.begin;
+      if (length <= INSERTION_SORT_THRESHOLD) {
+         insertionSort(part, length, range.depth);
+         continue;
+      }
+
+      size_t counts[SORT_BUCKETS] = {0};
+      for (size_t i = 0; i < length; i++) {
+         unsigned char const bucket =
+            sortBucket[(unsigned char)(part[i].pointer[range.depth])];
+         buckets[i] = bucket;
+         counts[bucket]++;
+      }
+
+      // Wszystkie numery mają ten sam znak - nie trzeba ich przestawiać.
+      if (counts[buckets[0]] == length && buckets[0] != 0) {
+         ranges[rangesCount++] = (SortRange){range.begin, range.end, range.depth + 1};
+         continue;
+      }
+
+      size_t starts[SORT_BUCKETS];
+      size_t position = 0;
+      for (int bucket = 0; bucket < SORT_BUCKETS; bucket++) {
+         starts[bucket] = position;
+         position += counts[bucket];
+      }
+      for (size_t i = 0; i < length; i++)
+         buffer[starts[buckets[i]]++] = part[i];
+      memcpy(part, buffer, length * sizeof(NumberRef));
+
+      for (size_t i = 1; i < counts[0]; i++)
+         part[i].pointer = NULL;
+      success = reserveArray((void**)&ranges, &rangesSize,
+                             rangesCount + SORT_BUCKETS, sizeof(SortRange));
+      for (int bucket = 1; bucket < SORT_BUCKETS && success; bucket++) {
+         size_t const end = range.begin + starts[bucket];
+         if (counts[bucket] > 1)
+            ranges[rangesCount++] = (SortRange){end - counts[bucket], end, range.depth + 1};
+      }
+   }
+
+   free(buffer);
+   free(buckets);
+   free(ranges);
+   return success;
+}
+
 /** @brief Sortuje numery i usuwa doplikaty.
  * Sortuje numery znajdujące się strukturze @p PhoneNumbers oraz 
- * usuwa te, które się powtarzają.
+ * usuwa te, które się powtarzają. Znaki usuniętych numerów pozostają
+ * w tablicy znaków.
  * @param[in,out] pnum - wskaźnik na strukturę przechowującą numery.
  */
 static void phnumSortAndDeleteDuplicates(PhoneNumbers *pnum) {
-   qsort(pnum->numbers, pnum->count, sizeof(*(pnum->numbers)), 
-         (int(*)(void const *, void const *))numberComparator);
+   if (pnum->count == 0)
+      return;
 
-   size_t position = 1;
-   for (size_t i = 1; i < pnum->count; i++) {
-      if (position != i) {
-         (pnum->numbers)[position] = (pnum->numbers)[i];
-         (pnum->numbers)[i] = NULL;
-      }
+   for (size_t i = 0; i < pnum->count; i++)
+      (pnum->numbers)[i].pointer = pnum->chars + (pnum->numbers)[i].offset;
 
-      if (strcmp((pnum->numbers)[position], 
-                 (pnum->numbers)[position - 1]) == 0) {
-         free((pnum->numbers)[position]);
-         (pnum->numbers)[position] = NULL;
+   size_t position = 0;
+   if (radixSort(pnum->numbers, pnum->count)) {
+      for (size_t i = 0; i < pnum->count; i++) {
+         if ((pnum->numbers)[i].pointer != NULL)
+            (pnum->numbers)[position++] = (pnum->numbers)[i];
       }
-      else {
-         position++;
+   }
+   else {
+      // Sortowanie pozycyjne mogło już oznaczyć powtórzenia.
+      for (size_t i = 0; i < pnum->count; i++) {
+         if ((pnum->numbers)[i].pointer != NULL)
+            (pnum->numbers)[position++] = (pnum->numbers)[i];
+      }
+      qsort(pnum->numbers, position, sizeof(NumberRef), refComparator);
+      size_t const count = position;
+      position = 1;
+      for (size_t i = 1; i < count; i++) {
+         if (strcmp((pnum->numbers)[i].pointer, 
+                    (pnum->numbers)[position - 1].pointer) != 0)
+            (pnum->numbers)[position++] = (pnum->numbers)[i];
       }
    }
    pnum->count = position;
+
+   for (size_t i = 0; i < pnum->count; i++)
+      (pnum->numbers)[i].offset = (size_t)((pnum->numbers)[i].pointer - pnum->chars);
 }
 
 void phnumDelete(PhoneNumbers *pnum) {
    if (pnum == NULL)
       return;
 
-   for (size_t i = 0; i < pnum->count; i++) {
-      free((pnum->numbers)[i]);
-      (pnum->numbers)[i] = NULL;
-   }
-
+   free(pnum->chars);
+   pnum->chars = NULL;
    free(pnum->numbers);
    pnum->numbers = NULL;
    free(pnum);
@@ -216,391 +394,1967 @@ void phnumDelete(PhoneNumbers *pnum) {
 }
 
 char const * phnumGet(PhoneNumbers const *pnum, size_t const idx) {
-   if (pnum == NULL || pnum->count <= idx)
+   if (pnum == NULL || pnum->count <= idx 
+       || (pnum->numbers)[idx].offset == NO_NUMBER)
       return NULL;
 
-   return (pnum->numbers)[idx];
+   return pnum->chars + (pnum->numbers)[idx].offset;
+}
+
+#ifdef PHONE_FORWARD_STATS
+/** @brief Odczytuje bieżący czas.
+ * @return Liczba nanosekund od ustalonej chwili w przeszłości.
+ */
+static uint64_t nanoseconds(void) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (uint64_t)(now.tv_sec) * 1000000000u + (uint64_t)(now.tv_nsec);
+}
+
+/** @brief Zapisuje czas wykonania operacji.
+ * @param[in] pf        - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] operation - operacja.
+ * @param[in] start     - czas rozpoczęcia operacji.
+ */
+static void recordLatency(PhoneForward const *pf, PhoneForwardOperation const operation,
+                          uint64_t const start) {
+   if (pf == NULL || pf->latencies == NULL)
+      return;
+
+   uint64_t const elapsed = nanoseconds() - start;
+   int bucket = 0;
+   while (bucket < PHFWD_LATENCY_BUCKETS - 1 && (elapsed >> (bucket + 1)) != 0)
+      bucket++;
+
+   Latency *latency = &((pf->latencies)[operation]);
+   atomic_fetch_add_explicit(&(latency->count), 1, memory_order_relaxed);
+   atomic_fetch_add_explicit(&(latency->nanoseconds), elapsed, memory_order_relaxed);
+   atomic_fetch_add_explicit(&((latency->buckets)[bucket]), 1, memory_order_relaxed);
+}
+#endif
+
+bool reserveRetired(PhoneForward *pf, size_t const count) {
+   return (pf->epochs == NULL || ebrReserve(pf->epochs, count));
+}
+
+void retire(PhoneForward *pf, void *object, RetiredKind const kind) {
+   if (pf->epochs != NULL)
+      ebrRetire(pf->epochs, object, (int)kind);
+}
+
+/** @brief Sprawdza, czy wierzchołek można zmieniać w miejscu.
+ * Ojciec wierzchołka musi być udostępniony do zmiany.
+ * @param[in] pf   - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] node - wskaźnik na wierzchołek drzewa.
+ * @return Wartość @p true, jeśli wierzchołek utworzyła lub udostępniła
+ *         trwająca zmiana (żaden inny wątek ani klon go nie widzi), jeśli
+ *         struktura ma klony, a wierzchołek ma jednego ojca, lub jeśli
+ *         struktura nie ma klonów i nie działa w trybie współbieżnym.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static inline bool isPrivate(PhoneForward const *pf, Node const *node) {
+   if (pf->family != NULL && node->generation != pf->generation)
+      return shareCount(pf->family->shared, node) == 1;
+   return !(pf->concurrent) || node->generation == pf->generation;
+}
+
+bool releaseShared(PhoneForward *pf, Node const *node) {
+   if (pf->family == NULL || node->generation == pf->generation)
+      return false;
+   return shareRelease(pf->family->shared, node);
 }
 
-/** @struct Node
- * To jest struktura zawierająca wierzchołek drzewa 
- * (przekierowania przechowujemy na drzewie).
+/** @brief Dodaje referencje na synów i przekierowanie wierzchołka.
+ * Wywoływana przed skopiowaniem wierzchołka współdzielonego z klonami -
+ * kopia wskazuje na tych samych synów i ten sam numer docelowy.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] node   - wskaźnik na kopiowany wierzchołek.
+ * @return Wartość @p true, jeśli referencje zostały dodane.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci (żadna
+ *         referencja nie jest wtedy dodawana).
  */
-struct Node;
-/** @typedef Node
- * Definicja structury Node.
+static bool shareChildren(PhoneForward *pf, Node const *node) {
+   int const children = nonEmptySubtrees(node);
+   for (int i = 0; i < children; i++) {
+      if (!shareAcquire(pf->family->shared, (node->subtrees)[i])) {
+         while (i-- > 0)
+            shareRelease(pf->family->shared, (node->subtrees)[i]);
+         return false;
+      }
+   }
+   if (node->forward != NULL)
+      internRetain(node->forward);
+   return true;
+}
+
+void countForward(PhoneForward *pf, size_t const length, bool const added) {
+   size_t const bucket = (length < PHFWD_DEPTHS ? length : PHFWD_DEPTHS - 1);
+   if (added) {
+      (pf->forwardCount)++;
+      (pf->depths)[bucket]++;
+   }
+   else {
+      (pf->forwardCount)--;
+      (pf->depths)[bucket]--;
+   }
+}
+
+Node * allocNode(PhoneForward *pf, int const children) {
+   Node *node = slabAlloc(pf->allocator, nodeSize(children));
+   if (node != NULL) {
+      (pf->nodeCount)++;
+      pf->nodeBytes += nodeSize(children);
+   }
+   return node;
+}
+
+void freeNode(PhoneForward *pf, Node *node, int const children) {
+   node->generation = pf->generation;
+   (pf->nodeCount)--;
+   pf->nodeBytes -= nodeSize(children);
+   slabFree(pf->allocator, node, nodeSize(children));
+}
+
+/** @brief Zwalnia wierzchołek bez jego przekierowania.
+ * Wierzchołek, który mogą czytać inne wątki, jest odkładany do zwolnienia.
+ * @param[in,out] pf   - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] node     - wskaźnik na zwalniany wierzchołek.
+ * @param[in] children - liczba synów, dla której przydzielono wierzchołek.
  */
-typedef struct Node {
-   char digit;             ///< Cyfra reprezentująca wierzchołek.
-   char *forward;          ///< Przekierowanie.
-   size_t forwardLength;   ///< Długość napisu reprezentującego przekierowanie.
-   struct Node const *parent;    ///< Wskaźnik na rodzica.
-   struct Node *subtrees[NUMBER_OF_DIGITS]; ///< Wskaźniki na synów.
-} Node;
+static void releaseNode(PhoneForward *pf, Node *node, int const children) {
+   if (isPrivate(pf, node))
+      freeNode(pf, node, children);
+   else
+      retire(pf, node, RETIRED_NODE);
+}
+
+void releaseTarget(PhoneForward *pf, Target *target) {
+   if (target == NULL)
+      return;
+   if (pf->concurrent)
+      retire(pf, target, RETIRED_TARGET);
+   else
+      internRelease(pf->targets, target);
+}
 
 /** @brief Tworzy nową strukturę.
  * Tworzy nową strukturę, która przechowuje określony znak oraz początkowo
- * nie przechowuje żadnych przekierowań.
+ * nie przechowuje żadnych przekierowań ani synów.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania.
  * @param[in] digit  - znak, który będzie przechowywała struktura.
- * @param[in] parent - wskaźnik na ojca.
  * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie powiodła się
  *         alokacja pamięci.
  */
-static Node * createNode(char const digit, Node const *parent) {
+static Node * createNode(PhoneForward *pf, char const digit) {
    Node *node;
-   node = malloc(sizeof(Node));
+   node = allocNode(pf, 0);
    if (node == NULL)
       return NULL;
-   
-   node->digit = digit;
+
    node->forward = NULL;
-   node->forwardLength = 0;
-   node->parent = parent;
-   for (int i = 0; i < NUMBER_OF_DIGITS; i++)
-      (node->subtrees)[i] = NULL;
+   node->generation = pf->generation;
+   node->children = 0;
+   node->digit = digit;
+   node->isSource = false;
    return node;
 }
 
-/** @brief Usuwa strukturę.
- * Usuwa strukturę wskazywaną przez @p node.
- * Nic nie robi, jeśli wskaźnik ten ma wartość NULL.
- * @param[in] node - wskaźnik na usuwaną strukturę.
- */
-static void deleteNode(Node *node) {
-   if (node == NULL)
-      return;
+Node * writableNode(PhoneForward *pf, Node **slot) {
+   Node *node = *slot;
+   if (isPrivate(pf, node)) {
+      node->generation = pf->generation;
+      return node;
+   }
 
-   Node const *parentOfDeletedNode = node->parent;
-   int startingSubtreeID = 0;
+   int const children = nonEmptySubtrees(node);
+   if (pf->family == NULL && !reserveRetired(pf, 1))
+      return NULL;
+   Node *copy = allocNode(pf, children);
+   if (copy == NULL)
+      return NULL;
+   if (pf->family != NULL && !shareChildren(pf, node)) {
+      freeNode(pf, copy, children);
+      return NULL;
+   }
+   memcpy(copy, node, nodeSize(children));
+   copy->generation = pf->generation;
+   if (pf->family != NULL) {
+      shareRelease(pf->family->shared, node);
+      node->generation = pf->generation;
+   }
+   else {
+      retire(pf, node, RETIRED_NODE);
+   }
+   *slot = copy;
+   return copy;
+}
+
+Node ** insertChild(PhoneForward *pf, Node **slot, Node *child) {
+   int const id = digitID(child->digit);
+   int const count = nonEmptySubtrees(*slot);
+   if (!isPrivate(pf, *slot) && !reserveRetired(pf, 1))
+      return NULL;
+   Node *node = allocNode(pf, count + 1);
+   if (node == NULL)
+      return NULL;
 
-   while (node != parentOfDeletedNode) {
-      int subtreeID = startingSubtreeID;
-      while (subtreeID < NUMBER_OF_DIGITS && (node->subtrees)[subtreeID] == NULL)
-         subtreeID++;
+   int const position = childPosition(*slot, id);
+   memcpy(node, *slot, nodeSize(position));
+   memcpy(&((node->subtrees)[position + 1]), &(((*slot)->subtrees)[position]),
+          (size_t)(count - position) * sizeof(Node*));
+   releaseNode(pf, *slot, count);
+   node->generation = pf->generation;
+   (node->subtrees)[position] = child;
+   node->children |= (uint16_t)(1u << id);
+   *slot = node;
+   return &((node->subtrees)[position]);
+}
 
-      if (subtreeID == NUMBER_OF_DIGITS) { // Wszystkie poddrzewa są usunięte.
-         char const digit = node->digit;
-         Node *previousNode;
-         previousNode = node;
-         node = (Node*)(node->parent);
-         free(previousNode->forward);
-         previousNode->forward = NULL;
-         free(previousNode);
-         previousNode = NULL;
+/** @brief Dodaje syna do wierzchołka.
+ * Wierzchołek jest przy tym przenoszony do większego bloku, dlatego jest
+ * przekazywany przez wskaźnik na miejsce, w którym jest przechowywany.
+ * @param[in,out] pf   - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in,out] slot - wskaźnik na miejsce przechowywania wierzchołka.
+ * @param[in] digit    - znak, który będzie przechowywał nowy syn.
+ * @return Wskaźnik na miejsce przechowywania nowego syna lub NULL, gdy nie
+ *         powiodła się alokacja pamięci (wierzchołek nie jest wtedy zmieniany).
+ */
+static Node ** addChild(PhoneForward *pf, Node **slot, char const digit) {
+   Node *child = createNode(pf, digit);
+   if (child == NULL)
+      return NULL;
 
-         if (node != NULL)
-            (node->subtrees)[digitID(digit)] = NULL;
+   Node **childSlot = insertChild(pf, slot, child);
+   if (childSlot == NULL)
+      freeNode(pf, child, 0);
+   return childSlot;
+}
 
-         startingSubtreeID = (digitID(digit)) + 1;
-      }
-      else { // Usuwamy pierwsze z nieusuniętych poddrzew.
-         node = (node->subtrees)[subtreeID];
-         startingSubtreeID = 0;
-      }
+/** @brief Odłącza syna od wierzchołka.
+ * Syn nie jest usuwany. Wierzchołek jest przy tym przenoszony do mniejszego
+ * bloku. Wierzchołek musi być udostępniony do zmiany.
+ * @param[in,out] pf   - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in,out] slot - wskaźnik na miejsce przechowywania wierzchołka.
+ * @param[in] id       - identyfikator krawędzi prowadzącej do syna.
+ */
+static void removeChild(PhoneForward *pf, Node **slot, int const id) {
+   Node *node = *slot;
+   int const count = nonEmptySubtrees(node);
+   int const position = childPosition(node, id);
+   memmove(&((node->subtrees)[position]), &((node->subtrees)[position + 1]),
+           (size_t)(count - position - 1) * sizeof(Node*));
+   node->children &= (uint16_t)~(1u << id);
+
+   // Jeśli nie uda się przydzielić mniejszego bloku, wierzchołek zostaje
+   // w większym - zwolniony później trafi na listę mniejszych bloków.
+   Node *shrunk = allocNode(pf, count - 1);
+   if (shrunk != NULL) {
+      memcpy(shrunk, node, nodeSize(count - 1));
+      shrunk->generation = pf->generation;
+      freeNode(pf, node, count);
+      *slot = shrunk;
    }
 }
 
-/** @brief Wyznacza liczbę niepustych poddrzew wierzchołka @p node.
- * @param[in] node - wskaźnik na wierzchołek drzewa.
- * @return Liczba niepustych poddrzew wierzchołka @p node.
+/** @brief Przygotowuje wierzchołek do usunięcia.
+ * Zwalnia przekierowanie wierzchołka i zapisuje w polu @p digit liczbę jego
+ * synów (usuwany wierzchołek nie potrzebuje już swojej cyfry).
+ * @param[in,out] pf   - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in,out] node - wskaźnik na wierzchołek.
  */
-static int nonEmptySubtrees(Node const *node) {
-   int result = 0;
-   for (int i = 0; i < NUMBER_OF_DIGITS; i++) {
-      if ((node->subtrees)[i] != NULL)
-         result++;
+static void prepareDeletion(PhoneForward *pf, Node *node) {
+   internRelease(pf->targets, node->forward);
+   node->forward = NULL;
+   node->digit = (char)nonEmptySubtrees(node);
+}
+
+/** @brief Usuwa ścieżkę.
+ * Usuwa wierzchołek @p node, który ma co najwyżej jednego syna, oraz
+ * wszystkich jego potomków, z których każdy ma co najwyżej jednego syna.
+ * Wierzchołki, które mogą czytać inne wątki, są odkładane do zwolnienia.
+ * Wierzchołek współdzielony z klonami traci tylko referencję, a dalsza
+ * część ścieżki zostaje. Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] node   - wskaźnik na pierwszy wierzchołek ścieżki.
+ */
+static void deleteChain(PhoneForward *pf, Node *node) {
+   while (node != NULL && !releaseShared(pf, node)) {
+      int const children = nonEmptySubtrees(node);
+      Node *next = (children != 0 ? (node->subtrees)[0] : NULL);
+      releaseTarget(pf, node->forward);
+      releaseNode(pf, node, children);
+      node = next;
    }
-   return result;
 }
 
-struct PhoneForward {
-   Node *node; ///< Wskaźnik na pierwszy wierzchołek drzewa trie.
-};
+void deleteNode(PhoneForward *pf, Node *node, Node **stack) {
+   if (node == NULL || releaseShared(pf, node))
+      return;
+   if (node->children == 0) {
+      internRelease(pf->targets, node->forward);
+      freeNode(pf, node, 0);
+      return;
+   }
 
-PhoneForward * phfwdNew(void) {
-   PhoneForward *pf;
-   pf = malloc(sizeof(PhoneForward));
-   if (pf == NULL)
-      return NULL;
-   
-   pf->node = createNode('0', NULL);
-   if (pf->node == NULL) {
-      free(pf);
-      pf = NULL;
-      return NULL;
+   // Przekierowanie usuwanego wierzchołka jest zwalniane od razu, a pole
+   // digit przechowuje liczbę jeszcze nieusuniętych synów - bitów synów
+   // nie zmieniamy, bo wyznaczają rozmiar bloku wierzchołka.
+   size_t top = 0;
+   stack[0] = node;
+   prepareDeletion(pf, node);
+   while (true) {
+      node = stack[top];
+
+      if (node->digit == 0) { // Wszystkie poddrzewa są usunięte.
+         freeNode(pf, node, nonEmptySubtrees(node));
+         if (top == 0)
+            return;
+         top--;
+      }
+      else { // Usuwamy ostatnie z nieusuniętych poddrzew.
+         (node->digit)--;
+         Node *child = (node->subtrees)[(int)(node->digit)];
+         if (releaseShared(pf, child))
+            continue;
+         prepareDeletion(pf, child);
+         stack[++top] = child;
+      }
    }
+}
 
-   return pf;
+Node * findPath(Node const *node, char const *number, size_t const length) {
+   for (size_t i = 0; i < length && node != NULL; i++)
+      node = getChild(node, digitID(number[i]));
+   return (Node*)node;
 }
 
-void phfwdDelete(PhoneForward *pf) {
-   if (pf == NULL)
+/** @struct Cut
+ * To jest struktura opisująca krawędź drzewa, pod którą zaczyna się
+ * ścieżka do usunięcia lub nowo utworzona ścieżka.
+ */
+typedef struct Cut {
+   Node **slot;  ///< Wskaźnik na miejsce przechowywania ojca (NULL - brak krawędzi).
+   int id;       ///< Identyfikator krawędzi.
+   size_t depth; ///< Głębokość ojca.
+} Cut;
+
+/** @brief Usuwa poddrzewo wiszące pod krawędzią.
+ * Odłącza syna opisanego przez @p cut i usuwa jego poddrzewo. W trybie
+ * współbieżnym poddrzewo jest odkładane do zwolnienia w całości, a wywołujący
+ * musi wcześniej zarezerwować na nie miejsce - na poddrzewo lub na każdy
+ * wierzchołek ścieżki, które nie powstały w trwającej zmianie.
+ * Nic nie robi, jeśli krawędź nie jest określona.
+ * @param[in,out] pf    - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] cut       - opis krawędzi; ojciec musi być udostępniony do zmiany.
+ * @param[in,out] stack - tablica pomocnicza dla funkcji @ref deleteNode lub
+ *                        NULL, jeśli poddrzewo jest ścieżką.
+ */
+static void deleteCut(PhoneForward *pf, Cut const cut, Node **stack) {
+   if (cut.slot == NULL)
       return;
-   
-   deleteNode(pf->node);
-   pf->node = NULL;
-   free(pf);
-   pf = NULL;
+
+   Node *child = getChild(*(cut.slot), cut.id);
+   removeChild(pf, cut.slot, cut.id);
+   if (stack == NULL)
+      deleteChain(pf, child);
+   else if (pf->concurrent)
+      retire(pf, child, RETIRED_SUBTREE);
+   else
+      deleteNode(pf, child, stack);
 }
 
-bool phfwdAdd(PhoneForward *pf, char const *num1, char const *num2) {
-   size_t const length = numberLength(num2);
-   if (pf == NULL || numberLength(num1) == 0 || length == 0
-       || strcmp(num1, num2) == 0)
-      return false;
-   
-   Node *node = pf->node;
-   Node *newSubtree; // Wskaźnik na wierzchołek nowo dodanego poddrzewa
-                     // (NULL, jeśli nie dodaliśmy żadnego nowego wierzchołka).
-                     // Potrzebne, żebyśmy wiedzieli jakie wierzchołki usunąć
-                     // w razie niepowodzenia alokacji.
-   newSubtree = NULL;
+/** @brief Sprawdza, czy wierzchołek musi pozostać w drzewie.
+ * @param[in] node - wskaźnik na wierzchołek drzewa.
+ * @return Wartość @p true, jeśli wierzchołek przechowuje przekierowanie,
+ *         kończy klucz indeksu odwrotnego lub ma więcej niż jednego syna.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool isNeeded(Node const *node) {
+   return node->forward != NULL || node->isSource || nonEmptySubtrees(node) > 1;
+}
 
-   size_t position = 0;
-   while (isDigit(num1[position])) {
-      char const digit = num1[position];
-
-      if ((node->subtrees)[digitID(digit)] == NULL) {
-         (node->subtrees)[digitID(digit)] = createNode(digit, node);
-         if ((node->subtrees)[digitID(digit)] == NULL) {
-            node = NULL;
-            deleteNode(newSubtree);
-            return false;
-         }
+/** @brief Wyznacza miejsce przechowywania wierzchołka odpowiadającego napisowi.
+ * Przechodzi od wierzchołka przechowywanego w @p slot ścieżką opisaną przez
+ * @p number. Zapamiętuje w @p cut najgłębszą krawędź ścieżki, której ojciec
+ * musi pozostać w drzewie, nawet gdy poddrzewo końca ścieżki zostanie usunięte.
+ * Niczego nie zmienia.
+ * @param[in] slot    - wskaźnik na miejsce przechowywania wierzchołka początkowego.
+ * @param[in] number  - wskaźnik na napis opisujący ścieżkę.
+ * @param[in] length  - długość napisu.
+ * @param[in,out] cut - wskaźnik na opis krawędzi.
+ * @return Wskaźnik na miejsce przechowywania ostatniego wierzchołka ścieżki
+ *         lub NULL, gdy ścieżka nie istnieje.
+ */
+static Node ** findSlot(Node **slot, char const *number, size_t const length,
+                        Cut *cut) {
+   for (size_t i = 0; i < length; i++) {
+      Node *node = *slot;
+      int const id = digitID(number[i]);
+      if (!(node->children & (1u << id)))
+         return NULL;
 
-         if (newSubtree == NULL)
-            newSubtree = (node->subtrees)[digitID(digit)];
+      if (cut->slot == NULL || isNeeded(node)) {
+         cut->slot = slot;
+         cut->id = id;
+         cut->depth = i;
       }
+      slot = &((node->subtrees)[childPosition(node, id)]);
+   }
+   return slot;
+}
 
-      node = (node->subtrees)[digitID(digit)];
-      position++;
+/** @brief Udostępnia do zmiany wierzchołki na istniejącej ścieżce.
+ * Przechodzi od wierzchołka przechowywanego w @p slot ścieżką opisaną przez
+ * @p number i udostępnia do zmiany wszystkie jej wierzchołki, łącznie
+ * z pierwszym i ostatnim.
+ * @param[in,out] pf   - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in,out] slot - wskaźnik na miejsce przechowywania wierzchołka
+ *                       początkowego.
+ * @param[in] number   - wskaźnik na napis opisujący ścieżkę.
+ * @param[in] length   - długość napisu.
+ * @return Wskaźnik na miejsce przechowywania ostatniego wierzchołka ścieżki
+ *         lub NULL, gdy nie powiodła się alokacja pamięci (skopiowane
+ *         wierzchołki są wtedy równoważne oryginałom).
+ */
+static Node ** copyPath(PhoneForward *pf, Node **slot,
+                        char const *number, size_t const length) {
+   for (size_t i = 0; ; i++) {
+      Node *node = writableNode(pf, slot);
+      if (node == NULL)
+         return NULL;
+      if (i == length)
+         return slot;
+      slot = &((node->subtrees)[childPosition(node, digitID(number[i]))]);
    }
+}
 
-   if (!reallocNumber(&(node->forward), length)) {
-      node = NULL;
-      deleteNode(newSubtree);
-      return false;
+/** @brief Wyznacza wierzchołek odpowiadający napisowi, tworząc brakujące.
+ * Przechodzi od wierzchołka przechowywanego w @p slot ścieżką opisaną przez
+ * @p number, tworzy wierzchołki, których na niej brakuje, i udostępnia
+ * do zmiany wszystkie wierzchołki ścieżki.
+ * @param[in,out] pf      - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in,out] slot    - wskaźnik na miejsce przechowywania wierzchołka
+ *                          początkowego.
+ * @param[in] number      - wskaźnik na napis opisujący ścieżkę.
+ * @param[in] length      - długość napisu.
+ * @param[in,out] newPath - wskaźnik na opis krawędzi, pod którą zaczyna się
+ *                          nowo utworzona ścieżka (jeśli jeszcze nie utworzono
+ *                          żadnego wierzchołka, pole @p slot ma wartość NULL).
+ *                          Potrzebny, żeby w razie niepowodzenia alokacji
+ *                          usunąć nowe wierzchołki.
+ * @return Wskaźnik na miejsce przechowywania ostatniego wierzchołka ścieżki
+ *         lub NULL, gdy nie powiodła się alokacja pamięci (nowo utworzone
+ *         wierzchołki są wtedy usuwane).
+ */
+static Node ** createPath(PhoneForward *pf, Node **slot,
+                          char const *number, size_t const length, Cut *newPath) {
+   for (size_t i = 0; ; i++) {
+      Node *node = writableNode(pf, slot);
+      if (node == NULL)
+         break;
+      if (i == length)
+         return slot;
+
+      char const digit = number[i];
+      if (node->children & (1u << digitID(digit))) {
+         slot = &((node->subtrees)[childPosition(node, digitID(digit))]);
+         continue;
+      }
+
+      Node **childSlot = addChild(pf, slot, digit);
+      if (childSlot == NULL)
+         break;
+
+      if (newPath->slot == NULL) {
+         newPath->slot = slot;
+         newPath->id = digitID(digit);
+         newPath->depth = i;
+      }
+      slot = childSlot;
    }
 
-   for (size_t i = 0; i <= length; i++)
-      (node->forward)[i] = num2[i];
-   node->forwardLength = length;
+   deleteCut(pf, *newPath, NULL);
+   newPath->slot = NULL;
+   return NULL;
+}
+
+/** @brief Buduje klucz indeksu odwrotnego.
+ * Indeks odwrotny jest drzewem trie, w którym dla przekierowania z @p source
+ * na @p target zapisany jest klucz składający się z numeru @p target,
+ * separatora @ref SEPARATOR i numeru @p source. Klucz jest zapisywany
+ * w buforze @p key struktury.
+ * @param[in,out] pf       - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] target       - wskaźnik na numer docelowy.
+ * @param[in] targetLength - długość numeru docelowego.
+ * @param[in] source       - wskaźnik na numer przekierowywany.
+ * @param[in] sourceLength - długość numeru przekierowywanego.
+ * @return Długość klucza.
+ */
+static size_t reverseKey(PhoneForward *pf, char const *target, size_t const targetLength,
+                         char const *source, size_t const sourceLength) {
+   memcpy(pf->key, target, targetLength);
+   (pf->key)[targetLength] = SEPARATOR;
+   memcpy(pf->key + targetLength + 1, source, sourceLength);
+   return targetLength + 1 + sourceLength;
+}
+
+/** @brief Buduje klucz indeksu odwrotnego dla numeru docelowego przekierowania.
+ * Działa jak @ref reverseKey, ale rozpakowuje numer docelowy bezpośrednio
+ * do bufora @p key struktury.
+ * @param[in,out] pf       - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] forward      - wskaźnik na numer docelowy.
+ * @param[in] source       - wskaźnik na numer przekierowywany.
+ * @param[in] sourceLength - długość numeru przekierowywanego.
+ * @return Długość klucza.
+ */
+static size_t reverseKeyForward(PhoneForward *pf, Target const *forward,
+                                char const *source, size_t const sourceLength) {
+   internUnpack(pf->key, forward->digits, forward->length);
+   (pf->key)[forward->length] = SEPARATOR;
+   memcpy(pf->key + forward->length + 1, source, sourceLength);
+   return forward->length + 1 + sourceLength;
+}
+
+/** @brief Dodaje parę do indeksu odwrotnego.
+ * @param[in,out] pf       - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] target       - wskaźnik na numer docelowy.
+ * @param[in] targetLength - długość numeru docelowego.
+ * @param[in] source       - wskaźnik na numer przekierowywany.
+ * @param[in] sourceLength - długość numeru przekierowywanego.
+ * @return Wartość @p true, jeśli para została dodana.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool reverseInsert(PhoneForward *pf, char const *target, size_t const targetLength,
+                          char const *source, size_t const sourceLength) {
+   size_t const length = reverseKey(pf, target, targetLength, source, sourceLength);
+   Cut newPath = {NULL, 0, 0};
+   Node **slot = createPath(pf, &(pf->writing->reverse), pf->key, length, &newPath);
+   if (slot == NULL)
+      return false;
 
+   (*slot)->isSource = true;
    return true;
 }
 
-void phfwdRemove(PhoneForward *pf, char const *num) {
-   if (pf == NULL || numberLength(num) == 0)
+/** @brief Usuwa klucz z indeksu odwrotnego.
+ * Jeśli w trybie współbieżnym lub w strukturze z klonami nie uda się
+ * skopiować wierzchołków ścieżki, para pozostaje w indeksie, a wersja jest
+ * oznaczana jako wymagająca sprawdzania wyników.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania,
+ *                     której bufor @p key zawiera klucz.
+ * @param[in] length - długość klucza.
+ */
+static void reverseEraseKey(PhoneForward *pf, size_t const length) {
+   Node **root = &(pf->writing->reverse);
+   Cut cut = {NULL, 0, 0};
+   Node **slot = findSlot(root, pf->key, length, &cut);
+   if (slot == NULL)
       return;
-   
-   Node *node = pf->node;
-   Node *previousNode = node;
-   size_t position = 0;
 
-   while (isDigit(num[position])) {
-      char const digit = num[position];
-      if ((node->subtrees)[digitID(digit)] == NULL)
+   // Wierzchołki poniżej krawędzi cut tworzą ścieżkę, która staje się martwa.
+   bool const dead = ((*slot)->children == 0);
+   if (copiesPaths(pf)) {
+      slot = copyPath(pf, root, pf->key, (dead ? cut.depth : length));
+      if (slot == NULL) {
+         pf->writing->staleReverse = true;
          return;
-      previousNode = node;
-      node = (node->subtrees)[digitID(digit)];
-      position++;
+      }
+      if (dead)
+         cut.slot = slot;
    }
 
-   char const digit = num[position - 1];
-   (previousNode->subtrees)[digitID(digit)] = NULL;
-   deleteNode(node);
-
-   // Usunięcie martwej ścieżki w drzewie
-   node = previousNode;
-   while (node->parent != NULL && node->forward == NULL 
-          && nonEmptySubtrees(node) == 0) {
-      char const digit = node->digit;
-      previousNode = (Node*)(node->parent);
-      (previousNode->subtrees)[digitID(digit)] = NULL;
-      deleteNode(node);
-      node = previousNode;
+   // Wierzchołki martwej ścieżki mogą czytać inne wątki.
+   if (dead && !reserveRetired(pf, length - cut.depth)) {
+      pf->writing->staleReverse = true;
+      return;
    }
+   if (dead)
+      deleteCut(pf, cut, NULL);
+   else
+      (*slot)->isSource = false;
 }
 
-PhoneNumbers * phfwdGet(PhoneForward const *pf, char const *num) {
-   if (pf == NULL)
-      return NULL;
-
-   PhoneNumbers *pnum = phnumCreate();
-   size_t const numLength = numberLength(num);
-
-   if (pnum == NULL || numLength == 0)
-      return pnum;
-   
-   size_t longest = 0;
-   char *prefix = NULL;
-   size_t prefixLength = 0;
-   Node *node = pf->node;
-   size_t position = 0;
+void reverseErase(PhoneForward *pf, char const *target, size_t const targetLength,
+                  char const *source, size_t const sourceLength) {
+   reverseEraseKey(pf, reverseKey(pf, target, targetLength, source, sourceLength));
+}
 
-   while (node != NULL && isDigit(num[position])) {
-      char const digit = num[position];
-      node = (node->subtrees)[digitID(digit)];
-      position++;
+void reverseEraseForward(PhoneForward *pf, Target const *forward,
+                         char const *source, size_t const sourceLength) {
+   reverseEraseKey(pf, reverseKeyForward(pf, forward, source, sourceLength));
+}
 
-      if (node != NULL && node->forward != NULL) {
-         longest = position;
-         prefix = node->forward;
-         prefixLength = node->forwardLength;
+/** @brief Zeruje numery zmian wierzchołków drzewa.
+ * @param[in,out] root  - wskaźnik na korzeń drzewa.
+ * @param[in,out] stack - tablica pomocnicza, która pomieści wierzchołki
+ *                        najdłuższej ścieżki w drzewie.
+ */
+static void resetGenerations(Node *root, Node **stack) {
+   Node *node = root;
+   size_t top = 0;
+   int startingSubtreeID = 0;
+   node->generation = 0;
+
+   while (true) {
+      int const subtreeID = nextChild(node, startingSubtreeID);
+      if (subtreeID < NUMBER_OF_SYMBOLS) {
+         stack[top++] = node;
+         node = getChild(node, subtreeID);
+         node->generation = 0;
+         startingSubtreeID = 0;
+      }
+      else if (top == 0) {
+         return;
+      }
+      else {
+         startingSubtreeID = digitID(node->digit) + 1;
+         node = stack[--top];
       }
    }
+}
 
-   size_t const length = numLength - longest + prefixLength;
-   char *result = NULL;
-   if (!reallocNumber(&result, length)) {
-      phnumDelete(pnum);
+/** @brief Nadaje trwającej zmianie kolejny numer.
+ * Struktury z klonami numerują zmiany wspólnym licznikiem, dlatego numer
+ * trwającej zmiany nie występuje w żadnym wierzchołku współdzielonym.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania.
+ */
+static void nextGeneration(PhoneForward *pf) {
+   uint32_t *generation = (pf->family != NULL ? &(pf->family->generation)
+                                              : &(pf->generation));
+
+   // Po przepełnieniu numeru zmiany stare wierzchołki mogłyby zostać uznane
+   // za utworzone przez trwającą zmianę, a wpisy pamięci podręcznej za ważne.
+   if (++(*generation) == 0) {
+      PhoneForward *member = pf;
+      do {
+         if (member->writing->node != NULL) {
+            resetGenerations(member->writing->node, member->stack);
+            resetGenerations(member->writing->reverse, member->stack);
+         }
+         if (member->cache != NULL)
+            cacheClear(member->cache);
+         member = (member->sibling != NULL ? member->sibling : member);
+      } while (member != pf);
+      *generation = 1;
+   }
+   pf->generation = *generation;
+}
+
+/** @brief Tworzy postać zamrożoną drzew modyfikowanej wersji.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania.
+ * @return Wskaźnik na postać zamrożoną lub NULL, gdy nie udało się alokować
+ *         pamięci albo drzewa nie mieszczą się w 32-bitowych indeksach.
+ */
+static Frozen * freezeTries(PhoneForward const *pf) {
+   return frozenNew(pf->writing->node, pf->writing->reverse, internCount(pf->targets),
+                    pf->maxSourceLength, pf->maxTargetLength);
+}
+
+/** @brief Odtwarza drzewa z postaci zamrożonej.
+ * Po odtworzeniu drzew postać zamrożona jest zwalniana.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania.
+ * @return Wartość @p true, jeśli drzewa zostały odtworzone.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci (postać
+ *         zamrożona pozostaje wtedy bez zmian).
+ */
+static bool thaw(PhoneForward *pf) {
+   Frozen *frozen = pf->frozen;
+   Node **built = malloc((size_t)(frozen->nodeCount) * sizeof(Node*));
+   if (built == NULL)
+      return false;
+
+   // Synowie mają większe indeksy niż ojciec, więc tworzymy wierzchołki
+   // od końca tablicy. Wierzchołki o indeksach od ready są już utworzone.
+   uint32_t ready = frozen->nodeCount;
+   bool success = true;
+   while (ready > 0 && success) {
+      FlatNode const *flat = &((frozen->nodes)[ready - 1]);
+      int const children = popcount(flat->children);
+      Node *node = allocNode(pf, children);
+      if (node == NULL) {
+         success = false;
+         break;
+      }
+
+      node->forward = NULL;
+      node->generation = pf->generation;
+      node->children = flat->children;
+      node->digit = flat->digit;
+      node->isSource = flat->isSource;
+      for (int j = 0; j < children; j++)
+         (node->subtrees)[j] = built[flat->subtrees + (uint32_t)j];
+      built[--ready] = node;
+
+      if (flat->forward != NO_INDEX) {
+         FlatTarget const *target = &((frozen->targets)[flat->forward]);
+         node->forward = internAcquire(pf->targets, frozen->chars + target->offset,
+                                       target->length);
+         success = (node->forward != NULL);
+      }
+   }
+
+   if (!success) {
+      for (uint32_t i = ready; i < frozen->nodeCount; i++) {
+         internRelease(pf->targets, built[i]->forward);
+         freeNode(pf, built[i], nonEmptySubtrees(built[i]));
+      }
+      free(built);
+      return false;
+   }
+
+   pf->writing->node = built[0];
+   pf->writing->reverse = built[frozen->reverse];
+   free(built);
+   frozenRelease(frozen);
+   pf->frozen = NULL;
+   return true;
+}
+
+bool phfwdFreeze(PhoneForward *pf) {
+   if (pf == NULL || pf->concurrent)
+      return false;
+   if (pf->frozen != NULL)
+      return true;
+   // Postać zamrożona nie odfiltrowuje par, których po niepowodzeniu
+   // alokacji nie udało się usunąć z indeksu odwrotnego.
+   if (pf->writing->staleReverse)
+      return false;
+
+   // Postać zamrożona nie odfiltrowuje par odłożonych poddrzew.
+   if (pf->family != NULL)
+      nextGeneration(pf);
+   reclaimPending(pf, SIZE_MAX);
+   Frozen *frozen = freezeTries(pf);
+   if (frozen != NULL && pf->family != NULL) {
+      // Alokatory są wspólne z klonami, więc drzewa są zwalniane po
+      // wierzchołku, a poddrzewa współdzielone tracą tylko referencję.
+      deleteNode(pf, pf->writing->node, pf->stack);
+      deleteNode(pf, pf->writing->reverse, pf->stack);
+      pf->writing->node = NULL;
+      pf->writing->reverse = NULL;
+      if (pf->cache != NULL)
+         cacheClear(pf->cache);
+      pf->frozen = frozen;
+      return true;
+   }
+   SlabAllocator *allocator = (frozen != NULL ? slabNew() : NULL);
+   SlabAllocator *targetAllocator = (allocator != NULL ? slabNew() : NULL);
+   InternTable *targets = (targetAllocator != NULL ? internNew(targetAllocator) : NULL);
+   Version *version = (targets != NULL ? slabAlloc(allocator, sizeof(Version)) : NULL);
+   if (version == NULL) {
+      internDelete(targets);
+      slabDelete(targetAllocator);
+      slabDelete(allocator);
+      frozenRelease(frozen);
+      return false;
+   }
+
+   // Drzewa wskaźnikowe nie są już potrzebne - zostaną odtworzone przy
+   // pierwszej zmianie. Zwalniamy je razem z alokatorem, co zwraca pamięć
+   // i nie wymaga przechodzenia drzew. Wpisy pamięci podręcznej wskazują
+   // na zwolnione wierzchołki.
+   *version = *(pf->writing);
+   version->node = NULL;
+   version->reverse = NULL;
+   internDelete(pf->targets);
+   slabDelete(pf->targetAllocator);
+   slabDelete(pf->allocator);
+   pf->allocator = allocator;
+   pf->targetAllocator = targetAllocator;
+   pf->targets = targets;
+   pf->nodeCount = 0;
+   pf->nodeBytes = 0;
+   if (pf->cache != NULL)
+      cacheClear(pf->cache);
+   atomic_store(&(pf->version), version);
+   pf->writing = version;
+   pf->frozen = frozen;
+   return true;
+}
+
+bool beginChange(PhoneForward *pf) {
+   if (pf->frozen != NULL && !thaw(pf))
+      return false;
+   if (!(pf->concurrent)) {
+      nextGeneration(pf);
+      return true;
+   }
+
+   // Zastępowana wersja jest odkładana do zwolnienia.
+   pthread_mutex_lock(&(pf->writer));
+   Version *version = (reserveRetired(pf, 1) ?
+                       slabAlloc(pf->allocator, sizeof(Version)) : NULL);
+   if (version == NULL) {
+      pthread_mutex_unlock(&(pf->writer));
+      return false;
+   }
+   *version = *atomic_load(&(pf->version));
+   pf->writing = version;
+   nextGeneration(pf);
+   return true;
+}
+
+/** @brief Zwalnia obiekt, którego nie może już czytać żaden wątek.
+ * Funkcja zwalniająca przekazywana do @ref ebrAdvance.
+ * @param[in,out] context - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] object      - wskaźnik na obiekt.
+ * @param[in] kind        - rodzaj obiektu (@ref RetiredKind).
+ */
+static void freeRetired(void *context, void *object, int const kind) {
+   PhoneForward *pf = context;
+   Node *node = object;
+   switch ((RetiredKind)kind) {
+      case RETIRED_NODE:
+         freeNode(pf, node, nonEmptySubtrees(node));
+         break;
+      case RETIRED_SUBTREE:
+         if (!deferSubtree(pf, node, NULL, 0))
+            deleteNode(pf, node, pf->stack);
+         break;
+      case RETIRED_TARGET:
+         internRelease(pf->targets, object);
+         break;
+      case RETIRED_VERSION:
+         slabFree(pf->allocator, object, sizeof(Version));
+         break;
+   }
+}
+
+void endChange(PhoneForward *pf) {
+   reclaimPending(pf, RECLAIM_STEP);
+   pf->writing->maxSourceLength = pf->maxSourceLength;
+   if (!(pf->concurrent))
+      return;
+
+   retire(pf, atomic_load(&(pf->version)), RETIRED_VERSION);
+   atomic_store(&(pf->version), pf->writing);
+   ebrAdvance(pf->epochs, freeRetired, pf);
+   pthread_mutex_unlock(&(pf->writer));
+}
+
+Version const * beginRead(PhoneForward const *pf, size_t *slot) {
+   if (!(pf->concurrent)) {
+      *slot = 0;
+      return atomic_load_explicit(&(pf->version), memory_order_relaxed);
+   }
+
+   *slot = ebrEnter(pf->epochs);
+   return atomic_load(&(pf->version));
+}
+
+void endRead(PhoneForward const *pf, size_t const slot) {
+   if (pf->concurrent)
+      ebrLeave(pf->epochs, slot);
+}
+
+#ifdef PHONE_FORWARD_STATS
+/** @brief Tworzy liczniki czasów wykonania operacji.
+ * @return Wskaźnik na wyzerowane liczniki lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+static Latency * createLatencies(void) {
+   Latency *latencies = malloc(PHFWD_OPERATIONS * sizeof(Latency));
+   for (int i = 0; latencies != NULL && i < PHFWD_OPERATIONS; i++) {
+      atomic_init(&(latencies[i].count), 0);
+      atomic_init(&(latencies[i].nanoseconds), 0);
+      for (int j = 0; j < PHFWD_LATENCY_BUCKETS; j++)
+         atomic_init(&(latencies[i].buckets[j]), 0);
+   }
+   return latencies;
+}
+#endif
+
+/** @brief Tworzy nową strukturę przechowującą przekierowania.
+ * @param[in] concurrent - czy struktura ma działać w trybie współbieżnym.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+static PhoneForward * createPhoneForward(bool const concurrent) {
+   PhoneForward *pf;
+   pf = calloc(1, sizeof(PhoneForward));
+   if (pf == NULL)
+      return NULL;
+
+   pf->concurrent = concurrent;
+   pf->allocator = slabNew();
+   pf->targetAllocator = (pf->allocator != NULL ? slabNew() : NULL);
+   pf->targets = (pf->targetAllocator != NULL ? internNew(pf->targetAllocator) : NULL);
+   Version *version = (pf->targets != NULL ?
+                       slabAlloc(pf->allocator, sizeof(Version)) : NULL);
+   if (version != NULL) {
+      version->node = createNode(pf, '0');
+      version->reverse = createNode(pf, '0');
+      version->maxSourceLength = 0;
+      version->staleReverse = false;
+      version->erasing = false;
+   }
+   if (concurrent)
+      pf->epochs = ebrNew();
+#ifdef PHONE_FORWARD_STATS
+   pf->latencies = createLatencies();
+   bool const timed = (pf->latencies != NULL);
+#else
+   bool const timed = true;
+#endif
+   if (version == NULL || version->node == NULL || version->reverse == NULL || !timed
+       || (concurrent && (pf->epochs == NULL
+                          || pthread_mutex_init(&(pf->writer), NULL) != 0))) {
+      free(pf->latencies);
+      ebrDelete(pf->epochs);
+      internDelete(pf->targets);
+      slabDelete(pf->targetAllocator);
+      slabDelete(pf->allocator);
+      free(pf);
+      pf = NULL;
       return NULL;
    }
 
-   for (size_t i = 0; i < prefixLength; i++)
-      result[i] = prefix[i];
-   for (size_t i = longest; i <= numLength; i++)
-      result[i - longest + prefixLength] = num[i];
+   atomic_init(&(pf->version), version);
+   pf->writing = version;
+   return pf;
+}
 
-   bool added = phnumAdd(pnum, result, length);
-   free(result);
+PhoneForward * phfwdNew(void) {
+   return createPhoneForward(false);
+}
 
-   if (added)
-      return pnum;
-   phnumDelete(pnum);
-   return NULL;
+PhoneForward * phfwdNewConcurrent(void) {
+   return createPhoneForward(true);
 }
 
-/** @brief Dodaje numery należące do wyniku funkcji @ref phfwdReverse.
- * Sprawdza, czy przekierowanie przechowywane w wierzchołku @p node jest
- * prefiksem numeru @p num, jeżeli tak, to dodaje odpowiedni numer do 
- * struktury @p PhoneNumbers będącej wynikiem funkcji @ref phfwdReverse.
+/** @brief Odłącza strukturę od rodziny.
+ * Zwalnia wierzchołki drzew i odłożonych poddrzew, których struktura nie
+ * współdzieli z pozostałymi strukturami rodziny. Alokatory i tablica
+ * numerów docelowych zostają w rodzinie, a liczniki wierzchołków przejmuje
+ * inna struktura rodziny. Rodzina, w której zostaje jedna struktura, jest
+ * rozwiązywana.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania.
+ */
+static void leaveFamily(PhoneForward *pf) {
+   nextGeneration(pf);
+   reclaimAll(pf);
+   deleteNode(pf, pf->writing->node, pf->stack);
+   deleteNode(pf, pf->writing->reverse, pf->stack);
+   slabFree(pf->allocator, pf->writing, sizeof(Version));
+
+   PhoneForward *previous = pf->sibling;
+   while (previous->sibling != pf)
+      previous = previous->sibling;
+   previous->sibling = pf->sibling;
+   previous->nodeCount += pf->nodeCount;
+   previous->nodeBytes += pf->nodeBytes;
+   if (previous->sibling == previous) {
+      // Numery zmian pozostałej struktury muszą być większe niż numery
+      // zapisane w wierzchołkach przez całą rodzinę.
+      previous->generation = pf->family->generation;
+      shareDelete(pf->family->shared);
+      free(pf->family);
+      previous->family = NULL;
+      previous->sibling = NULL;
+   }
+   pf->family = NULL;
+   pf->sibling = NULL;
+}
+
+void phfwdDelete(PhoneForward *pf) {
+   if (pf == NULL)
+      return;
+
+   // Wszystkie wierzchołki, wersje i przekierowania, także te czekające
+   // na zwolnienie, są zwalniane razem z alokatorem. Struktura z kopiami
+   // zwalnia tylko to, czego nie współdzieli - alokatory są wspólne.
+   bool const shared = (pf->family != NULL);
+   if (shared)
+      leaveFamily(pf);
+   if (pf->concurrent)
+      pthread_mutex_destroy(&(pf->writer));
+   journalClose(pf->journal);
+   pf->journal = NULL;
+   frozenRelease(pf->frozen);
+   pf->frozen = NULL;
+   if (!shared) {
+      internDelete(pf->targets);
+      slabDelete(pf->targetAllocator);
+      slabDelete(pf->allocator);
+   }
+   pf->targets = NULL;
+   pf->targetAllocator = NULL;
+   pf->allocator = NULL;
+   cacheDelete(pf->cache);
+   pf->cache = NULL;
+   pf->writing = NULL;
+   ebrDelete(pf->epochs);
+   pf->epochs = NULL;
+   reclaimerDelete(&(pf->reclaimer));
+   free(pf->buffer);
+   pf->buffer = NULL;
+   free(pf->key);
+   pf->key = NULL;
+   free(pf->stack);
+   pf->stack = NULL;
+   free(pf->latencies);
+   pf->latencies = NULL;
+   free(pf);
+   pf = NULL;
+}
+
+bool reserveBuffers(PhoneForward *pf, size_t const sourceLength,
+                    size_t const targetLength) {
+   if (sourceLength <= pf->maxSourceLength && targetLength <= pf->maxTargetLength)
+      return true;
+
+   size_t const maxSource = (sourceLength > pf->maxSourceLength ?
+                             sourceLength : pf->maxSourceLength);
+   size_t const maxTarget = (targetLength > pf->maxTargetLength ?
+                             targetLength : pf->maxTargetLength);
+
+   // Najdłuższa ścieżka w indeksie odwrotnym składa się z korzenia, numeru
+   // docelowego, separatora i numeru przekierowywanego.
+   Node **stack = realloc(pf->stack, (maxSource + maxTarget + 2) * sizeof(Node*));
+   if (stack == NULL)
+      return false;
+   pf->stack = stack;
+
+   if (!reallocNumber(&(pf->key), maxSource + maxTarget + 1))
+      return false;
+   if (maxSource > pf->maxSourceLength && !reallocNumber(&(pf->buffer), maxSource))
+      return false;
+
+   pf->maxSourceLength = maxSource;
+   pf->maxTargetLength = maxTarget;
+   return true;
+}
+
+PhoneForward * phfwdClone(PhoneForward *pf) {
+   if (pf == NULL || pf->concurrent)
+      return NULL;
+
+   // Odłożone poddrzewa nie są współdzielone, a ich pary w indeksie
+   // odwrotnym są odfiltrowywane tylko przez strukturę pf.
+   if (pf->frozen == NULL) {
+      nextGeneration(pf);
+      reclaimPending(pf, SIZE_MAX);
+      if (isReclaiming(pf))
+         return NULL;
+   }
+
+   Family *family = pf->family;
+   if (family == NULL) {
+      family = malloc(sizeof(Family));
+      ShareTable *table = (family != NULL ? shareNew() : NULL);
+      if (table == NULL) {
+         free(family);
+         return NULL;
+      }
+      family->shared = table;
+      family->generation = pf->generation;
+   }
+
+   PhoneForward *clone = calloc(1, sizeof(PhoneForward));
+   Version *version = (clone != NULL ? slabAlloc(pf->allocator, sizeof(Version)) : NULL);
+   bool success = (version != NULL
+                   && reserveBuffers(clone, pf->maxSourceLength, pf->maxTargetLength));
+#ifdef PHONE_FORWARD_STATS
+   if (success) {
+      clone->latencies = createLatencies();
+      success = (clone->latencies != NULL);
+   }
+#endif
+
+   // Korzenie drzew dostają drugą referencję - kopia wskazuje na te same.
+   Version const *original = pf->writing;
+   if (success && original->node != NULL) {
+      success = shareAcquire(family->shared, original->node);
+      if (success && !shareAcquire(family->shared, original->reverse)) {
+         shareRelease(family->shared, original->node);
+         success = false;
+      }
+   }
+   if (!success) {
+      if (version != NULL)
+         slabFree(pf->allocator, version, sizeof(Version));
+      if (clone != NULL) {
+         free(clone->buffer);
+         free(clone->key);
+         free(clone->stack);
+         free(clone->latencies);
+         free(clone);
+      }
+      if (pf->family == NULL) {
+         shareDelete(family->shared);
+         free(family);
+      }
+      return NULL;
+   }
+
+   *version = *original;
+   version->erasing = false;
+   atomic_init(&(clone->version), version);
+   clone->writing = version;
+   clone->allocator = pf->allocator;
+   clone->targetAllocator = pf->targetAllocator;
+   clone->targets = pf->targets;
+   clone->generation = pf->generation;
+   clone->forwardCount = pf->forwardCount;
+   memcpy(clone->depths, pf->depths, sizeof(pf->depths));
+   clone->frozen = pf->frozen;
+   if (clone->frozen != NULL)
+      (clone->frozen->users)++;
+
+   pf->family = family;
+   clone->family = family;
+   if (pf->sibling == NULL)
+      pf->sibling = pf;
+   clone->sibling = pf->sibling;
+   pf->sibling = clone;
+   return clone;
+}
+
+bool addForward(PhoneForward *pf, char const *num1, size_t const length1,
+                char const *num2, size_t const length2) {
+   // Bufory pomocnicze muszą pomieścić każdy numer przekierowywany,
+   // a zastępowane przekierowanie jest odkładane do zwolnienia.
+   if (!reserveBuffers(pf, length1, length2) || !reserveRetired(pf, 1))
+      return false;
+
+   Cut newPath = {NULL, 0, 0}; // Krawędź, pod którą zaczyna się nowa ścieżka.
+   Node **slot = createPath(pf, &(pf->writing->node), num1, length1, &newPath);
+   if (slot == NULL)
+      return false;
+   Node *node = *slot;
+
+   // Nowa referencja nie jest widoczna dla innych wątków, dlatego w razie
+   // niepowodzenia można ją zwolnić od razu.
+   Target *forward = internAcquire(pf->targets, num2, length2);
+   if (forward == NULL) {
+      deleteCut(pf, newPath, NULL);
+      return false;
+   }
+
+   if (node->forward == forward) { // Takie przekierowanie już istnieje.
+      internRelease(pf->targets, forward);
+      return true;
+   }
+
+   if (!reverseInsert(pf, num2, length2, num1, length1)) {
+      internRelease(pf->targets, forward);
+      deleteCut(pf, newPath, NULL);
+      return false;
+   }
+
+   if (node->forward != NULL) {
+      reverseEraseForward(pf, node->forward, num1, length1);
+      releaseTarget(pf, node->forward);
+   }
+   else {
+      countForward(pf, length1, true);
+   }
+   node->forward = forward;
+
+   return true;
+}
+
+bool phfwdAdd(PhoneForward *pf, char const *num1, char const *num2) {
+   size_t const length = numberLength(num2);
+   size_t const sourceLength = numberLength(num1);
+   if (pf == NULL || sourceLength == 0 || length == 0
+       || strcmp(num1, num2) == 0)
+      return false;
+
+   TIMER_START(start);
+   if (!beginChange(pf))
+      return false;
+   bool const result = addForward(pf, num1, sourceLength, num2, length);
+   if (result && pf->journal != NULL)
+      journalAppend(pf->journal, num1, sourceLength, num2, length);
+   endChange(pf);
+   TIMER_STOP(pf, PHFWD_ADD, start);
+   return result;
+}
+
+/** @brief Usuwa poddrzewo z indeksu odwrotnego.
+ * Usuwa z indeksu odwrotnego pary odpowiadające wszystkim przekierowaniom
+ * przechowywanym w poddrzewie wierzchołka @p subtree i odejmuje je od
+ * liczników przekierowań.
+ * @param[in,out] pf  - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] subtree - wskaźnik na korzeń poddrzewa.
+ * @param[in] num     - wskaźnik na numer odpowiadający wierzchołkowi @p subtree.
+ * @param[in] length  - długość numeru.
+ */
+static void reverseEraseSubtree(PhoneForward *pf, Node const *subtree,
+                                char const *num, size_t const length) {
+   // Bufor pomocniczy przechowuje numer odpowiadający bieżącemu wierzchołkowi,
+   // a stos - wierzchołki na ścieżce od korzenia poddrzewa.
+   char *path = pf->buffer;
+   for (size_t i = 0; i < length; i++)
+      path[i] = num[i];
+
+   Node const **stack = (Node const **)(pf->stack);
+   size_t top = 0;
+   stack[0] = subtree;
+   size_t depth = length;
+   int startingSubtreeID = 0;
+
+   while (true) {
+      Node const *node = stack[top];
+      if (startingSubtreeID == 0 && node->forward != NULL) {
+         reverseEraseForward(pf, node->forward, path, depth);
+         countForward(pf, depth, false);
+      }
+
+      int const subtreeID = nextChild(node, startingSubtreeID);
+      if (subtreeID < NUMBER_OF_SYMBOLS) {
+         Node const *child = getChild(node, subtreeID);
+         stack[++top] = child;
+         path[depth++] = child->digit;
+         startingSubtreeID = 0;
+      }
+      else if (top == 0) {
+         break;
+      }
+      else {
+         top--;
+         depth--;
+         startingSubtreeID = digitID(path[depth]) + 1;
+      }
+   }
+}
+
+/** @brief Usuwa przekierowania w trwającej zmianie.
+ * @param[in,out] pf  - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] num     - wskaźnik na prefiks usuwanych numerów.
+ * @param[in] length  - długość prefiksu.
+ */
+static void removeForwards(PhoneForward *pf, char const *num, size_t const length) {
+   Node **root = &(pf->writing->node);
+   Cut cut = {NULL, 0, 0};
+   Node **slot = findSlot(root, num, length, &cut);
+   if (slot == NULL)
+      return;
+
+   // Wierzchołki poniżej krawędzi cut są usuwane, więc kopiujemy tylko
+   // ścieżkę do jej ojca.
+   Node *subtree = *slot;
+   if (copiesPaths(pf)) {
+      cut.slot = copyPath(pf, root, num, cut.depth);
+      if (cut.slot == NULL)
+         return;
+   }
+   if (!reserveRetired(pf, 1))
+      return;
+
+   // Duże poddrzewo jest tylko odłączane - jego pary w indeksie odwrotnym
+   // są odfiltrowywane przy odczycie, dopóki nie zostanie przejrzane.
+   // Wpisy pamięci podręcznej mogą wskazywać na jego wierzchołki.
+   if (!isSmall(pf, subtree, RECLAIM_STEP)) {
+      Node *child = getChild(*(cut.slot), cut.id);
+      if (deferSubtree(pf, child, num, cut.depth + 1)) {
+         removeChild(pf, cut.slot, cut.id);
+         if (pf->cache != NULL)
+            cacheClear(pf->cache);
+         return;
+      }
+   }
+
+   reverseEraseSubtree(pf, subtree, num, length);
+
+   // Usunięcie poddrzewa razem z martwą ścieżką, która do niego prowadzi.
+   // Wierzchołki współdzielone z klonami nie są zwalniane, więc nie dostają
+   // numeru zmiany, a wpisy pamięci podręcznej mogą na nie wskazywać.
+   if (pf->family != NULL && pf->cache != NULL)
+      cacheClear(pf->cache);
+   deleteCut(pf, cut, pf->stack);
+}
+
+void phfwdRemove(PhoneForward *pf, char const *num) {
+   size_t const length = numberLength(num);
+   TIMER_START(start);
+   if (pf == NULL || length == 0 || !beginChange(pf))
+      return;
+
+   removeForwards(pf, num, length);
+   if (pf->journal != NULL)
+      journalAppend(pf->journal, num, length, NULL, 0);
+   endChange(pf);
+   TIMER_STOP(pf, PHFWD_REMOVE, start);
+}
+
+/** @brief Rozpoczyna zapis migawki.
+ * Migawka nie może zawierać par odłożonych poddrzew, a ich usunięcie
+ * z indeksu odwrotnego zmienia drzewa, dlatego zapis struktury, która nie
+ * jest zamrożona, jest wykonywany jak zmiana.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania.
+ * @return Wartość @p true, jeśli można zapisać migawkę.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool beginSnapshot(PhoneForward *pf) {
+   if (pf->frozen != NULL)
+      return true;
+   if (!beginChange(pf))
+      return false;
+   reclaimPending(pf, SIZE_MAX);
+   return true;
+}
+
+/** @brief Kończy zapis migawki rozpoczęty przez @ref beginSnapshot.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania.
+ */
+static void endSnapshot(PhoneForward *pf) {
+   if (pf->frozen == NULL)
+      endChange(pf);
+}
+
+/** @brief Zapisuje migawkę struktury, której zmiany są wstrzymane.
+ * @param[in] pf   - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] path - ścieżka do pliku.
+ * @return Wartość @p true, jeśli migawka została zapisana.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci lub wystąpił
+ *         błąd zapisu.
+ */
+static bool saveSnapshot(PhoneForward *pf, char const *path) {
+   if (pf->frozen == NULL && pf->writing->staleReverse)
+      return false;
+   Frozen *frozen = (pf->frozen != NULL ? pf->frozen : freezeTries(pf));
+   bool const success = (frozen != NULL && snapshotWrite(frozen, path));
+   if (frozen != pf->frozen)
+      frozenRelease(frozen);
+   return success;
+}
+
+bool phfwdSave(PhoneForward *pf, char const *path) {
+   if (pf == NULL || path == NULL)
+      return false;
+
+   if (!beginSnapshot(pf))
+      return false;
+   bool const success = saveSnapshot(pf, path);
+   endSnapshot(pf);
+   return success;
+}
+
+/** @brief Wyznacza liczniki przekierowań wczytanej postaci zamrożonej.
+ * Wierzchołki drzewa przekierowań zajmują początek tablicy w kolejności
+ * poziomów, więc głębokość rośnie, gdy indeks dochodzi do końca poziomu.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania.
+ */
+static void countFrozen(PhoneForward *pf) {
+   Frozen const *frozen = pf->frozen;
+   size_t depth = 0;
+   uint32_t levelEnd = 1;  // Koniec bieżącego poziomu.
+   uint32_t nextEnd = 1;   // Koniec następnego poziomu.
+   for (uint32_t i = 0; i < frozen->reverse; i++) {
+      if (i == levelEnd) {
+         depth++;
+         levelEnd = nextEnd;
+      }
+      FlatNode const *flat = &((frozen->nodes)[i]);
+      if (flat->children != 0)
+         nextEnd = flat->subtrees + (uint32_t)popcount(flat->children);
+      if (flat->forward != NO_INDEX)
+         countForward(pf, depth, true);
+   }
+}
+
+PhoneForward * phfwdLoad(char const *path) {
+   if (path == NULL)
+      return NULL;
+
+   Frozen *frozen = snapshotLoad(path);
+   PhoneForward *pf = (frozen != NULL ? createPhoneForward(false) : NULL);
+   if (pf == NULL) {
+      frozenRelease(frozen);
+      return NULL;
+   }
+
+   // Puste drzewa utworzone razem ze strukturą zastępuje postać zamrożona.
+   // Zwykłe drzewa zostaną odtworzone przy pierwszej zmianie.
+   Version *version = pf->writing;
+   freeNode(pf, version->node, 0);
+   freeNode(pf, version->reverse, 0);
+   version->node = NULL;
+   version->reverse = NULL;
+   version->maxSourceLength = frozen->maxSourceLength;
+   pf->frozen = frozen;
+   countFrozen(pf);
+   if (!reserveBuffers(pf, frozen->maxSourceLength, frozen->maxTargetLength)) {
+      phfwdDelete(pf);
+      return NULL;
+   }
+   return pf;
+}
+
+/** @brief Wykonuje zmianę odczytaną z dziennika.
+ * @param[in,out] context - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] num1        - numer przekierowywany lub usuwany prefiks.
+ * @param[in] num2        - numer docelowy lub NULL dla usunięcia.
+ * @return Wartość @p true, jeśli zmiana została wykonana.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool replayChange(void *context, char const *num1, char const *num2) {
+   PhoneForward *pf = context;
+   if (num2 == NULL) {
+      phfwdRemove(pf, num1);
+      return true;
+   }
+   return phfwdAdd(pf, num1, num2);
+}
+
+bool phfwdAttachLog(PhoneForward *pf, char const *path, size_t const batch) {
+   if (pf == NULL || path == NULL || batch == 0 || pf->journal != NULL)
+      return false;
+
+   // Zmiany wykonywane podczas odtwarzania nie trafiają ponownie do dziennika,
+   // bo jest on przypisywany strukturze dopiero po jego otwarciu.
+   Journal *journal = journalOpen(path, batch, replayChange, pf);
+   if (journal == NULL)
+      return false;
+   if (pf->concurrent)
+      pthread_mutex_lock(&(pf->writer));
+   pf->journal = journal;
+   if (pf->concurrent)
+      pthread_mutex_unlock(&(pf->writer));
+   return true;
+}
+
+bool phfwdSync(PhoneForward *pf) {
+   if (pf == NULL || pf->journal == NULL)
+      return false;
+
+   if (pf->concurrent)
+      pthread_mutex_lock(&(pf->writer));
+   bool const success = journalSync(pf->journal);
+   if (pf->concurrent)
+      pthread_mutex_unlock(&(pf->writer));
+   return success;
+}
+
+bool phfwdCheckpoint(PhoneForward *pf, char const *path) {
+   if (pf == NULL || path == NULL || pf->journal == NULL)
+      return false;
+
+   // Dziennik jest opróżniany dopiero po utrwaleniu migawki. Awaria pomiędzy
+   // tymi krokami nie szkodzi - ponowne wykonanie zmian z dziennika na
+   // migawce, która je zawiera, daje ten sam wynik, bo każda zmiana ustala
+   // wynik dla numerów, których dotyczy, niezależnie od stanu wcześniejszego.
+   if (!beginSnapshot(pf))
+      return false;
+   bool const success = (saveSnapshot(pf, path) && journalTruncate(pf->journal));
+   endSnapshot(pf);
+   return success;
+}
+
+/** @brief Sprawdza, czy przekierowanie numeru w postaci zamrożonej jest przesłonięte.
+ * Odpowiednik funkcji @ref isOverridden.
+ * @param[in] frozen       - wskaźnik na postać zamrożoną.
+ * @param[in] source       - wskaźnik na numer przekierowywany.
+ * @param[in] sourceLength - długość numeru przekierowywanego.
+ * @param[in] suffix       - wskaźnik na napis dopisywany do numeru.
+ * @param[in] suffixLength - długość napisu @p suffix.
+ * @return Wartość @p true, jeśli przekierowanie jest przesłonięte.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool flatIsOverridden(Frozen const *frozen, char const *source,
+                             size_t const sourceLength, char const *suffix,
+                             size_t const suffixLength) {
+   FlatNode const *node = frozen->nodes;
+   for (size_t i = 0; i < sourceLength && node != NULL; i++)
+      node = frozenChild(frozen, node, digitID(source[i]));
+   for (size_t i = 0; i < suffixLength && node != NULL; i++) {
+      node = frozenChild(frozen, node, digitID(suffix[i]));
+      if (node != NULL && node->forward != NO_INDEX)
+         return true;
+   }
+   return false;
+}
+
+/** @brief Dodaje numery należące do wyniku funkcji @ref phfwdReverse
+ * w postaci zamrożonej.
+ * Odpowiednik funkcji @ref addSources.
+ * @param[in,out] pnum     - wskaźnik na strukturę przechowującą numery.
+ * @param[in] frozen       - wskaźnik na postać zamrożoną.
+ * @param[in] sources      - wskaźnik na wierzchołek indeksu odwrotnego, do
+ *                           którego prowadzi krawędź z separatorem.
+ * @param[in] preimage     - czy pomijać numery, których przekierowanie jest
+ *                           przesłonięte.
+ * @param[in] suffix       - wskaźnik na napis dopisywany do numerów.
+ * @param[in] suffixLength - długość napisu @p suffix.
+ * @param[in,out] buffer   - bufor na numery przekierowywane.
+ * @param[in,out] stack    - stos pomocniczy.
+ * @return Wartość @p true, jeśli działanie funkcji przebiegło pomyślnie.
+ *         Wartość @p false, jeśli wystąpił błąd alokacji pamięci.
+ */
+static bool flatAddSources(PhoneNumbers *pnum, Frozen const *frozen,
+                           FlatNode const *sources, bool const preimage,
+                           char const *suffix, size_t const suffixLength,
+                           char *buffer, FlatNode const **stack) {
+   size_t depth = 0;
+   stack[0] = sources;
+   int startingSubtreeID = 0;
+
+   while (true) {
+      FlatNode const *node = stack[depth];
+      if (startingSubtreeID == 0 && node->isSource
+          && (!preimage
+              || !flatIsOverridden(frozen, buffer, depth, suffix, suffixLength))) {
+         if (!phnumAdd(pnum, buffer, depth, suffix, suffixLength))
+            return false;
+      }
+
+      unsigned int const mask = (unsigned int)(node->children) >> startingSubtreeID;
+      if (mask != 0) {
+         int const subtreeID = startingSubtreeID + popcount((mask & (~mask + 1)) - 1);
+         FlatNode const *child = frozenChild(frozen, node, subtreeID);
+         buffer[depth++] = child->digit;
+         stack[depth] = child;
+         startingSubtreeID = 0;
+      }
+      else if (depth == 0) {
+         return true;
+      }
+      else {
+         depth--;
+         startingSubtreeID = digitID(buffer[depth]) + 1;
+      }
+   }
+}
+
+/** @brief Wyznacza wynik funkcji @ref phfwdReverse lub @ref phfwdGetReverse
+ * w postaci zamrożonej.
+ * Numery są dopisywane do @p pnum bez sortowania.
+ * @param[in] frozen    - wskaźnik na postać zamrożoną.
  * @param[in,out] pnum  - wskaźnik na strukturę przechowującą numery.
- * @param[in] node      - wskaźnik na wierzchołek drzewa z przekierowaniami.
- * @param[in] num       - wskaźnik na napis reprezentujący numer.
+ * @param[in] num       - wskaźnik na numer.
  * @param[in] numLength - długość numeru.
- * @param[in] depth     - głębokość, na jakiej znajduje się w drzewie 
- *                        wierzchołek @p node.
- * @return Wartość @p true, jeśli działanie funkcji przebiegło pomyślnie
- *         (nie wystąpił żaden błąd).
- *         Wartość @p false, jeśli wystąpił błąd alokacji pamięci.
+ * @param[in] preimage  - czy wyznaczyć tylko przeciwobraz funkcji @ref phfwdGet.
+ * @return Wartość @p true, jeśli działanie funkcji przebiegło pomyślnie.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
  */
-static bool AddReverseIfItExists(PhoneNumbers *pnum, Node *node, 
-               char const *num, size_t const numLength, size_t const depth) {
-   size_t const forwardLength = node->forwardLength;
-   if (forwardLength == 0 || forwardLength > numLength)
-      return true; // Funkcja się powiodła, nie dodano żadnego numeru.
-      
-   size_t pos = 0;
-   while (pos < forwardLength && (node->forward)[pos] == num[pos])
-      pos++;
+static bool frozenReverse(Frozen const *frozen, PhoneNumbers *pnum, char const *num,
+                          size_t const numLength, bool const preimage) {
+   bool const addNum = (!preimage
+                        || !flatIsOverridden(frozen, num, 0, num, numLength));
+
+   char *buffer = NULL;
+   FlatNode const **stack = malloc((frozen->maxSourceLength + 1) * sizeof(FlatNode*));
+   bool success = (stack != NULL && (!addNum || phnumAdd(pnum, num, numLength, NULL, 0))
+                   && reallocNumber(&buffer, frozen->maxSourceLength));
+
+   FlatNode const *node = &((frozen->nodes)[frozen->reverse]);
+   for (size_t position = 0; position < numLength && node != NULL && success; position++) {
+      node = frozenChild(frozen, node, digitID(num[position]));
+      FlatNode const *sources = (node != NULL ?
+                                 frozenChild(frozen, node, digitID(SEPARATOR)) : NULL);
+      if (sources != NULL)
+         success = flatAddSources(pnum, frozen, sources, preimage, num + position + 1,
+                                  numLength - position - 1, buffer, stack);
+   }
 
-   if (pos < forwardLength)
-      return true; // Funkcja się powiodła, nie dodano żadnego numeru.
-   
-   size_t resultLength = numLength - forwardLength + depth;
-   char *result = NULL;
-   if (!reallocNumber(&result, resultLength))
-      return false; // Wystąpił błąd alokacji.
+   free(buffer);
+   free(stack);
+   return success;
+}
 
-   Node *auxiliaryNode = node;
-   pos = depth - 1;
-   while (auxiliaryNode->parent != NULL) {
-      result[pos--] = auxiliaryNode->digit;
-      auxiliaryNode = (Node*)(auxiliaryNode->parent);
+/** @brief Wyznacza najgłębsze przekierowanie na ścieżce numeru w drzewie.
+ * @param[in] root     - wskaźnik na korzeń drzewa przekierowań.
+ * @param[in] num      - wskaźnik na numer.
+ * @param[out] longest - wskaźnik na długość prefiksu, dla którego istnieje
+ *                       przekierowanie (0, jeśli nie istnieje żadne).
+ * @return Wskaźnik na najgłębszy wierzchołek z przekierowaniem na ścieżce
+ *         numeru lub na korzeń, jeśli takiego nie ma.
+ */
+static Node const * trieLookup(Node const *root, char const *num, size_t *longest) {
+   Node const *node = root;
+   Node const *source = root;
+   *longest = 0;
+   for (size_t position = 0; node != NULL && isDigit(num[position]); ) {
+      node = getChild(node, digitID(num[position]));
+      position++;
+      if (node != NULL && node->forward != NULL) {
+         *longest = position;
+         source = node;
+      }
    }
-   
-   pos = depth;
-   for (size_t i = forwardLength; i <= numLength; i++)
-      result[pos++] = num[i];
+   return source;
+}
 
-   bool added = phnumAdd(pnum, result, resultLength);
-   free(result);
+/** @brief Wyznacza najgłębsze przekierowanie, korzystając z pamięci podręcznej.
+ * Wynik zależy tylko od najgłębszego wierzchołka z przekierowaniem na
+ * ścieżce numeru (lub od korzenia, jeśli takiego nie ma): zmiana, która
+ * mogłaby go zmienić, przechodzi przez ten wierzchołek albo go zwalnia.
+ * Wpis jest więc aktualny, dopóki numer zmiany wierzchołka się nie zmienił.
+ * @param[in,out] cache - wskaźnik na zajętą pamięć podręczną.
+ * @param[in] root      - wskaźnik na korzeń drzewa przekierowań.
+ * @param[in] num       - wskaźnik na numer.
+ * @param[in] numLength - długość numeru.
+ * @param[out] longest  - wskaźnik na długość prefiksu, dla którego istnieje
+ *                        przekierowanie (0, jeśli nie istnieje żadne).
+ * @return Wskaźnik na najgłębszy wierzchołek z przekierowaniem na ścieżce
+ *         numeru lub na korzeń, jeśli takiego nie ma.
+ */
+static Node const * cachedLookup(LookupCache *cache, Node const *root, char const *num,
+                                 size_t const numLength, size_t *longest) {
+   bool found;
+   CacheStats *stats = cacheStats(cache);
+   CacheEntry *entry = cacheLookup(cache, num, numLength, &found);
+   if (entry != NULL && found) {
+      Node const *cached = entry->node;
+      if (cached->generation == entry->generation) {
+         (stats->hits)++;
+         *longest = entry->depth;
+         return cached;
+      }
+      (stats->stale)++;
+   }
+   else if (entry != NULL) {
+      (stats->misses)++;
+   }
 
-   return added;
+   Node const *source = trieLookup(root, num, longest);
+   if (entry != NULL) {
+      entry->node = source;
+      entry->generation = source->generation;
+      entry->depth = (uint32_t)(*longest);
+   }
+   return source;
 }
 
-PhoneNumbers * phfwdReverse(PhoneForward const *pf, char const *num) {
+PhoneNumbers * phfwdGet(PhoneForward const *pf, char const *num) {
    if (pf == NULL)
       return NULL;
 
+   TIMER_START(start);
    PhoneNumbers *pnum = phnumCreate();
    size_t const numLength = numberLength(num);
 
    if (pnum == NULL || numLength == 0)
       return pnum;
-
-   if (!phnumAdd(pnum, num, numLength)) {
+   
+   size_t slot;
+   Version const *version = beginRead(pf, &slot);
+   size_t longest = 0;
+   bool success;
+   if (pf->frozen != NULL) {
+      FlatTarget const *target = frozenLookup(pf->frozen, num, &longest);
+      success = (target != NULL ?
+                 phnumAdd(pnum, pf->frozen->chars + target->offset, target->length,
+                          num + longest, numLength - longest)
+                 : phnumAdd(pnum, NULL, 0, num, numLength));
+   }
+   else {
+      // Pamięć podręczna nie należy do samej struktury, tylko jest dostępna
+      // przez wskaźnik, a wątek, który zastanie ją zajętą przez inny, szuka
+      // bez niej.
+      LookupCache *cache = (pf->cache != NULL && cacheAcquire(pf->cache) ? pf->cache : NULL);
+      Node const *source = (cache != NULL ?
+                            cachedLookup(cache, version->node, num, numLength, &longest)
+                            : trieLookup(version->node, num, &longest));
+      if (cache != NULL)
+         cacheRelease(cache);
+
+      // Numer docelowy może zostać zwolniony po zakończeniu odczytu.
+      success = (source->forward != NULL ?
+                 phnumAddForward(pnum, source->forward, num + longest, numLength - longest)
+                 : phnumAdd(pnum, NULL, 0, num, numLength));
+   }
+   endRead(pf, slot);
+   if (!success) {
       phnumDelete(pnum);
-      return NULL;
+      pnum = NULL;
    }
+   TIMER_STOP(pf, PHFWD_GET, start);
+   return pnum;
+}
 
-   Node *node = pf->node;
-   int startingSubtreeID = 0;
-   size_t depth = 0;
+bool phfwdSetCache(PhoneForward *pf, size_t const capacity) {
+   if (pf == NULL || pf->concurrent)
+      return false;
 
-   while (node != NULL) {
-      int subtreeID = startingSubtreeID;
-      while (subtreeID < NUMBER_OF_DIGITS && (node->subtrees)[subtreeID] == NULL)
-         subtreeID++;
+   LookupCache *cache = NULL;
+   if (capacity > 0) {
+      cache = cacheNew(capacity);
+      if (cache == NULL)
+         return false;
+   }
+   cacheDelete(pf->cache);
+   pf->cache = cache;
+   return true;
+}
 
-      if (subtreeID == NUMBER_OF_DIGITS) { // Wszystkie poddrzewa przejrzane.
-         if (!AddReverseIfItExists(pnum, node, num, numLength, depth)) {
-            phnumDelete(pnum);
-            return NULL;
-         }
+void phfwdCacheStats(PhoneForward const *pf, PhoneForwardCacheStats *stats) {
+   if (stats == NULL)
+      return;
 
-         startingSubtreeID = (digitID(node->digit)) + 1;
-         node = (Node*)(node->parent);
-         depth--;
+   memset(stats, 0, sizeof(PhoneForwardCacheStats));
+   if (pf == NULL || pf->cache == NULL)
+      return;
+   while (!cacheAcquire(pf->cache))
+      sched_yield();
+   CacheStats const *counters = cacheStats(pf->cache);
+   stats->capacity = cacheCapacity(pf->cache);
+   stats->bytes = cacheBytes(pf->cache);
+   stats->hits = counters->hits;
+   stats->misses = counters->misses;
+   stats->stale = counters->stale;
+   cacheRelease(pf->cache);
+}
+
+bool phfwdStats(PhoneForward const *pf, PhoneForwardStats *stats) {
+   if (pf == NULL || stats == NULL)
+      return false;
+
+   memset(stats, 0, sizeof(PhoneForwardStats));
+   PhoneForward *writer = (PhoneForward*)pf; // Tylko do zajęcia blokady.
+   if (pf->concurrent)
+      pthread_mutex_lock(&(writer->writer));
+   stats->forwards = pf->forwardCount;
+   for (size_t i = 0; i < PHFWD_DEPTHS; i++)
+      (stats->depths)[i] = (pf->depths)[i];
+   if (pf->frozen != NULL) {
+      Frozen const *frozen = pf->frozen;
+      stats->nodes = frozen->nodeCount;
+      stats->nodeBytes = (size_t)(frozen->nodeCount) * sizeof(FlatNode);
+      stats->stringBytes = (size_t)(frozen->targetCount) * sizeof(FlatTarget)
+                           + (size_t)(frozen->charsCount);
+   }
+   else {
+      // Struktury rodziny mają wspólny alokator, a każda liczy tylko
+      // wierzchołki, które sama przydzieliła lub zwolniła.
+      PhoneForward const *member = pf;
+      do {
+         stats->nodes += member->nodeCount;
+         stats->nodeBytes += member->nodeBytes;
+         member = (member->sibling != NULL ? member->sibling : member);
+      } while (member != pf);
+      stats->stringBytes = internBytes(pf->targets);
+   }
+   if (pf->family != NULL)
+      stats->shareBytes = shareBytes(pf->family->shared);
+   if (pf->concurrent)
+      pthread_mutex_unlock(&(writer->writer));
+
+#ifdef PHONE_FORWARD_STATS
+   stats->timed = true;
+   for (int i = 0; i < PHFWD_OPERATIONS; i++) {
+      Latency *latency = &((pf->latencies)[i]);
+      PhoneForwardLatency *result = &((stats->operations)[i]);
+      result->count = atomic_load_explicit(&(latency->count), memory_order_relaxed);
+      result->nanoseconds = atomic_load_explicit(&(latency->nanoseconds),
+                                                 memory_order_relaxed);
+      for (int j = 0; j < PHFWD_LATENCY_BUCKETS; j++)
+         (result->buckets)[j] = atomic_load_explicit(&((latency->buckets)[j]),
+                                                     memory_order_relaxed);
+   }
+#endif
+   return true;
+}
+
+/** @brief Sprawdza, czy przekierowanie numeru jest przesłonięte.
+ * Sprawdza, czy numer powstały z @p source przez dopisanie na końcu napisu
+ * @p suffix ma dłuższy niż @p source prefiks, dla którego istnieje
+ * przekierowanie. Jeśli tak, to funkcja @ref phfwdGet użyje tamtego
+ * przekierowania zamiast przekierowania numeru @p source.
+ * @param[in] root         - wskaźnik na korzeń drzewa przekierowań.
+ * @param[in] source       - wskaźnik na numer przekierowywany.
+ * @param[in] sourceLength - długość numeru przekierowywanego.
+ * @param[in] suffix       - wskaźnik na napis dopisywany do numeru.
+ * @param[in] suffixLength - długość napisu @p suffix.
+ * @return Wartość @p true, jeśli przekierowanie jest przesłonięte.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool isOverridden(Node const *root, char const *source, size_t const sourceLength, 
+                         char const *suffix, size_t const suffixLength) {
+   Node const *node = findPath(root, source, sourceLength);
+   for (size_t i = 0; i < suffixLength && node != NULL; i++) {
+      node = getChild(node, digitID(suffix[i]));
+      if (node != NULL && node->forward != NULL)
+         return true;
+   }
+   return false;
+}
+
+/** @brief Dodaje numery należące do wyniku funkcji @ref phfwdReverse.
+ * Dla każdego numeru przekierowywanego @p x zapisanego w poddrzewie
+ * @p sources indeksu odwrotnego dodaje do wyniku numer powstały z @p x
+ * przez dopisanie na końcu napisu @p suffix. Jeśli @p forwards nie ma
+ * wartości NULL, pomija numery, których przekierowanie jest przesłonięte
+ * przez przekierowanie dłuższego prefiksu.
+ * @param[in,out] pnum     - wskaźnik na strukturę przechowującą numery.
+ * @param[in] sources      - wskaźnik na wierzchołek indeksu odwrotnego, do
+ *                           którego prowadzi krawędź z separatorem.
+ * @param[in] forwards     - wskaźnik na korzeń drzewa przekierowań lub NULL.
+ * @param[in] suffix       - wskaźnik na napis dopisywany do numerów.
+ * @param[in] suffixLength - długość napisu @p suffix.
+ * @param[in,out] buffer   - bufor, w którym budowane są numery przekierowywane;
+ *                           musi pomieścić najdłuższy z nich.
+ * @param[in,out] stack    - stos pomocniczy; musi pomieścić wierzchołki
+ *                           najdłuższej ścieżki w poddrzewie @p sources.
+ * @return Wartość @p true, jeśli działanie funkcji przebiegło pomyślnie.
+ *         Wartość @p false, jeśli wystąpił błąd alokacji pamięci.
+ */
+static bool addSources(PhoneNumbers *pnum, Node const *sources, Node const *forwards,
+                       char const *suffix, size_t const suffixLength, char *buffer,
+                       Node const **stack) {
+   size_t depth = 0;
+   stack[0] = sources;
+   int startingSubtreeID = 0;
+
+   while (true) {
+      Node const *node = stack[depth];
+      if (startingSubtreeID == 0 && node->isSource
+          && (forwards == NULL 
+              || !isOverridden(forwards, buffer, depth, suffix, suffixLength))) {
+         if (!phnumAdd(pnum, buffer, depth, suffix, suffixLength))
+            return false;
       }
-      else {
-         node = (node->subtrees)[subtreeID];
+
+      int const subtreeID = nextChild(node, startingSubtreeID);
+      if (subtreeID < NUMBER_OF_SYMBOLS) {
+         Node const *child = getChild(node, subtreeID);
+         buffer[depth++] = child->digit;
+         stack[depth] = child;
          startingSubtreeID = 0;
-         depth++;
+      }
+      else if (depth == 0) {
+         return true;
+      }
+      else {
+         depth--;
+         startingSubtreeID = digitID(buffer[depth]) + 1;
       }
    }
+}
 
-   phnumSortAndDeleteDuplicates(pnum);
-   return pnum;
+bool isForwardedTo(Node const *root, char const *number, size_t const length,
+                   char const *num, uint8_t const *packed, size_t const numLength,
+                   bool const preimage) {
+   bool result = (length == numLength && memcmp(number, num, length) == 0);
+   Node const *node = root;
+   for (size_t depth = 1; depth <= length && node != NULL; depth++) {
+      node = getChild(node, digitID(number[depth - 1]));
+      if (node == NULL || node->forward == NULL)
+         continue;
+
+      Target const *target = node->forward;
+      bool const matches = (target->length + length - depth == numLength
+                            && internPackedEqual(target->digits, packed, target->length)
+                            && memcmp(number + depth, num + target->length, 
+                                      length - depth) == 0);
+      if (preimage) // Rozstrzyga najgłębsze przekierowanie.
+         result = matches;
+      else if (matches)
+         return true;
+   }
+   return result;
 }
 
-PhoneNumbers * phfwdGetReverse(PhoneForward const *pf, char const *num) {
+/** @brief Usuwa z wyniku numery pochodzące z nieaktualnych par.
+ * Potrzebne tylko wtedy, gdy indeks odwrotny wersji może zawierać pary,
+ * których nie udało się z niego usunąć.
+ * @param[in,out] pnum  - wskaźnik na strukturę przechowującą numery.
+ * @param[in] root      - wskaźnik na korzeń drzewa przekierowań.
+ * @param[in] num       - wskaźnik na numer docelowy.
+ * @param[in] numLength - długość numeru docelowego.
+ * @param[in] preimage  - czy wynik jest przeciwobrazem funkcji @ref phfwdGet.
+ * @return Wartość @p true, jeśli działanie funkcji przebiegło pomyślnie.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool dropStale(PhoneNumbers *pnum, Node const *root, char const *num,
+                      size_t const numLength, bool const preimage) {
+   uint8_t *packed = malloc(PACKED_SIZE(numLength));
+   if (packed == NULL)
+      return false;
+   internPack(packed, num, numLength);
+
+   size_t kept = 0;
+   for (size_t i = 0; i < pnum->count; i++) {
+      char const *number = pnum->chars + (pnum->numbers)[i].offset;
+      if (isForwardedTo(root, number, strlen(number), num, packed, numLength, preimage))
+         (pnum->numbers)[kept++] = (pnum->numbers)[i];
+   }
+   pnum->count = kept;
+   free(packed);
+   return true;
+}
+
+/** @brief Wyznacza wynik funkcji @ref phfwdReverse lub @ref phfwdGetReverse.
+ * @param[in] pf        - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] num       - wskaźnik na napis reprezentujący numer.
+ * @param[in] preimage  - czy wyznaczyć tylko przeciwobraz funkcji @ref phfwdGet.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci albo wskaźnik @p pf ma wartość NULL.
+ */
+static PhoneNumbers * reverse(PhoneForward const *pf, char const *num, bool const preimage) {
    if (pf == NULL)
       return NULL;
 
-   PhoneNumbers *pnumReverse = phfwdReverse(pf, num);
-   PhoneNumbers *pnumResult = phnumCreate();
+   PhoneNumbers *pnum = phnumCreate();
+   size_t const numLength = numberLength(num);
 
-   if (pnumReverse == NULL || pnumResult == NULL) {
-      phnumDelete(pnumReverse);
-      phnumDelete(pnumResult);
-      return NULL;
-   }
+   if (pnum == NULL || numLength == 0)
+      return pnum;
 
-   for (size_t pos = 0; pos < pnumReverse->count; pos++) {
-      char const *checkedNumber = phnumGet(pnumReverse, pos);
-      PhoneNumbers *pnumGet = phfwdGet(pf, checkedNumber);
-      if (pnumGet == NULL) {
-         phnumDelete(pnumReverse);
-         phnumDelete(pnumResult);
+   if (pf->frozen != NULL) {
+      if (!frozenReverse(pf->frozen, pnum, num, numLength, preimage)) {
+         phnumDelete(pnum);
          return NULL;
       }
+      phnumSortAndDeleteDuplicates(pnum);
+      return pnum;
+   }
 
-      char const *resultNumber = phnumGet(pnumGet, 0);
-      if (resultNumber != NULL && strcmp(resultNumber, num) == 0) {
-         // Numer należy do przeciwobrazu funkcji phfwdGet.
-         if (!phnumAdd(pnumResult, checkedNumber, numberLength(checkedNumber))) {
-            phnumDelete(pnumGet);
-            phnumDelete(pnumReverse);
-            phnumDelete(pnumResult);
-            return NULL;
-         }
-      }
+   size_t slot;
+   Version const *version = beginRead(pf, &slot);
+
+   // Numer num jest swoim przeciwobrazem, jeśli żaden jego prefiks
+   // nie jest przekierowany.
+   Node const *forwards = (preimage ? version->node : NULL);
+   bool const addNum = (!preimage || !isOverridden(forwards, num, 0, num, numLength));
 
-      phnumDelete(pnumGet);
+   char *buffer = NULL;
+   Node const **stack = malloc((version->maxSourceLength + 1) * sizeof(Node*));
+   if (stack == NULL || (addNum && !phnumAdd(pnum, num, numLength, NULL, 0))
+       || !reallocNumber(&buffer, version->maxSourceLength)) {
+      endRead(pf, slot);
+      free(stack);
+      phnumDelete(pnum);
+      return NULL;
+   }
+
+   // Przekierowania, które mogą zmienić jakiś numer w num, mają numer
+   // docelowy będący prefiksem num - przeglądamy tylko te prefiksy.
+   Node const *node = version->reverse;
+   bool success = true;
+   for (size_t position = 0; position < numLength && node != NULL && success; position++) {
+      node = getChild(node, digitID(num[position]));
+      Node const *sources = (node != NULL ? getChild(node, digitID(SEPARATOR)) : NULL);
+      if (sources != NULL)
+         success = addSources(pnum, sources, forwards, num + position + 1, 
+                              numLength - position - 1, buffer, stack);
    }
+   if (success && (version->staleReverse || version->erasing))
+      success = dropStale(pnum, version->node, num, numLength, preimage);
+   endRead(pf, slot);
 
-   phnumDelete(pnumReverse);
-   return pnumResult;
+   free(buffer);
+   free(stack);
+   if (!success) {
+      phnumDelete(pnum);
+      return NULL;
+   }
+   phnumSortAndDeleteDuplicates(pnum);
+   return pnum;
+}
+
+PhoneNumbers * phfwdReverse(PhoneForward const *pf, char const *num) {
+   TIMER_START(start);
+   PhoneNumbers *pnum = reverse(pf, num, false);
+   TIMER_STOP(pf, PHFWD_REVERSE, start);
+   return pnum;
+}
+
+PhoneNumbers * phfwdGetReverse(PhoneForward const *pf, char const *num) {
+   TIMER_START(start);
+   PhoneNumbers *pnum = reverse(pf, num, true);
+   TIMER_STOP(pf, PHFWD_GET_REVERSE, start);
+   return pnum;
 }
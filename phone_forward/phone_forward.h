@@ -11,6 +11,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /** @struct PhoneForward
  * To jest struktura przechowująca przekierowania numerów telefonów.
@@ -30,6 +31,80 @@ struct PhoneNumbers;
  */
 typedef struct PhoneNumbers PhoneNumbers;
 
+/** @struct ReverseIterator
+ * To jest struktura iteratora po wyniku funkcji @ref phfwdReverse.
+ */
+struct ReverseIterator;
+/** @typedef ReverseIterator
+ * Definicja struktury ReverseIterator.
+ */
+typedef struct ReverseIterator ReverseIterator;
+
+/** @struct PhoneForwardPair
+ * To jest struktura opisująca jedno przekierowanie dodawane przez
+ * @ref phfwdAddBulk.
+ */
+typedef struct PhoneForwardPair {
+   char const *num1; ///< Prefiks numerów przekierowywanych.
+   char const *num2; ///< Prefiks numerów, na które jest wykonywane przekierowanie.
+} PhoneForwardPair;
+
+/** @struct PhoneForwardCacheStats
+ * To jest struktura opisująca pamięć podręczną wyników @ref phfwdGet.
+ */
+typedef struct PhoneForwardCacheStats {
+   size_t capacity; ///< Liczba wpisów (0 - pamięć podręczna jest wyłączona).
+   size_t bytes;    ///< Liczba bajtów zajmowanych przez pamięć podręczną.
+   size_t hits;     ///< Liczba wyników odczytanych z pamięci podręcznej.
+   size_t misses;   ///< Liczba wyników, których nie było w pamięci podręcznej.
+   size_t stale;    ///< Liczba zapamiętanych wyników unieważnionych przez zmiany.
+} PhoneForwardCacheStats;
+
+/** Liczba przedziałów histogramu długości numerów przekierowywanych. */
+#define PHFWD_DEPTHS 32
+
+/** Liczba przedziałów histogramu czasów wykonania operacji. */
+#define PHFWD_LATENCY_BUCKETS 32
+
+/** Operacje, których czasy wykonania są mierzone. */
+typedef enum PhoneForwardOperation {
+   PHFWD_ADD,         ///< @ref phfwdAdd.
+   PHFWD_REMOVE,      ///< @ref phfwdRemove.
+   PHFWD_GET,         ///< @ref phfwdGet.
+   PHFWD_REVERSE,     ///< @ref phfwdReverse.
+   PHFWD_GET_REVERSE, ///< @ref phfwdGetReverse.
+   PHFWD_OPERATIONS   ///< Liczba operacji.
+} PhoneForwardOperation;
+
+/** @struct PhoneForwardLatency
+ * To jest struktura opisująca czasy wykonania jednej operacji.
+ */
+typedef struct PhoneForwardLatency {
+   uint64_t count;       ///< Liczba wykonań.
+   uint64_t nanoseconds; ///< Łączny czas wykonań w nanosekundach.
+   /** Histogram czasów - przedział @p i liczy wykonania trwające od 2^i
+    * do 2^(i+1) - 1 nanosekund, a ostatni także wszystkie dłuższe. */
+   uint64_t buckets[PHFWD_LATENCY_BUCKETS];
+} PhoneForwardLatency;
+
+/** @struct PhoneForwardStats
+ * To jest struktura opisująca rozmiar struktury przechowującej
+ * przekierowania i czasy wykonania operacji.
+ */
+typedef struct PhoneForwardStats {
+   size_t nodes;       ///< Liczba wierzchołków obu drzew (także czekających na zwolnienie).
+   size_t nodeBytes;   ///< Liczba bajtów zajmowanych przez wierzchołki.
+   size_t stringBytes; ///< Liczba bajtów zajmowanych przez numery docelowe.
+   size_t shareBytes;  ///< Liczba bajtów liczników referencji wierzchołków
+                       ///< współdzielonych z klonami.
+   size_t forwards;    ///< Liczba przekierowań.
+   /** Histogram długości numerów przekierowywanych - przedział @p i liczy
+    * przekierowania numerów długości @p i, a ostatni także dłuższych. */
+   size_t depths[PHFWD_DEPTHS];
+   bool timed;         ///< Czy czasy operacji są mierzone.
+   PhoneForwardLatency operations[PHFWD_OPERATIONS]; ///< Czasy kolejnych operacji.
+} PhoneForwardStats;
+
 /** @brief Tworzy nową strukturę.
  * Tworzy nową strukturę niezawierającą żadnych przekierowań.
  * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
@@ -37,6 +112,37 @@ typedef struct PhoneNumbers PhoneNumbers;
  */
 PhoneForward * phfwdNew(void);
 
+/** @brief Tworzy nową strukturę działającą w trybie współbieżnym.
+ * Tworzy nową strukturę niezawierającą żadnych przekierowań. Funkcje
+ * @ref phfwdGet, @ref phfwdGetBatch, @ref phfwdReverse i @ref phfwdGetReverse
+ * mogą być wywoływane na tej strukturze jednocześnie z wielu wątków, także
+ * w trakcie wykonywania @ref phfwdAdd lub @ref phfwdRemove, i nie czekają
+ * na zakończenie zmian. Każde wywołanie widzi stan sprzed albo po całej
+ * zmianie. Funkcje @ref phfwdAdd i @ref phfwdRemove są wykonywane po kolei.
+ * Funkcja @ref phfwdDelete nie może być wykonywana jednocześnie z innymi.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+PhoneForward * phfwdNewConcurrent(void);
+
+/** @brief Tworzy kopię struktury.
+ * Kopia zawiera te same przekierowania co struktura @p pf, ale dalsze zmiany
+ * każdej z nich nie są widoczne w drugiej. Kopia jest tworzona w czasie
+ * stałym - obie struktury współdzielą wierzchołki drzew i numery docelowe,
+ * a zmiana kopiuje tylko wierzchołki na ścieżkach, które zmienia. Poddrzewa
+ * odłączone przez @ref phfwdRemove i jeszcze niezwolnione są przed
+ * utworzeniem kopii zwalniane. Kopia nie ma pamięci podręcznej wyników ani
+ * dziennika zmian. Struktur współdzielących wierzchołki nie wolno używać
+ * jednocześnie z różnych wątków. Kopię usuwa się funkcją @ref phfwdDelete,
+ * w dowolnej kolejności względem oryginału.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania
+ *                     numerów.
+ * @return Wskaźnik na utworzoną kopię lub NULL, gdy nie udało się alokować
+ *         pamięci, wskaźnik @p pf ma wartość NULL lub struktura działa
+ *         w trybie współbieżnym.
+ */
+PhoneForward * phfwdClone(PhoneForward *pf);
+
 /** @brief Usuwa strukturę.
  * Usuwa strukturę wskazywaną przez @p pf. Nic nie robi, jeśli wskaźnik ten ma
  * wartość NULL.
@@ -63,22 +169,62 @@ void phfwdDelete(PhoneForward *pf);
  */
 bool phfwdAdd(PhoneForward *pf, char const *num1, char const *num2);
 
+/** @brief Dodaje wiele przekierowań.
+ * Działa jak wywołanie @ref phfwdAdd kolejno dla każdej z @p count par
+ * z tablicy @p pairs - jeśli numer @p num1 powtarza się, obowiązuje ostatnie
+ * przekierowanie. Jeśli pary są posortowane według numerów @p num1
+ * w kolejności cyfr (* i # po 9), drzewa są budowane w jednym przebiegu,
+ * bez przechodzenia od korzenia dla każdej pary. W trybie współbieżnym
+ * wszystkie przekierowania stają się widoczne jednocześnie.
+ * @param[in,out] pf  – wskaźnik na strukturę przechowującą przekierowania
+ *                      numerów;
+ * @param[in] pairs   – tablica dodawanych przekierowań;
+ * @param[in] count   – liczba przekierowań.
+ * @return Wartość @p true, jeśli wszystkie przekierowania zostały dodane.
+ *         Wartość @p false, jeśli wystąpił błąd, np. któraś para nie jest
+ *         poprawnym argumentem @ref phfwdAdd (struktura nie jest wtedy
+ *         zmieniana), wskaźnik @p pf ma wartość NULL lub nie udało się
+ *         alokować pamięci (część przekierowań mogła zostać dodana).
+ */
+bool phfwdAddBulk(PhoneForward *pf, PhoneForwardPair const *pairs, size_t count);
+
 /** @brief Usuwa przekierowania.
  * Usuwa wszystkie przekierowania, w których parametr @p num jest prefiksem
  * parametru @p num1 użytego przy dodawaniu. Jeśli nie ma takich przekierowań,
  * wskaźnik @p pf ma wartość NULL lub napis nie reprezentuje numeru, 
- * nic nie robi.
+ * nic nie robi. Duże poddrzewo usuwanych przekierowań jest tylko odłączane
+ * w czasie proporcjonalnym do długości @p num, a jego pamięć jest zwalniana
+ * po kawałku przy kolejnych zmianach przekierowań lub przez
+ * @ref phfwdReclaim.
  * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania
  *                     numerów;
  * @param[in] num    – wskaźnik na napis reprezentujący prefiks numerów.
  */
 void phfwdRemove(PhoneForward *pf, char const *num);
 
+/** @brief Zwalnia pamięć usuniętych przekierowań.
+ * Przegląda najwyżej @p limit wierzchołków poddrzew odłączonych przez
+ * @ref phfwdRemove, zwalniając je. Pozwala zwolnić pamięć, gdy struktura nie
+ * jest obciążona, np. w pętli z wątku pomocniczego w trybie współbieżnym,
+ * w którym funkcja wstrzymuje zmiany przekierowań na czas swojego działania.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania
+ *                     numerów;
+ * @param[in] limit  – największa liczba przeglądanych wierzchołków.
+ * @return Wartość @p true, jeśli nie ma już poddrzew do przejrzenia (w trybie
+ *         współbieżnym poddrzewa, które mogą być jeszcze czytane przez inne
+ *         wątki, są przeglądane dopiero później).
+ *         Wartość @p false, jeśli zostały poddrzewa do przejrzenia, wskaźnik
+ *         @p pf ma wartość NULL lub nie udało się alokować pamięci.
+ */
+bool phfwdReclaim(PhoneForward *pf, size_t limit);
+
 /** @brief Wyznacza przekierowanie numeru.
  * Wyznacza przekierowanie podanego numeru. Szuka najdłuższego pasującego
  * prefiksu. Wynikiem jest ciąg zawierający co najwyżej jeden numer. Jeśli dany
  * numer nie został przekierowany, to wynikiem jest ciąg zawierający ten numer.
  * Jeśli podany napis nie reprezentuje numeru, wynikiem jest pusty ciąg.
+ * Funkcja nie zmienia przekierowań, ale z włączoną pamięcią podręczną
+ * (@ref phfwdSetCache) zapisuje w niej wynik.
  * Alokuje strukturę @p PhoneNumbers, która musi być zwolniona za pomocą
  * funkcji @ref phnumDelete. Funkcja phfwdGet przekazuje własność zwracanego 
  * wskaźnika funkcji, która ją wywołała.
@@ -137,4 +283,208 @@ char const * phnumGet(PhoneNumbers const *pnum, size_t idx);
  */
 PhoneNumbers * phfwdGetReverse(PhoneForward const *pf, char const *num);
 
+/** @brief Tworzy iterator po wyniku funkcji @ref phfwdReverse.
+ * Kolejne wywołania @ref phfwdReverseNext zwracają te same numery, co
+ * @ref phfwdReverse, w tej samej kolejności i bez powtórzeń, ale bez
+ * wyznaczania i sortowania całego wyniku - numery są wyznaczane na bieżąco,
+ * od razu w porządku leksykograficznym. Iterator odczytuje stan struktury
+ * z chwili utworzenia. W trybie współbieżnym zmiany przekierowań nie wpływają
+ * na iterator, ale wstrzymują zwolnienie pamięci odczytywanej wersji aż do
+ * usunięcia iteratora. Na bieżąco może w tym trybie czytać strukturę
+ * jednocześnie co najwyżej 32 iteratorów - każdy kolejny od razu wyznacza
+ * cały wynik, tak jak @ref phfwdReverse, i zwraca numery z jego kopii.
+ * Iteratory nie wstrzymują więc innych odczytów. W pozostałych przypadkach
+ * zmiana przekierowań unieważnia iterator, który można już tylko usunąć. Iterator musi być
+ * zwolniony za pomocą funkcji @ref phfwdReverseIterDelete.
+ * @param[in] pf    – wskaźnik na strukturę przechowującą przekierowania
+ *                    numerów;
+ * @param[in] num   – wskaźnik na napis reprezentujący numer;
+ * @param[in] limit – największa liczba zwracanych numerów (0 oznacza brak
+ *                    ograniczenia).
+ * @return Wskaźnik na utworzony iterator lub NULL, gdy nie udało się alokować
+ *         pamięci albo wskaźnik @p pf ma wartość NULL. Jeśli napis @p num
+ *         nie reprezentuje numeru, iterator nie zwraca żadnego numeru.
+ */
+ReverseIterator * phfwdReverseIter(PhoneForward const *pf, char const *num, size_t limit);
+
+/** @brief Zwraca kolejny numer iteratora.
+ * @param[in,out] it – wskaźnik na iterator.
+ * @return Wskaźnik na napis reprezentujący numer, ważny do kolejnego wywołania
+ *         funkcji dla tego iteratora. Wartość NULL, jeśli zwrócono już
+ *         wszystkie numery lub @p limit numerów, wskaźnik @p it ma wartość
+ *         NULL albo nie udało się alokować pamięci.
+ */
+char const * phfwdReverseNext(ReverseIterator *it);
+
+/** @brief Usuwa iterator.
+ * Nic nie robi, jeśli wskaźnik @p it ma wartość NULL.
+ * @param[in] it – wskaźnik na usuwany iterator.
+ */
+void phfwdReverseIterDelete(ReverseIterator *it);
+
+/** @brief Wyznacza przekierowania wielu numerów.
+ * Dla każdego z @p count numerów z tablicy @p nums wyznacza wynik funkcji
+ * @ref phfwdGet. Numery są przetwarzane w kolejności leksykograficznej, dzięki
+ * czemu wspólne prefiksy kolejnych numerów są przechodzone w drzewie tylko raz.
+ * Wynik dla numeru @p nums[i] jest udostępniany przez @ref phnumGet pod
+ * indeksem @p i. Jeśli napis @p nums[i] nie reprezentuje numeru, pod tym
+ * indeksem jest udostępniana wartość NULL. Funkcja ta alokuje strukturę
+ * @p PhoneNumbers, która musi być zwolniona za pomocą funkcji @ref phnumDelete.
+ * @param[in] pf    – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] nums  – tablica wskaźników na napisy reprezentujące numery;
+ * @param[in] count – liczba numerów.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci albo wskaźnik @p pf ma wartość NULL.
+ */
+PhoneNumbers * phfwdGetBatch(PhoneForward const *pf, char const * const *nums, 
+                             size_t count);
+
+/** @brief Włącza pamięć podręczną wyników funkcji @ref phfwdGet.
+ * Pamięć podręczna ma co najmniej @p capacity wpisów (liczba jest
+ * zaokrąglana w górę do potęgi dwójki) i zapamiętuje wyniki ostatnio
+ * wyszukiwanych numerów o długości co najwyżej 32. Wynik jest ważny, dopóki
+ * nie zmieni się przekierowanie, od którego zależy - zmiany innych
+ * przekierowań go nie unieważniają. Wcześniej zapamiętane wyniki są
+ * odrzucane. Wywołania @ref phfwdGet mogą się odbywać równolegle: pamięć
+ * podręczną zajmuje naraz jeden wątek, a pozostałe wyszukują wtedy bez niej.
+ * Jak bez pamięci podręcznej, nie mogą się odbywać równolegle ze zmianami
+ * przekierowań. Nie można włączyć pamięci podręcznej w trybie współbieżnym -
+ * wątki czytające w tym trybie nigdy z niej nie korzystają.
+ * @param[in,out] pf    – wskaźnik na strukturę przechowującą przekierowania
+ *                        numerów;
+ * @param[in] capacity  – liczba wpisów (0 wyłącza pamięć podręczną).
+ * @return Wartość @p true, jeśli pamięć podręczna została włączona lub
+ *         wyłączona.
+ *         Wartość @p false, jeśli wystąpił błąd, np. struktura działa
+ *         w trybie współbieżnym, wskaźnik @p pf ma wartość NULL, liczba
+ *         wpisów jest za duża lub nie udało się alokować pamięci
+ *         (poprzednia pamięć podręczna pozostaje wtedy włączona).
+ */
+bool phfwdSetCache(PhoneForward *pf, size_t capacity);
+
+/** @brief Odczytuje liczniki pamięci podręcznej wyników.
+ * Liczniki są zerowane przy włączeniu pamięci podręcznej.
+ * @param[in] pf     – wskaźnik na strukturę przechowującą przekierowania
+ *                     numerów;
+ * @param[out] stats – wskaźnik na wynik.
+ */
+void phfwdCacheStats(PhoneForward const *pf, PhoneForwardCacheStats *stats);
+
+/** @brief Odczytuje statystyki struktury.
+ * Liczby wierzchołków, przekierowań i bajtów są aktualizowane przy każdej
+ * zmianie, więc odczyt nie przechodzi drzew. Przekierowania poddrzewa
+ * odłączonego przez @ref phfwdRemove są odejmowane w miarę zwalniania jego
+ * pamięci. W postaci zamrożonej liczone są
+ * wierzchołki i numery postaci zamrożonej. Struktura, która ma kopie
+ * utworzone przez @ref phfwdClone, podaje wierzchołki i numery wspólne dla
+ * wszystkich kopii. Czasy operacji są mierzone tylko
+ * w bibliotece skompilowanej z makrem @p PHONE_FORWARD_STATS - w przeciwnym
+ * razie pole @p timed ma wartość @p false, a czasy są zerami. W trybie
+ * współbieżnym odczyt wstrzymuje zmiany przekierowań, ale nie ich odczyty.
+ * @param[in] pf     – wskaźnik na strukturę przechowującą przekierowania
+ *                     numerów;
+ * @param[out] stats – wskaźnik na wynik.
+ * @return Wartość @p true, jeśli statystyki zostały odczytane.
+ *         Wartość @p false, jeśli wskaźnik @p pf lub @p stats ma wartość NULL.
+ */
+bool phfwdStats(PhoneForward const *pf, PhoneForwardStats *stats);
+
+/** @brief Zamraża strukturę.
+ * Zamienia drzewa przechowujące przekierowania na zwartą postać tylko do
+ * odczytu, w której wierzchołki leżą w jednej tablicy w kolejności poziomów
+ * i odwołują się do synów za pomocą 32-bitowych indeksów. Wyniki funkcji
+ * @ref phfwdGet, @ref phfwdGetBatch, @ref phfwdReverse i @ref phfwdGetReverse
+ * nie zmieniają się. Pierwsze wywołanie @ref phfwdAdd lub @ref phfwdRemove
+ * odtwarza zwykłą postać struktury. Nie można zamrozić struktury działającej
+ * w trybie współbieżnym.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania
+ *                     numerów.
+ * @return Wartość @p true, jeśli struktura jest zamrożona.
+ *         Wartość @p false, jeśli wystąpił błąd, np. struktura działa
+ *         w trybie współbieżnym, wskaźnik @p pf ma wartość NULL lub nie
+ *         udało się alokować pamięci (struktura nie jest wtedy zmieniana).
+ *         Zamrożenie nie udaje się też, jeśli po wcześniejszym niepowodzeniu
+ *         alokacji w strukturze mającej kopie indeks odwrotny zawiera
+ *         nieaktualne pary.
+ */
+bool phfwdFreeze(PhoneForward *pf);
+
+/** @brief Zapisuje migawkę struktury do pliku.
+ * Zapisuje przekierowania w postaci zamrożonej (zob. @ref phfwdFreeze)
+ * poprzedzonej nagłówkiem z wersją formatu i sumą kontrolną. Plik nie zawiera
+ * wskaźników, ale zachowuje kolejność bajtów komputera, który go zapisał.
+ * Struktura nie jest zmieniana. W trybie współbieżnym zapis wstrzymuje
+ * zmiany przekierowań, ale nie ich odczyty.
+ * @param[in] pf   – wskaźnik na strukturę przechowującą przekierowania
+ *                   numerów;
+ * @param[in] path – ścieżka do pliku.
+ * @return Wartość @p true, jeśli migawka została zapisana.
+ *         Wartość @p false, jeśli wystąpił błąd, np. wskaźnik @p pf lub
+ *         @p path ma wartość NULL, nie udało się alokować pamięci lub
+ *         zapisać pliku.
+ */
+bool phfwdSave(PhoneForward *pf, char const *path);
+
+/** @brief Wczytuje strukturę z migawki.
+ * Odwzorowuje plik zapisany przez @ref phfwdSave w pamięci i odpowiada na
+ * zapytania bezpośrednio z niego, bez kopiowania. Utworzona struktura jest
+ * zamrożona - pierwsze wywołanie @ref phfwdAdd lub @ref phfwdRemove kopiuje
+ * przekierowania do zwykłej postaci i zwalnia odwzorowanie. Struktura nie
+ * działa w trybie współbieżnym.
+ * @param[in] path – ścieżka do pliku.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         otworzyć pliku, plik nie jest poprawną migawką (np. ma inną wersję
+ *         formatu lub niezgodną sumę kontrolną) albo nie udało się alokować
+ *         pamięci.
+ */
+PhoneForward * phfwdLoad(char const *path);
+
+/** @brief Włącza dziennik zmian struktury.
+ * Najpierw wykonuje zmiany zapisane w pliku @p path (jeśli istnieje), np.
+ * przez strukturę, która uległa awarii. Potem każde udane wywołanie
+ * @ref phfwdAdd, @ref phfwdAddBulk i @ref phfwdRemove jest dopisywane do
+ * pliku, a co @p batch zmian plik jest utrwalany jednym wywołaniem
+ * fdatasync. Po awarii może więc zostać utracone co najwyżej @p batch - 1
+ * ostatnich zmian niezatwierdzonych przez @ref phfwdSync. Odtworzenie
+ * struktury po awarii polega na wczytaniu ostatniej migawki zapisanej przez
+ * @ref phfwdCheckpoint (lub utworzeniu pustej struktury) i wywołaniu tej
+ * funkcji z tym samym plikiem. Nie może być wywoływana równolegle z innymi
+ * funkcjami zmieniającymi strukturę.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania
+ *                     numerów;
+ * @param[in] path   – ścieżka do pliku z dziennikiem;
+ * @param[in] batch  – liczba zmian utrwalanych jednym wywołaniem fdatasync.
+ * @return Wartość @p true, jeśli dziennik został włączony.
+ *         Wartość @p false, jeśli wystąpił błąd, np. wskaźnik @p pf lub
+ *         @p path ma wartość NULL, @p batch jest równe 0, struktura ma już
+ *         dziennik, plik nie jest dziennikiem albo nie udało się go otworzyć
+ *         lub alokować pamięci.
+ */
+bool phfwdAttachLog(PhoneForward *pf, char const *path, size_t batch);
+
+/** @brief Utrwala zmiany czekające w dzienniku.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania
+ *                     numerów.
+ * @return Wartość @p true, jeśli wszystkie dotychczasowe zmiany są utrwalone.
+ *         Wartość @p false, jeśli struktura nie ma dziennika albo od
+ *         ostatniego wywołania @ref phfwdCheckpoint wystąpił błąd zapisu do
+ *         dziennika lub nie udało się wykonać zmiany, której dziennik nie
+ *         może odtworzyć (nieudane @ref phfwdAddBulk).
+ */
+bool phfwdSync(PhoneForward *pf);
+
+/** @brief Zapisuje migawkę struktury i opróżnia dziennik.
+ * Zapisuje migawkę jak @ref phfwdSave, a po jej utrwaleniu usuwa z dziennika
+ * zmiany, które zawiera. Dzięki temu odtworzenie struktury wykonuje tylko
+ * zmiany późniejsze niż migawka. Kończy stan błędu dziennika.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania
+ *                     numerów;
+ * @param[in] path   – ścieżka do pliku z migawką.
+ * @return Wartość @p true, jeśli migawka została zapisana i dziennik
+ *         opróżniony.
+ *         Wartość @p false, jeśli wystąpił błąd, np. struktura nie ma
+ *         dziennika lub nie udało się zapisać pliku.
+ */
+bool phfwdCheckpoint(PhoneForward *pf, char const *path);
+
 #endif /* __PHONE_FORWARD_H__ */
@@ -0,0 +1,515 @@
+/** @file
+ * Program wykonujący polecenia na strukturach przechowujących przekierowania
+ * numerów telefonicznych.
+ *
+ * Polecenia są wczytywane ze standardowego wejścia lub z pliku podanego
+ * jako argument, po jednym w wierszu:
+ * - `NEW id` – tworzy strukturę o nazwie @p id, jeśli jej nie ma, i ustawia
+ *   ją jako bieżącą;
+ * - `DEL id` – usuwa strukturę o nazwie @p id;
+ * - `ADD num1 num2` – dodaje przekierowanie w bieżącej strukturze;
+ * - `DEL num` – usuwa przekierowania numerów o prefiksie @p num;
+ * - `GET num` – wypisuje przekierowanie numeru;
+ * - `REV num` – wypisuje wynik @ref phfwdReverse, po jednym numerze
+ *   w wierszu;
+ * - `GETREV num` – wypisuje wynik @ref phfwdGetReverse, po jednym numerze
+ *   w wierszu.
+ *
+ * Nazwa struktury zaczyna się od litery, a numer składa się z cyfr oraz
+ * znaków * i #. Przy błędnym poleceniu program wypisuje na standardowe
+ * wyjście diagnostyczne `ERROR` i numer wiersza, a przy braku pamięci
+ * `ERROR MEMORY`, i kończy działanie z kodem 1. Opcja `--stats` wypisuje na
+ * standardowe wyjście diagnostyczne liczbę i szybkość wykonania poleceń
+ * każdego rodzaju.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "phone_forward.h"
+
+/** Początkowy rozmiar bufora wejścia. Bufor rośnie tylko dla dłuższych wierszy. */
+#define INPUT_BLOCK (1 << 20)
+
+/** Rozmiar bufora wyjścia. */
+#define OUTPUT_BLOCK (1 << 20)
+
+/** Największa liczba słów polecenia. */
+#define MAX_WORDS 3
+
+/** Rodzaje poleceń. */
+typedef enum Command {
+   COMMAND_NEW,    ///< Utworzenie lub wybór struktury.
+   COMMAND_ADD,    ///< Dodanie przekierowania.
+   COMMAND_DEL,    ///< Usunięcie struktury lub przekierowań.
+   COMMAND_GET,    ///< Przekierowanie numeru.
+   COMMAND_REV,    ///< Wynik @ref phfwdReverse.
+   COMMAND_GETREV, ///< Wynik @ref phfwdGetReverse.
+   COMMANDS        ///< Liczba rodzajów poleceń.
+} Command;
+
+/** Nazwy poleceń. */
+static char const * const commandNames[COMMANDS] = {
+   "NEW", "ADD", "DEL", "GET", "REV", "GETREV"
+};
+
+/** Liczby słów poleceń (razem z nazwą polecenia). */
+static int const commandWords[COMMANDS] = {2, 3, 2, 2, 2, 2};
+
+/** @struct Input
+ * To jest struktura opisująca wejście czytane dużymi blokami. Wiersze są
+ * udostępniane wprost z bufora, bez kopiowania.
+ */
+typedef struct Input {
+   FILE *file;   ///< Plik wejściowy.
+   char *buffer; ///< Bufor.
+   size_t size;  ///< Rozmiar bufora.
+   size_t begin; ///< Początek nieprzeczytanej części bufora.
+   size_t end;   ///< Koniec wczytanej części bufora.
+   bool eof;     ///< Czy wczytano już cały plik.
+} Input;
+
+/** @struct Output
+ * To jest struktura opisująca buforowane wyjście.
+ */
+typedef struct Output {
+   char *buffer;  ///< Bufor.
+   size_t length; ///< Liczba znaków czekających na zapis.
+} Output;
+
+/** @struct Instance
+ * To jest struktura opisująca nazwaną strukturę przechowującą przekierowania.
+ */
+typedef struct Instance {
+   char *name;       ///< Nazwa struktury.
+   PhoneForward *pf; ///< Struktura przechowująca przekierowania.
+} Instance;
+
+/** @struct Program
+ * To jest struktura opisująca stan programu.
+ */
+typedef struct Program {
+   Input input;            ///< Wejście.
+   Output output;          ///< Wyjście.
+   Instance *instances;    ///< Utworzone struktury.
+   size_t count;           ///< Liczba utworzonych struktur.
+   size_t size;            ///< Rozmiar tablicy @p instances.
+   PhoneForward *current;  ///< Bieżąca struktura (NULL - brak).
+   bool stats;             ///< Czy wypisać statystyki.
+   uint64_t executed[COMMANDS]; ///< Liczby wykonanych poleceń.
+   double seconds[COMMANDS];    ///< Łączne czasy wykonania poleceń.
+} Program;
+
+/** @brief Wypisuje sposób użycia programu i kończy jego działanie.
+ * @param[in] name - nazwa programu.
+ */
+static void exitWithUsage(char const *name) {
+   fprintf(stderr, "Usage: %s [--stats] [file]\n", name);
+   exit(1);
+}
+
+/** @brief Odczytuje bieżący czas.
+ * @return Liczba sekund od ustalonej chwili w przeszłości.
+ */
+static double now(void) {
+   struct timespec time;
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return (double)(time.tv_sec) + (double)(time.tv_nsec) * 1e-9;
+}
+
+/** @brief Zapisuje zawartość bufora wyjścia.
+ * @param[in,out] output - wskaźnik na wyjście.
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool flushOutput(Output *output) {
+   size_t const written = fwrite(output->buffer, 1, output->length, stdout);
+   bool const success = (written == output->length);
+   output->length = 0;
+   return success;
+}
+
+/** @brief Zwalnia pamięć programu.
+ * Zapisuje wcześniej zawartość bufora wyjścia.
+ * @param[in,out] program - wskaźnik na stan programu.
+ * @return Wartość @p true, jeśli zapis wyjścia się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool freeProgram(Program *program) {
+   bool const success = (program->output.buffer == NULL
+                         || (flushOutput(&(program->output)) && fflush(stdout) == 0));
+   for (size_t i = 0; i < program->count; i++) {
+      free((program->instances)[i].name);
+      phfwdDelete((program->instances)[i].pf);
+   }
+   free(program->instances);
+   free(program->input.buffer);
+   free(program->output.buffer);
+   if (program->input.file != NULL && program->input.file != stdin)
+      fclose(program->input.file);
+   return success;
+}
+
+/** @brief Kończy działanie programu z błędem.
+ * Wypisuje wyniki poprzednich poleceń, zwalnia pamięć i wypisuje komunikat
+ * o błędzie.
+ * @param[in,out] program - wskaźnik na stan programu.
+ * @param[in] line        - numer wiersza błędnego polecenia lub 0 dla braku
+ *                          pamięci.
+ */
+static void exitWithError(Program *program, size_t const line) {
+   freeProgram(program);
+   if (line == 0)
+      fprintf(stderr, "ERROR MEMORY\n");
+   else
+      fprintf(stderr, "ERROR %zu\n", line);
+   exit(1);
+}
+
+/** @brief Wczytuje kolejny wiersz.
+ * Zamienia znak końca wiersza na '\0'. Niedokończony wiersz z końca bufora
+ * jest przesuwany na jego początek przed wczytaniem kolejnego bloku, a bufor
+ * jest powiększany tylko wtedy, gdy nie mieści jednego wiersza.
+ * @param[in,out] program - wskaźnik na stan programu.
+ * @return Wskaźnik na początek wiersza w buforze lub NULL, jeśli wejście
+ *         się skończyło.
+ */
+static char * nextLine(Program *program) {
+   Input *input = &(program->input);
+   while (true) {
+      char *line = input->buffer + input->begin;
+      char *newline = memchr(line, '\n', input->end - input->begin);
+      if (newline != NULL) {
+         *newline = '\0';
+         input->begin = (size_t)(newline - input->buffer) + 1;
+         return line;
+      }
+      if (input->eof) {
+         if (input->begin == input->end)
+            return NULL;
+         input->buffer[input->end] = '\0';
+         input->begin = input->end;
+         return line;
+      }
+
+      size_t const rest = input->end - input->begin;
+      memmove(input->buffer, line, rest);
+      input->begin = 0;
+      input->end = rest;
+      // Jeden bajt bufora jest zarezerwowany na '\0' po ostatnim wierszu.
+      if (input->end + 1 == input->size) {
+         char *buffer = realloc(input->buffer, 2 * input->size);
+         if (buffer == NULL)
+            exitWithError(program, 0);
+         input->buffer = buffer;
+         input->size *= 2;
+      }
+
+      size_t const read = fread(input->buffer + input->end, 1,
+                                input->size - input->end - 1, input->file);
+      input->end += read;
+      if (read == 0)
+         input->eof = true;
+   }
+}
+
+/** @brief Dzieli wiersz na słowa.
+ * Zamienia białe znaki kończące słowa na '\0'.
+ * @param[in,out] line - wskaźnik na wiersz.
+ * @param[out] words   - tablica na wskaźniki na słowa.
+ * @return Liczba słów lub @ref MAX_WORDS + 1, jeśli słów jest więcej niż
+ *         @ref MAX_WORDS.
+ */
+static int splitWords(char *line, char *words[MAX_WORDS]) {
+   int count = 0;
+   while (true) {
+      while (*line == ' ' || *line == '\t' || *line == '\r')
+         line++;
+      if (*line == '\0')
+         return count;
+      if (count == MAX_WORDS)
+         return MAX_WORDS + 1;
+
+      words[count++] = line;
+      while (*line != '\0' && *line != ' ' && *line != '\t' && *line != '\r')
+         line++;
+      if (*line != '\0')
+         *(line++) = '\0';
+   }
+}
+
+/** @brief Sprawdza, czy napis jest numerem.
+ * @param[in] word - wskaźnik na napis.
+ * @return Wartość @p true, jeśli napis jest niepustym ciągiem cyfr
+ *         i znaków * oraz #. Wartość @p false w przeciwnym przypadku.
+ */
+static bool isNumber(char const *word) {
+   if (*word == '\0')
+      return false;
+   for (; *word != '\0'; word++) {
+      if ((*word < '0' || *word > '9') && *word != '*' && *word != '#')
+         return false;
+   }
+   return true;
+}
+
+/** @brief Sprawdza, czy napis jest nazwą struktury.
+ * @param[in] word - wskaźnik na napis.
+ * @return Wartość @p true, jeśli napis zaczyna się od litery i składa się
+ *         z liter i cyfr. Wartość @p false w przeciwnym przypadku.
+ */
+static bool isName(char const *word) {
+   bool const letter = ((*word >= 'a' && *word <= 'z') || (*word >= 'A' && *word <= 'Z'));
+   if (!letter)
+      return false;
+   for (; *word != '\0'; word++) {
+      if (!((*word >= 'a' && *word <= 'z') || (*word >= 'A' && *word <= 'Z')
+            || (*word >= '0' && *word <= '9')))
+         return false;
+   }
+   return true;
+}
+
+/** @brief Wyszukuje strukturę o podanej nazwie.
+ * @param[in] program - wskaźnik na stan programu.
+ * @param[in] name    - wskaźnik na nazwę.
+ * @return Indeks struktury lub liczba struktur, jeśli takiej nie ma.
+ */
+static size_t findInstance(Program const *program, char const *name) {
+   size_t i = 0;
+   while (i < program->count && strcmp((program->instances)[i].name, name) != 0)
+      i++;
+   return i;
+}
+
+/** @brief Wykonuje polecenie NEW.
+ * @param[in,out] program - wskaźnik na stan programu.
+ * @param[in] name        - wskaźnik na nazwę struktury.
+ */
+static void newInstance(Program *program, char const *name) {
+   size_t const i = findInstance(program, name);
+   if (i < program->count) {
+      program->current = (program->instances)[i].pf;
+      return;
+   }
+
+   if (program->count == program->size) {
+      size_t const size = (program->size == 0 ? 4 : 2 * program->size);
+      Instance *instances = realloc(program->instances, size * sizeof(Instance));
+      if (instances == NULL)
+         exitWithError(program, 0);
+      program->instances = instances;
+      program->size = size;
+   }
+
+   size_t const length = strlen(name);
+   Instance instance = {malloc(length + 1), phfwdNew()};
+   if (instance.name == NULL || instance.pf == NULL) {
+      free(instance.name);
+      phfwdDelete(instance.pf);
+      exitWithError(program, 0);
+   }
+   memcpy(instance.name, name, length + 1);
+   (program->instances)[(program->count)++] = instance;
+   program->current = instance.pf;
+}
+
+/** @brief Usuwa strukturę o podanej nazwie.
+ * @param[in,out] program - wskaźnik na stan programu.
+ * @param[in] name        - wskaźnik na nazwę struktury.
+ * @return Wartość @p true, jeśli struktura została usunięta.
+ *         Wartość @p false, jeśli takiej struktury nie ma.
+ */
+static bool deleteInstance(Program *program, char const *name) {
+   size_t const i = findInstance(program, name);
+   if (i == program->count)
+      return false;
+
+   Instance const instance = (program->instances)[i];
+   if (program->current == instance.pf)
+      program->current = NULL;
+   free(instance.name);
+   phfwdDelete(instance.pf);
+   (program->instances)[i] = (program->instances)[--(program->count)];
+   return true;
+}
+
+/** @brief Dopisuje numer do bufora wyjścia.
+ * Dopisuje numer zakończony znakiem końca wiersza. Bufor jest zapisywany,
+ * gdy się zapełni.
+ * @param[in,out] program - wskaźnik na stan programu.
+ * @param[in] number      - wskaźnik na numer.
+ */
+static void writeNumber(Program *program, char const *number) {
+   Output *output = &(program->output);
+   size_t const length = strlen(number);
+   if (output->length + length + 1 > OUTPUT_BLOCK) {
+      if (!flushOutput(output))
+         exitWithError(program, 0);
+      // Numer dłuższy niż bufor jest zapisywany bezpośrednio.
+      if (length + 1 > OUTPUT_BLOCK) {
+         if (fwrite(number, 1, length, stdout) != length || putchar('\n') == EOF)
+            exitWithError(program, 0);
+         return;
+      }
+   }
+   memcpy(output->buffer + output->length, number, length);
+   output->length += length;
+   (output->buffer)[(output->length)++] = '\n';
+}
+
+/** @brief Dopisuje numery do bufora wyjścia i zwalnia je.
+ * @param[in,out] program - wskaźnik na stan programu.
+ * @param[in] pnum        - wskaźnik na numery lub NULL, jeśli nie udało się
+ *                          ich wyznaczyć.
+ */
+static void writeNumbers(Program *program, PhoneNumbers *pnum) {
+   if (pnum == NULL)
+      exitWithError(program, 0);
+   char const *number;
+   for (size_t i = 0; (number = phnumGet(pnum, i)) != NULL; i++)
+      writeNumber(program, number);
+   phnumDelete(pnum);
+}
+
+/** @brief Wykonuje polecenie.
+ * @param[in,out] program - wskaźnik na stan programu.
+ * @param[in] command     - rodzaj polecenia.
+ * @param[in] words       - słowa polecenia.
+ * @return Wartość @p true, jeśli polecenie jest poprawne.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool execute(Program *program, Command const command, char * const *words) {
+   if (command == COMMAND_NEW)
+      return isName(words[1]) && (newInstance(program, words[1]), true);
+   if (command == COMMAND_DEL && isName(words[1]))
+      return deleteInstance(program, words[1]);
+
+   PhoneForward *pf = program->current;
+   if (pf == NULL || !isNumber(words[1]))
+      return false;
+   switch (command) {
+      case COMMAND_ADD:
+         // Dodanie może się nie udać tylko dla równych numerów lub przy braku pamięci.
+         if (!isNumber(words[2]) || strcmp(words[1], words[2]) == 0)
+            return false;
+         if (!phfwdAdd(pf, words[1], words[2]))
+            exitWithError(program, 0);
+         return true;
+      case COMMAND_DEL:
+         phfwdRemove(pf, words[1]);
+         return true;
+      case COMMAND_GET:
+         writeNumbers(program, phfwdGet(pf, words[1]));
+         return true;
+      case COMMAND_REV:
+         writeNumbers(program, phfwdReverse(pf, words[1]));
+         return true;
+      case COMMAND_GETREV:
+         writeNumbers(program, phfwdGetReverse(pf, words[1]));
+         return true;
+      default:
+         return false;
+   }
+}
+
+/** @brief Wykonuje polecenia z wejścia.
+ * @param[in,out] program - wskaźnik na stan programu.
+ */
+static void run(Program *program) {
+   char *line;
+   size_t lineNumber = 0;
+   while ((line = nextLine(program)) != NULL) {
+      lineNumber++;
+      char *words[MAX_WORDS];
+      int const count = splitWords(line, words);
+      if (count == 0)
+         continue;
+
+      Command command = 0;
+      while (command < COMMANDS && strcmp(words[0], commandNames[command]) != 0)
+         command++;
+      if (command == COMMANDS || count != commandWords[command])
+         exitWithError(program, lineNumber);
+
+      double const start = (program->stats ? now() : 0);
+      if (!execute(program, command, words))
+         exitWithError(program, lineNumber);
+      if (program->stats) {
+         (program->executed)[command]++;
+         (program->seconds)[command] += now() - start;
+      }
+   }
+}
+
+/** @brief Wyznacza szybkość wykonania poleceń.
+ * @param[in] count   - liczba wykonanych poleceń.
+ * @param[in] seconds - łączny czas ich wykonania w sekundach.
+ * @return Liczba poleceń na sekundę lub 0, jeśli zmierzony czas jest zerowy
+ *         (zbyt krótki dla zegara).
+ */
+static double rate(uint64_t const count, double const seconds) {
+   return (seconds > 0 ? (double)count / seconds : 0);
+}
+
+/** @brief Wypisuje liczbę i szybkość wykonania poleceń każdego rodzaju.
+ * @param[in] program - wskaźnik na stan programu.
+ * @param[in] total   - czas działania programu w sekundach.
+ */
+static void printStats(Program const *program, double const total) {
+   uint64_t executed = 0;
+   for (int i = 0; i < COMMANDS; i++) {
+      executed += (program->executed)[i];
+      if ((program->executed)[i] == 0)
+         continue;
+      fprintf(stderr, "%-6s %12llu ops %10.6f s %14.0f ops/s\n", commandNames[i],
+              (unsigned long long)((program->executed)[i]), (program->seconds)[i],
+              rate((program->executed)[i], (program->seconds)[i]));
+   }
+   // Łączny czas obejmuje także czytanie wejścia i zapis wyjścia.
+   fprintf(stderr, "%-6s %12llu ops %10.6f s %14.0f ops/s\n", "TOTAL",
+           (unsigned long long)executed, total, rate(executed, total));
+}
+
+int main(int argc, char *argv[]) {
+   Program program;
+   memset(&program, 0, sizeof(Program));
+   char const *path = NULL;
+   for (int i = 1; i < argc; i++) {
+      if (strcmp(argv[i], "--stats") == 0)
+         program.stats = true;
+      else if (path == NULL && argv[i][0] != '-')
+         path = argv[i];
+      else
+         exitWithUsage(argv[0]);
+   }
+
+   program.input.file = (path != NULL ? fopen(path, "r") : stdin);
+   if (program.input.file == NULL) {
+      fprintf(stderr, "ERROR cannot open %s\n", path);
+      return 1;
+   }
+   program.input.buffer = malloc(INPUT_BLOCK);
+   program.input.size = INPUT_BLOCK;
+   program.output.buffer = malloc(OUTPUT_BLOCK);
+   if (program.input.buffer == NULL || program.output.buffer == NULL)
+      exitWithError(&program, 0);
+
+   double const start = now();
+   run(&program);
+   if (!flushOutput(&(program.output)) || fflush(stdout) != 0)
+      exitWithError(&program, 0);
+   if (program.stats)
+      printStats(&program, now() - start);
+
+   return freeProgram(&program) ? 0 : 1;
+}
@@ -0,0 +1,238 @@
+/** @file
+ * Implementacja zwalniania po kawałku dużych poddrzew usuniętych
+ * przez @ref phfwdRemove.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "phone_forward.h"
+#include "trie.h"
+#include "reclaim.h"
+
+bool isSmall(PhoneForward *pf, Node const *subtree, size_t const limit) {
+   Node const **stack = (Node const **)(pf->stack);
+   size_t top = 0;
+   size_t count = 0;
+   stack[0] = subtree;
+   int startingSubtreeID = 0;
+
+   while (true) {
+      Node const *node = stack[top];
+      if (startingSubtreeID == 0 && ++count > limit)
+         return false;
+
+      int const subtreeID = nextChild(node, startingSubtreeID);
+      if (subtreeID < NUMBER_OF_SYMBOLS) {
+         stack[++top] = getChild(node, subtreeID);
+         startingSubtreeID = 0;
+      }
+      else if (top == 0) {
+         return true;
+      }
+      else {
+         startingSubtreeID = digitID(node->digit) + 1;
+         top--;
+      }
+   }
+}
+
+bool deferSubtree(PhoneForward *pf, Node *node, char const *number,
+                  size_t const length) {
+   Reclaimer *reclaimer = &(pf->reclaimer);
+   char *copy = NULL;
+   if (number != NULL) {
+      copy = malloc(length);
+      if (copy == NULL)
+         return false;
+      memcpy(copy, number, length);
+   }
+   if (!reserveArray((void**)&(reclaimer->pending), &(reclaimer->size),
+                     reclaimer->count + 1, sizeof(Pending))) {
+      free(copy);
+      return false;
+   }
+
+   (reclaimer->pending)[(reclaimer->count)++] = (Pending){node, copy, length};
+   if (copy != NULL) {
+      (reclaimer->erasing)++;
+      pf->writing->erasing = true;
+   }
+   return true;
+}
+
+/** @brief Zaczyna przeglądanie kolejnego odłożonego poddrzewa.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania.
+ * @return Wartość @p true, jeśli rozpoczęto przeglądanie.
+ *         Wartość @p false, jeśli nie ma odłożonych poddrzew lub nie udało
+ *         się alokować pamięci.
+ */
+static bool startWalk(PhoneForward *pf) {
+   Reclaimer *reclaimer = &(pf->reclaimer);
+   if (reclaimer->count == 0)
+      return false;
+
+   // Poddrzewo drzewa przekierowań nie jest głębsze niż najdłuższy numer.
+   size_t const capacity = pf->maxSourceLength + 1;
+   if (capacity > reclaimer->capacity) {
+      Node **stack = realloc(reclaimer->stack, capacity * sizeof(Node*));
+      if (stack == NULL)
+         return false;
+      reclaimer->stack = stack;
+      char *path = realloc(reclaimer->path, capacity);
+      if (path == NULL)
+         return false;
+      reclaimer->path = path;
+      reclaimer->capacity = capacity;
+   }
+
+   Pending const current = (reclaimer->pending)[--(reclaimer->count)];
+   if (current.number != NULL)
+      memcpy(reclaimer->path, current.number, current.length);
+   reclaimer->current = current;
+   (reclaimer->stack)[0] = current.node;
+   reclaimer->top = 0;
+   reclaimer->next = 0;
+   reclaimer->release = (!copiesPaths(pf) || current.number == NULL);
+   return true;
+}
+
+/** @brief Usuwa z indeksu odwrotnego parę usuniętego przekierowania.
+ * Para zostaje, jeśli to samo przekierowanie zostało od tego czasu dodane
+ * ponownie.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] forward - wskaźnik na numer docelowy.
+ * @param[in] source  - wskaźnik na numer przekierowywany.
+ * @param[in] length  - długość numeru przekierowywanego.
+ */
+static void eraseRemoved(PhoneForward *pf, Target const *forward, char const *source,
+                         size_t const length) {
+   Node const *node = findPath(pf->writing->node, source, length);
+   if (node == NULL || node->forward != forward)
+      reverseEraseForward(pf, forward, source, length);
+}
+
+void reclaimPending(PhoneForward *pf, size_t budget) {
+   Reclaimer *reclaimer = &(pf->reclaimer);
+   while (budget > 0) {
+      if (reclaimer->current.node == NULL && !startWalk(pf))
+         return;
+
+      Pending *current = &(reclaimer->current);
+      bool const erase = (current->number != NULL);
+      bool const release = reclaimer->release;
+      Node *node = (reclaimer->stack)[reclaimer->top];
+      size_t const depth = current->length + reclaimer->top;
+      if (reclaimer->next == 0) {
+         budget--;
+         if (release && reclaimer->top == 0 && releaseShared(pf, node)) {
+            current->node = NULL;
+            continue;
+         }
+         if (erase && node->forward != NULL) {
+            eraseRemoved(pf, node->forward, reclaimer->path, depth);
+            countForward(pf, depth, false);
+         }
+      }
+
+      int const subtreeID = nextChild(node, reclaimer->next);
+      if (subtreeID < NUMBER_OF_SYMBOLS) {
+         Node *child = getChild(node, subtreeID);
+         if (release && releaseShared(pf, child)) {
+            reclaimer->next = subtreeID + 1;
+            continue;
+         }
+         (reclaimer->stack)[++(reclaimer->top)] = child;
+         if (erase)
+            (reclaimer->path)[depth] = child->digit;
+         reclaimer->next = 0;
+         continue;
+      }
+
+      int const id = digitID(node->digit);
+      if (release) {
+         internRelease(pf->targets, node->forward);
+         freeNode(pf, node, nonEmptySubtrees(node));
+      }
+      if (reclaimer->top > 0) {
+         (reclaimer->top)--;
+         reclaimer->next = id + 1;
+         continue;
+      }
+
+      // Poddrzewo jest przejrzane. Jeśli nie uda się zarezerwować miejsca na
+      // jego odłożenie, przeglądanie wróci do tego miejsca w kolejnej zmianie.
+      if (!release && !reserveRetired(pf, 1)) {
+         reclaimer->next = NUMBER_OF_SYMBOLS;
+         return;
+      }
+      if (erase) {
+         free(current->number);
+         if (--(reclaimer->erasing) == 0)
+            pf->writing->erasing = false;
+      }
+      current->node = NULL;
+      if (release)
+         continue;
+      if (pf->concurrent)
+         retire(pf, node, RETIRED_SUBTREE);
+      else if (!deferSubtree(pf, node, NULL, 0))
+         deleteNode(pf, node, pf->stack);
+   }
+}
+
+bool isReclaiming(PhoneForward const *pf) {
+   return pf->reclaimer.count > 0 || pf->reclaimer.current.node != NULL;
+}
+
+void reclaimAll(PhoneForward *pf) {
+   Reclaimer *reclaimer = &(pf->reclaimer);
+
+   // Indeks odwrotny jest zwalniany, więc pary odłożonych poddrzew nie
+   // muszą być z niego usuwane. Przerwane usuwanie par zaczynamy od nowa
+   // jako zwalnianie - nie zwolniło jeszcze żadnego wierzchołka.
+   if (reclaimer->current.node != NULL && !(reclaimer->release)) {
+      free(reclaimer->current.number);
+      reclaimer->current.number = NULL;
+      reclaimer->current.length = 0;
+      reclaimer->top = 0;
+      reclaimer->next = 0;
+      reclaimer->release = true;
+   }
+   for (size_t i = 0; i < reclaimer->count; i++) {
+      free((reclaimer->pending)[i].number);
+      (reclaimer->pending)[i].number = NULL;
+   }
+   reclaimer->erasing = 0;
+   reclaimPending(pf, SIZE_MAX);
+   while (reclaimer->count > 0)
+      deleteNode(pf, (reclaimer->pending)[--(reclaimer->count)].node, pf->stack);
+}
+
+void reclaimerDelete(Reclaimer *reclaimer) {
+   for (size_t i = 0; i < reclaimer->count; i++)
+      free((reclaimer->pending)[i].number);
+   if (reclaimer->current.node != NULL)
+      free(reclaimer->current.number);
+   free(reclaimer->pending);
+   free(reclaimer->stack);
+   free(reclaimer->path);
+}
+
+bool phfwdReclaim(PhoneForward *pf, size_t const limit) {
+   if (pf == NULL)
+      return false;
+   if (pf->frozen != NULL)
+      return true;
+
+   if (!beginChange(pf))
+      return false;
+   reclaimPending(pf, limit);
+   bool const done = !isReclaiming(pf);
+   endChange(pf);
+   return done;
+}
+
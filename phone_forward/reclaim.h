@@ -0,0 +1,85 @@
+/** @file
+ * Interfejs zwalniania po kawałku dużych poddrzew usuniętych przez
+ * @ref phfwdRemove. Usunięte poddrzewo jest odkładane, a kolejne zmiany
+ * przeglądają je po kilka wierzchołków, usuwając jego pary z indeksu
+ * odwrotnego i zwalniając wierzchołki.
+ * Nie jest częścią interfejsu klasy przechowującej przekierowania.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#ifndef __RECLAIM_H__
+#define __RECLAIM_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "trie.h"
+
+/** Liczba wierzchołków usuniętych poddrzew przeglądanych przy każdej zmianie.
+ * Poddrzewa większe niż ta liczba nie są zwalniane od razu przy usuwaniu,
+ * tylko odkładane i zwalniane po kawałku przy kolejnych zmianach.
+ */
+#define RECLAIM_STEP 16
+
+/** @brief Sprawdza, czy poddrzewo jest małe.
+ * Przegląda najwyżej @p limit + 1 wierzchołków.
+ * @param[in,out] pf  – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] subtree – wskaźnik na korzeń poddrzewa.
+ * @param[in] limit   – największa liczba wierzchołków małego poddrzewa.
+ * @return Wartość @p true, jeśli poddrzewo ma co najwyżej @p limit wierzchołków.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool isSmall(PhoneForward *pf, Node const *subtree, size_t limit);
+
+/** @brief Odkłada usunięte poddrzewo do zwolnienia.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] node   – wskaźnik na korzeń poddrzewa.
+ * @param[in] number – wskaźnik na numer odpowiadający korzeniowi lub NULL,
+ *                     jeśli pary poddrzewa są już usunięte z indeksu
+ *                     odwrotnego.
+ * @param[in] length – długość numeru.
+ * @return Wartość @p true, jeśli poddrzewo zostało odłożone.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+bool deferSubtree(PhoneForward *pf, Node *node, char const *number,
+                  size_t length);
+
+/** @brief Zwalnia część odłożonych poddrzew.
+ * Poddrzewa są przeglądane w głąb. Przy pierwszym odwiedzeniu wierzchołka
+ * para jego przekierowania jest usuwana z indeksu odwrotnego, a po
+ * przejrzeniu synów wierzchołek jest zwalniany. W trybie współbieżnym
+ * poddrzewo może być jeszcze czytane przez inne wątki, więc po usunięciu
+ * par jest odkładane do zwolnienia w całości, a gdy nie może go już czytać
+ * żaden wątek, jest ponownie przeglądane i zwalniane. Tak samo jest
+ * przeglądane poddrzewo struktury z klonami - pary trzeba usunąć także
+ * z jego współdzielonych części, a zwalniane jest tylko to, czego nie
+ * współdzieli z klonami.
+ * Musi być wywołana w trakcie zmiany.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] budget – największa liczba przeglądanych wierzchołków.
+ */
+void reclaimPending(PhoneForward *pf, size_t budget);
+
+/** @brief Sprawdza, czy są odłożone poddrzewa.
+ * @param[in] pf – wskaźnik na strukturę przechowującą przekierowania.
+ * @return Wartość @p true, jeśli jakieś poddrzewo czeka na przeglądanie.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool isReclaiming(PhoneForward const *pf);
+
+/** @brief Zwalnia wszystkie odłożone poddrzewa.
+ * Pary odłożonych poddrzew nie są usuwane z indeksu odwrotnego - wywołujący
+ * zwalnia cały indeks. Musi być wywołana w trakcie zmiany.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania.
+ */
+void reclaimAll(PhoneForward *pf);
+
+/** @brief Zwalnia pamięć pomocniczą zwalniania poddrzew.
+ * Nie zwalnia samych odłożonych poddrzew.
+ * @param[in,out] reclaimer – wskaźnik na stan zwalniania poddrzew.
+ */
+void reclaimerDelete(Reclaimer *reclaimer);
+
+#endif /* __RECLAIM_H__ */
@@ -0,0 +1,160 @@
+/** @file
+ * Implementacja tablicy liczników referencji współdzielonych obiektów.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "share.h"
+
+/** Początkowa liczba miejsc w tablicy (potęga dwójki). */
+#define INITIAL_CAPACITY 64
+
+/** Tablica jest powiększana, gdy zajętych jest więcej niż połowa miejsc. */
+#define MAX_LOAD_NUMERATOR 1
+/** Mianownik maksymalnego wypełnienia tablicy. */
+#define MAX_LOAD_DENOMINATOR 2
+
+/** Mnożnik skrótu adresu - część ułamkowa złotego podziału razy 2^64. */
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+/** @struct ShareSlot
+ * To jest struktura miejsca w tablicy.
+ */
+typedef struct ShareSlot {
+   void const *object; ///< Wskaźnik na obiekt (NULL - wolne miejsce).
+   size_t count;       ///< Liczba referencji obiektu.
+} ShareSlot;
+
+struct ShareTable {
+   ShareSlot *slots; ///< Miejsca tablicy (adresowanie otwarte).
+   size_t capacity;  ///< Liczba miejsc.
+   size_t count;     ///< Liczba przechowywanych obiektów.
+};
+
+/** @brief Wyznacza skrót adresu obiektu.
+ * Adresy są wyrównane, więc ich najmłodsze bity są stałe - starsze bity
+ * iloczynu są mieszane z młodszymi.
+ * @param[in] object - wskaźnik na obiekt.
+ * @return Skrót adresu.
+ */
+static inline size_t hashObject(void const *object) {
+   uint64_t const hash = (uint64_t)(uintptr_t)object * HASH_MULTIPLIER;
+   return (size_t)(hash ^ (hash >> 32));
+}
+
+/** @brief Wyszukuje miejsce obiektu.
+ * @param[in] table  - wskaźnik na tablicę.
+ * @param[in] object - wskaźnik na obiekt.
+ * @return Indeks miejsca zajętego przez obiekt lub wolnego miejsca, na
+ *         którym zakończyło się wyszukiwanie.
+ */
+static size_t findSlot(ShareTable const *table, void const *object) {
+   size_t const mask = table->capacity - 1;
+   size_t index = hashObject(object) & mask;
+   while ((table->slots)[index].object != NULL && (table->slots)[index].object != object)
+      index = (index + 1) & mask;
+   return index;
+}
+
+/** @brief Dwukrotnie powiększa tablicę.
+ * @param[in,out] table - wskaźnik na tablicę.
+ * @return Wartość @p true, jeśli tablica została powiększona.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool grow(ShareTable *table) {
+   ShareTable bigger = {calloc(2 * table->capacity, sizeof(ShareSlot)),
+                        2 * table->capacity, table->count};
+   if (bigger.slots == NULL)
+      return false;
+
+   for (size_t i = 0; i < table->capacity; i++) {
+      if ((table->slots)[i].object != NULL)
+         (bigger.slots)[findSlot(&bigger, (table->slots)[i].object)] = (table->slots)[i];
+   }
+   free(table->slots);
+   *table = bigger;
+   return true;
+}
+
+ShareTable * shareNew(void) {
+   ShareTable *table = malloc(sizeof(ShareTable));
+   if (table == NULL)
+      return NULL;
+
+   table->capacity = INITIAL_CAPACITY;
+   table->count = 0;
+   table->slots = calloc(table->capacity, sizeof(ShareSlot));
+   if (table->slots == NULL) {
+      free(table);
+      return NULL;
+   }
+   return table;
+}
+
+void shareDelete(ShareTable *table) {
+   if (table == NULL)
+      return;
+
+   free(table->slots);
+   free(table);
+}
+
+size_t shareCount(ShareTable const *table, void const *object) {
+   ShareSlot const *slot = &((table->slots)[findSlot(table, object)]);
+   return (slot->object != NULL ? slot->count : 1);
+}
+
+bool shareAcquire(ShareTable *table, void const *object) {
+   size_t index = findSlot(table, object);
+   if ((table->slots)[index].object != NULL) {
+      ((table->slots)[index].count)++;
+      return true;
+   }
+
+   if ((table->count + 1) * MAX_LOAD_DENOMINATOR > table->capacity * MAX_LOAD_NUMERATOR) {
+      if (!grow(table))
+         return false;
+      index = findSlot(table, object);
+   }
+   (table->slots)[index] = (ShareSlot){object, 2};
+   (table->count)++;
+   return true;
+}
+
+bool shareRelease(ShareTable *table, void const *object) {
+   size_t index = findSlot(table, object);
+   if ((table->slots)[index].object == NULL)
+      return false;
+   if (--((table->slots)[index].count) > 1)
+      return true;
+
+   // Usunięcie z przesunięciem wstecz - elementy, które przy wstawianiu
+   // ominęły zwolnione miejsce, są do niego przesuwane.
+   size_t const mask = table->capacity - 1;
+   size_t hole = index;
+   index = (index + 1) & mask;
+   while ((table->slots)[index].object != NULL) {
+      size_t const home = hashObject((table->slots)[index].object) & mask;
+      if (((index - home) & mask) >= ((index - hole) & mask)) {
+         (table->slots)[hole] = (table->slots)[index];
+         hole = index;
+      }
+      index = (index + 1) & mask;
+   }
+   (table->slots)[hole].object = NULL;
+   (table->count)--;
+   return true;
+}
+
+size_t shareEntries(ShareTable const *table) {
+   return table->count;
+}
+
+size_t shareBytes(ShareTable const *table) {
+   return sizeof(ShareTable) + table->capacity * sizeof(ShareSlot);
+}
@@ -0,0 +1,77 @@
+/** @file
+ * Interfejs tablicy liczników referencji współdzielonych obiektów.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#ifndef __SHARE_H__
+#define __SHARE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @struct ShareTable
+ * To jest struktura tablicy haszującej przechowującej liczniki referencji
+ * obiektów. Tablica przechowuje tylko liczniki większe niż 1 - obiekt,
+ * którego w niej nie ma, ma dokładnie jedną referencję. Dzięki temu
+ * obiekty, które nie są współdzielone, nie zajmują w niej miejsca.
+ */
+struct ShareTable;
+/** @typedef ShareTable
+ * Definicja structury ShareTable.
+ */
+typedef struct ShareTable ShareTable;
+
+/** @brief Tworzy nową tablicę.
+ * @return Wskaźnik na utworzoną tablicę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+ShareTable * shareNew(void);
+
+/** @brief Usuwa tablicę.
+ * Nic nie robi, jeśli wskaźnik @p table ma wartość NULL.
+ * @param[in] table – wskaźnik na usuwaną tablicę.
+ */
+void shareDelete(ShareTable *table);
+
+/** @brief Zwraca liczbę referencji obiektu.
+ * @param[in] table  – wskaźnik na tablicę;
+ * @param[in] object – wskaźnik na obiekt.
+ * @return Liczba referencji obiektu (1, jeśli obiektu nie ma w tablicy).
+ */
+size_t shareCount(ShareTable const *table, void const *object);
+
+/** @brief Dodaje referencję obiektu.
+ * @param[in,out] table – wskaźnik na tablicę;
+ * @param[in] object    – wskaźnik na obiekt.
+ * @return Wartość @p true, jeśli referencja została dodana.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci (licznik
+ *         nie jest wtedy zmieniany).
+ */
+bool shareAcquire(ShareTable *table, void const *object);
+
+/** @brief Usuwa referencję obiektu, jeśli nie jest ostatnia.
+ * @param[in,out] table – wskaźnik na tablicę;
+ * @param[in] object    – wskaźnik na obiekt.
+ * @return Wartość @p true, jeśli obiekt miał więcej niż jedną referencję
+ *         i jedna została usunięta.
+ *         Wartość @p false, jeśli była to ostatnia referencja - tablica nie
+ *         jest wtedy zmieniana, a obiekt może zostać zwolniony.
+ */
+bool shareRelease(ShareTable *table, void const *object);
+
+/** @brief Zwraca liczbę współdzielonych obiektów.
+ * @param[in] table – wskaźnik na tablicę.
+ * @return Liczba obiektów, które mają więcej niż jedną referencję.
+ */
+size_t shareEntries(ShareTable const *table);
+
+/** @brief Wyznacza rozmiar tablicy.
+ * @param[in] table – wskaźnik na tablicę.
+ * @return Liczba bajtów zajmowanych przez tablicę.
+ */
+size_t shareBytes(ShareTable const *table);
+
+#endif /* __SHARE_H__ */
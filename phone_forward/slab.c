@@ -0,0 +1,149 @@
+/** @file
+ * Implementacja alokatora pamięci dla struktur przechowujących przekierowania.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#include <stdlib.h>
+#include "slab.h"
+
+/** Rozmiar płatu pamięci w bajtach. */
+#define SLAB_SIZE (64 * 1024)
+
+/** Wyrównanie przydzielanych bloków.
+ * Rozmiary bloków są zaokrąglane w górę do jego wielokrotności.
+ */
+#define ALIGNMENT 8
+
+/** Największy rozmiar bloku przydzielanego z płatów.
+ * Mieści się w nim wierzchołek drzewa z kompletem synów.
+ */
+#define MAX_SMALL_SIZE 256
+
+/** Liczba klas rozmiaru małych bloków. */
+#define NUMBER_OF_CLASSES (MAX_SMALL_SIZE / ALIGNMENT + 1)
+
+/** @struct FreeBlock
+ * To jest struktura zapisywana na początku wolnego małego bloku.
+ */
+typedef struct FreeBlock {
+   struct FreeBlock *next; ///< Następny wolny blok tej samej klasy.
+} FreeBlock;
+
+/** @struct Slab
+ * To jest nagłówek płatu pamięci. Za nim znajdują się przydzielane bloki.
+ */
+typedef struct Slab {
+   struct Slab *next; ///< Następny płat.
+} Slab;
+
+/** @struct LargeBlock
+ * To jest nagłówek dużego bloku. Duże bloki tworzą listę dwukierunkową,
+ * żeby można je było zwalniać pojedynczo w czasie stałym.
+ */
+typedef struct LargeBlock {
+   struct LargeBlock *previous; ///< Poprzedni duży blok.
+   struct LargeBlock *next;     ///< Następny duży blok.
+} LargeBlock;
+
+struct SlabAllocator {
+   Slab *slabs;   ///< Lista płatów.
+   char *top;     ///< Początek nieprzydzielonej części bieżącego płatu.
+   size_t left;   ///< Liczba nieprzydzielonych bajtów bieżącego płatu.
+   FreeBlock *freeLists[NUMBER_OF_CLASSES]; ///< Listy wolnych bloków.
+   LargeBlock *large; ///< Lista dużych bloków.
+};
+
+/** @brief Wyznacza klasę rozmiaru małego bloku.
+ * @param[in] size - rozmiar bloku w bajtach.
+ * @return Klasa rozmiaru - rozmiar zaokrąglony w górę podzielony przez
+ *         @ref ALIGNMENT.
+ */
+static size_t sizeClass(size_t const size) {
+   return (size + ALIGNMENT - 1) / ALIGNMENT;
+}
+
+SlabAllocator * slabNew(void) {
+   return calloc(1, sizeof(SlabAllocator));
+}
+
+void slabDelete(SlabAllocator *allocator) {
+   if (allocator == NULL)
+      return;
+
+   while (allocator->slabs != NULL) {
+      Slab *next = allocator->slabs->next;
+      free(allocator->slabs);
+      allocator->slabs = next;
+   }
+   while (allocator->large != NULL) {
+      LargeBlock *next = allocator->large->next;
+      free(allocator->large);
+      allocator->large = next;
+   }
+   free(allocator);
+}
+
+void * slabAlloc(SlabAllocator *allocator, size_t const size) {
+   if (size > MAX_SMALL_SIZE) {
+      LargeBlock *block = malloc(sizeof(LargeBlock) + size);
+      if (block == NULL)
+         return NULL;
+
+      block->previous = NULL;
+      block->next = allocator->large;
+      if (allocator->large != NULL)
+         allocator->large->previous = block;
+      allocator->large = block;
+      return block + 1;
+   }
+
+   size_t const class = sizeClass(size);
+   FreeBlock *block = (allocator->freeLists)[class];
+   if (block != NULL) {
+      (allocator->freeLists)[class] = block->next;
+      return block;
+   }
+
+   size_t const bytes = class * ALIGNMENT;
+   if (allocator->left < bytes) {
+      // Końcówka bieżącego płatu jest porzucana.
+      Slab *slab = malloc(SLAB_SIZE);
+      if (slab == NULL)
+         return NULL;
+
+      slab->next = allocator->slabs;
+      allocator->slabs = slab;
+      allocator->top = (char*)(slab + 1);
+      allocator->left = SLAB_SIZE - sizeof(Slab);
+   }
+
+   void *result = allocator->top;
+   allocator->top += bytes;
+   allocator->left -= bytes;
+   return result;
+}
+
+void slabFree(SlabAllocator *allocator, void *block, size_t const size) {
+   if (block == NULL)
+      return;
+
+   if (size > MAX_SMALL_SIZE) {
+      LargeBlock *large = (LargeBlock*)block - 1;
+      if (large->previous != NULL)
+         large->previous->next = large->next;
+      else
+         allocator->large = large->next;
+      if (large->next != NULL)
+         large->next->previous = large->previous;
+      free(large);
+      return;
+   }
+
+   FreeBlock *freeBlock = block;
+   size_t const class = sizeClass(size);
+   freeBlock->next = (allocator->freeLists)[class];
+   (allocator->freeLists)[class] = freeBlock;
+}
@@ -0,0 +1,59 @@
+/** @file
+ * Interfejs alokatora pamięci dla struktur przechowujących przekierowania.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#ifndef __SLAB_H__
+#define __SLAB_H__
+
+#include <stddef.h>
+
+/** @struct SlabAllocator
+ * To jest struktura alokatora.
+ * Alokator przydziela małe bloki kolejno z dużych płatów pamięci (ang. slab),
+ * dzięki czemu bloki przydzielane jeden po drugim leżą obok siebie. Zwolnione
+ * bloki trafiają na listy wolnych bloków odpowiedniej klasy rozmiaru.
+ * Większe bloki są przydzielane osobno funkcją malloc.
+ */
+struct SlabAllocator;
+/** @typedef SlabAllocator
+ * Definicja structury SlabAllocator.
+ */
+typedef struct SlabAllocator SlabAllocator;
+
+/** @brief Tworzy nowy alokator.
+ * @return Wskaźnik na utworzony alokator lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+SlabAllocator * slabNew(void);
+
+/** @brief Usuwa alokator.
+ * Zwalnia całą pamięć przydzieloną przez alokator, w tym bloki, które nie
+ * zostały zwolnione funkcją @ref slabFree. Czas działania jest proporcjonalny
+ * do liczby płatów i dużych bloków, a nie do liczby małych bloków.
+ * Nic nie robi, jeśli wskaźnik @p allocator ma wartość NULL.
+ * @param[in] allocator – wskaźnik na usuwany alokator.
+ */
+void slabDelete(SlabAllocator *allocator);
+
+/** @brief Przydziela blok pamięci.
+ * @param[in,out] allocator – wskaźnik na alokator;
+ * @param[in] size          – rozmiar bloku w bajtach (dodatni).
+ * @return Wskaźnik na przydzielony blok lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+void * slabAlloc(SlabAllocator *allocator, size_t size);
+
+/** @brief Zwalnia blok pamięci.
+ * Nic nie robi, jeśli wskaźnik @p block ma wartość NULL.
+ * @param[in,out] allocator – wskaźnik na alokator;
+ * @param[in] block         – wskaźnik na blok przydzielony przez
+ *                            @ref slabAlloc;
+ * @param[in] size          – rozmiar bloku podany przy jego przydzielaniu.
+ */
+void slabFree(SlabAllocator *allocator, void *block, size_t size);
+
+#endif /* __SLAB_H__ */
@@ -0,0 +1,210 @@
+/** @file
+ * Implementacja zapisu i odwzorowywania w pamięci plików z migawką.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "snapshot.h"
+#include "journal.h"
+
+/** Znacznik początku pliku z migawką. */
+#define SNAPSHOT_MAGIC "PHFWDSNP"
+
+/** Wersja formatu migawki. Zmienia się przy każdej zmianie układu pliku. */
+#define SNAPSHOT_VERSION 1
+
+/** Wartość, po której odczytaniu rozpoznajemy kolejność bajtów zapisującego. */
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+/** Przyrostek nazwy pliku tymczasowego, do którego zapisujemy migawkę. */
+#define SNAPSHOT_SUFFIX ".tmp"
+
+/** Podstawa skrótu FNV-1a. */
+#define FNV_OFFSET 14695981039346656037ULL
+
+/** Mnożnik skrótu FNV-1a. */
+#define FNV_PRIME 1099511628211ULL
+
+/** @struct SnapshotHeader
+ * To jest nagłówek pliku z migawką. Za nim leży blok postaci zamrożonej
+ * w niezmienionej postaci, więc plik można odwzorować w pamięci i czytać
+ * bez kopiowania. Rozmiar nagłówka jest wielokrotnością 8, dzięki czemu
+ * wierzchołki w odwzorowanym pliku są wyrównane.
+ */
+typedef struct SnapshotHeader {
+   char magic[8];            ///< Znacznik @ref SNAPSHOT_MAGIC.
+   uint32_t version;         ///< Wersja formatu @ref SNAPSHOT_VERSION.
+   uint32_t byteOrder;       ///< Wartość @ref SNAPSHOT_BYTE_ORDER.
+   uint64_t checksum;        ///< Skrót nagłówka (z tym polem równym 0) i bloku.
+   uint64_t size;            ///< Rozmiar bloku w bajtach.
+   uint32_t nodeCount;       ///< Liczba wierzchołków.
+   uint32_t reverse;         ///< Indeks korzenia indeksu odwrotnego.
+   uint32_t targetCount;     ///< Liczba numerów docelowych.
+   uint32_t charsCount;      ///< Liczba znaków numerów docelowych.
+   uint64_t maxSourceLength; ///< Długość najdłuższego numeru przekierowywanego.
+   uint64_t maxTargetLength; ///< Długość najdłuższego numeru docelowego.
+} SnapshotHeader;
+
+/** @brief Wyznacza rozmiar bloku postaci zamrożonej.
+ * @param[in] nodeCount   - liczba wierzchołków.
+ * @param[in] targetCount - liczba numerów docelowych.
+ * @param[in] charsCount  - liczba znaków numerów docelowych.
+ * @return Rozmiar bloku w bajtach.
+ */
+static uint64_t frozenSize(uint32_t const nodeCount, uint32_t const targetCount,
+                           uint32_t const charsCount) {
+   return (uint64_t)nodeCount * sizeof(FlatNode)
+          + (uint64_t)targetCount * sizeof(FlatTarget) + charsCount;
+}
+
+/** @brief Rozszerza skrót o kolejne dane.
+ * Wariant FNV-1a przetwarzający dane słowami 64-bitowymi, a tylko końcówkę
+ * bajtami - wystarcza do wykrycia uszkodzenia pliku, a nie spowalnia
+ * wczytywania dużych migawek.
+ * @param[in] hash - dotychczasowy skrót.
+ * @param[in] data - wskaźnik na dane.
+ * @param[in] size - rozmiar danych w bajtach.
+ * @return Skrót rozszerzony o dane.
+ */
+static uint64_t checksum(uint64_t hash, void const *data, size_t const size) {
+   unsigned char const *bytes = data;
+   size_t i = 0;
+   for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, bytes + i, sizeof(uint64_t));
+      hash ^= word;
+      hash *= FNV_PRIME;
+      hash ^= hash >> 32;
+   }
+   for (; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= FNV_PRIME;
+   }
+   return hash;
+}
+
+/** @brief Wyznacza skrót migawki.
+ * @param[in] header - wskaźnik na nagłówek.
+ * @param[in] block  - wskaźnik na blok postaci zamrożonej.
+ * @return Skrót nagłówka z polem @p checksum równym 0 i bloku.
+ */
+static uint64_t snapshotChecksum(SnapshotHeader const *header, void const *block) {
+   SnapshotHeader copy = *header;
+   copy.checksum = 0;
+   uint64_t const hash = checksum(FNV_OFFSET, &copy, sizeof(SnapshotHeader));
+   return checksum(hash, block, (size_t)(header->size));
+}
+
+bool snapshotWrite(Frozen const *frozen, char const *path) {
+   SnapshotHeader header;
+   memset(&header, 0, sizeof(SnapshotHeader));
+   memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+   header.version = SNAPSHOT_VERSION;
+   header.byteOrder = SNAPSHOT_BYTE_ORDER;
+   header.size = frozenSize(frozen->nodeCount, frozen->targetCount, frozen->charsCount);
+   header.nodeCount = frozen->nodeCount;
+   header.reverse = frozen->reverse;
+   header.targetCount = frozen->targetCount;
+   header.charsCount = frozen->charsCount;
+   header.maxSourceLength = frozen->maxSourceLength;
+   header.maxTargetLength = frozen->maxTargetLength;
+   header.checksum = snapshotChecksum(&header, frozen->nodes);
+
+   size_t const pathLength = strlen(path);
+   char *temporary = malloc(pathLength + sizeof(SNAPSHOT_SUFFIX));
+   if (temporary == NULL)
+      return false;
+   memcpy(temporary, path, pathLength);
+   memcpy(temporary + pathLength, SNAPSHOT_SUFFIX, sizeof(SNAPSHOT_SUFFIX));
+
+   // Zawartość pliku jest utrwalana przed zmianą nazwy, a katalog - po niej,
+   // żeby po awarii systemu pod nazwą path była cała stara albo nowa migawka.
+   FILE *file = fopen(temporary, "wb");
+   bool success = (file != NULL
+                   && fwrite(&header, sizeof(SnapshotHeader), 1, file) == 1
+                   && fwrite(frozen->nodes, (size_t)(header.size), 1, file) == 1
+                   && fflush(file) == 0 && fsync(fileno(file)) == 0);
+   success = (file != NULL && fclose(file) == 0 && success
+              && rename(temporary, path) == 0 && journalSyncDirectory(path));
+   if (!success && file != NULL)
+      remove(temporary);
+   free(temporary);
+   return success;
+}
+
+/** @brief Sprawdza poprawność odwzorowanej migawki.
+ * Zawartość bloku nie jest sprawdzana poza skrótem - zakładamy, że plik
+ * z poprawnym skrótem został zapisany przez @ref snapshotWrite.
+ * @param[in] header - wskaźnik na początek odwzorowanego pliku.
+ * @param[in] length - rozmiar pliku w bajtach.
+ * @return Wartość @p true, jeśli migawka jest poprawna.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool isValidSnapshot(SnapshotHeader const *header, size_t const length) {
+   if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+       || header->version != SNAPSHOT_VERSION
+       || header->byteOrder != SNAPSHOT_BYTE_ORDER)
+      return false;
+
+   if (header->nodeCount < 2 || header->reverse == 0
+       || header->reverse >= header->nodeCount
+       || header->size != frozenSize(header->nodeCount, header->targetCount,
+                                     header->charsCount)
+       || header->size != length - sizeof(SnapshotHeader))
+      return false;
+
+   return header->checksum == snapshotChecksum(header, header + 1);
+}
+
+Frozen * snapshotLoad(char const *path) {
+   int const descriptor = open(path, O_RDONLY);
+   if (descriptor < 0)
+      return NULL;
+   struct stat status;
+   size_t length = 0;
+   void *mapping = MAP_FAILED;
+   if (fstat(descriptor, &status) == 0
+       && (uint64_t)(status.st_size) >= sizeof(SnapshotHeader)
+       && (uint64_t)(status.st_size) <= SIZE_MAX) {
+      length = (size_t)(status.st_size);
+      mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+   }
+   close(descriptor);
+   if (mapping == MAP_FAILED)
+      return NULL;
+
+   SnapshotHeader const *header = mapping;
+   Frozen *frozen = (isValidSnapshot(header, length) ? calloc(1, sizeof(Frozen)) : NULL);
+   if (frozen == NULL) {
+      munmap(mapping, length);
+      return NULL;
+   }
+
+   char const *block = (char const *)(header + 1);
+   frozen->block = mapping;
+   frozen->mapped = length;
+   frozen->nodes = (FlatNode const *)block;
+   frozen->targets = (FlatTarget const *)(block + (size_t)(header->nodeCount)
+                                                  * sizeof(FlatNode));
+   frozen->chars = (char const *)(frozen->targets + header->targetCount);
+   frozen->nodeCount = header->nodeCount;
+   frozen->reverse = header->reverse;
+   frozen->targetCount = header->targetCount;
+   frozen->charsCount = header->charsCount;
+   frozen->maxSourceLength = (size_t)(header->maxSourceLength);
+   frozen->maxTargetLength = (size_t)(header->maxTargetLength);
+   frozen->users = 1;
+   return frozen;
+}
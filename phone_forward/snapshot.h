@@ -0,0 +1,39 @@
+/** @file
+ * Interfejs zapisu postaci zamrożonej drzew przekierowań do pliku z migawką
+ * i jej odwzorowywania w pamięci.
+ * Nie jest częścią interfejsu klasy przechowującej przekierowania.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <stdbool.h>
+#include "frozen.h"
+
+/** @brief Zapisuje postać zamrożoną do pliku.
+ * Migawka jest zapisywana do pliku tymczasowego, który następnie zastępuje
+ * plik @p path. Dzięki temu przerwany zapis nie psuje poprzedniej migawki,
+ * a struktury, które ją odwzorowały, czytają dalej jej starą zawartość.
+ * @param[in] frozen – wskaźnik na postać zamrożoną;
+ * @param[in] path   – ścieżka do pliku.
+ * @return Wartość @p true, jeśli migawka została zapisana.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci lub wystąpił
+ *         błąd zapisu.
+ */
+bool snapshotWrite(Frozen const *frozen, char const *path);
+
+/** @brief Odwzorowuje w pamięci migawkę zapisaną przez @ref snapshotWrite.
+ * Blok postaci zamrożonej nie jest kopiowany - wynik czyta go wprost
+ * z odwzorowanego pliku.
+ * @param[in] path – ścieżka do pliku.
+ * @return Wskaźnik na postać zamrożoną, z której korzysta jedna struktura,
+ *         lub NULL, gdy pliku nie udało się odwzorować, nie jest poprawną
+ *         migawką albo nie udało się alokować pamięci.
+ */
+Frozen * snapshotLoad(char const *path);
+
+#endif /* __SNAPSHOT_H__ */
@@ -0,0 +1,176 @@
+/** @file
+ * Test obciążeniowy struktury działającej w trybie współbieżnym.
+ * Jeden wątek na przemian dodaje i usuwa przekierowania, a pozostałe
+ * jednocześnie je odczytują i sprawdzają, że każdy wynik odpowiada stanowi
+ * sprzed albo po całej zmianie. Na koniec sprawdza, że wiele otwartych
+ * iteratorów nie wstrzymuje odczytów. Przeznaczony do uruchamiania
+ * z ThreadSanitizer.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "../phone_forward.h"
+
+/** Liczba wątków czytających. */
+#define READERS 4
+
+/** Liczba zmian wykonywanych przez wątek piszący. */
+#define CHANGES 4000
+
+/** Liczba przekierowywanych numerów. */
+#define NUMBERS 64
+
+/** Liczba jednocześnie otwartych iteratorów - więcej niż miejsc na odczyty. */
+#define ITERATORS 100
+
+/** Struktura, na której działają wszystkie wątki. */
+static PhoneForward *pf;
+
+/** Czy wątek piszący skończył pracę. */
+static atomic_bool done;
+
+/** Liczba błędów znalezionych przez wątki czytające. */
+static atomic_int errors;
+
+/** @brief Zapisuje numer przekierowywany o indeksie @p i.
+ * @param[out] num - bufor na numer;
+ * @param[in] i    - indeks numeru.
+ */
+static void source(char *num, int const i) {
+   sprintf(num, "1%02d", i);
+}
+
+/** @brief Wątek piszący.
+ * Przekierowanie numeru o indeksie @p i na przemian wskazuje numer 9i
+ * i zostaje usunięte, więc numer 1i przechodzi w siebie albo w 9i.
+ * @param[in] arg - nieużywany.
+ * @return NULL.
+ */
+static void * writer(void *arg) {
+   (void)arg;
+   char num[8], target[8];
+   for (int change = 0; change < CHANGES; change++) {
+      int const i = change % NUMBERS;
+      source(num, i);
+      if ((change / NUMBERS) % 2 == 0) {
+         sprintf(target, "9%02d", i);
+         if (!phfwdAdd(pf, num, target))
+            atomic_fetch_add(&errors, 1);
+      }
+      else {
+         phfwdRemove(pf, num);
+      }
+   }
+   atomic_store(&done, true);
+   return NULL;
+}
+
+/** @brief Wątek czytający.
+ * @param[in] arg - ziarno generatora liczb losowych.
+ * @return NULL.
+ */
+static void * reader(void *arg) {
+   unsigned seed = (unsigned)(size_t)arg;
+   char num[8], forwarded[8];
+   while (!atomic_load(&done)) {
+      int const i = (int)(rand_r(&seed) % NUMBERS);
+      source(num, i);
+      sprintf(forwarded, "9%02d", i);
+
+      PhoneNumbers *pnum = phfwdGet(pf, num);
+      char const *result = phnumGet(pnum, 0);
+      if (result == NULL || (strcmp(result, num) != 0 && strcmp(result, forwarded) != 0))
+         atomic_fetch_add(&errors, 1);
+      phnumDelete(pnum);
+
+      // Numer 9i jest przekierowany z 1i albo z żadnego numeru.
+      pnum = phfwdReverse(pf, forwarded);
+      result = phnumGet(pnum, 0);
+      char const *next = phnumGet(pnum, 1);
+      if (result == NULL || (strcmp(result, num) == 0 ? phnumGet(pnum, 2) != NULL
+                             || next == NULL || strcmp(next, forwarded) != 0
+                             : strcmp(result, forwarded) != 0 || next != NULL))
+         atomic_fetch_add(&errors, 1);
+      phnumDelete(pnum);
+   }
+   return NULL;
+}
+
+/** @brief Sprawdza iteratory otwarte jednocześnie.
+ * Otwiera @ref ITERATORS iteratorów po przeciwobrazach numerów 9i, przy
+ * których otwarciu numer 1i jest przekierowany na 9i, a potem zmienia
+ * przekierowania. Odczyt przy otwartych iteratorach nie może czekać, a
+ * iteratory muszą zwracać stan z chwili utworzenia.
+ * @return Liczba błędów.
+ */
+static int iterators(void) {
+   char num[8], forwarded[8];
+   int failures = 0;
+   for (int i = 0; i < NUMBERS; i++) {
+      source(num, i);
+      sprintf(forwarded, "9%02d", i);
+      if (!phfwdAdd(pf, num, forwarded))
+         failures++;
+   }
+
+   ReverseIterator *its[ITERATORS];
+   for (int k = 0; k < ITERATORS; k++) {
+      sprintf(forwarded, "9%02d", k % NUMBERS);
+      its[k] = phfwdReverseIter(pf, forwarded, 0);
+      if (its[k] == NULL)
+         failures++;
+   }
+
+   PhoneNumbers *pnum = phfwdGet(pf, "100");
+   if (phnumGet(pnum, 0) == NULL || strcmp(phnumGet(pnum, 0), "900") != 0)
+      failures++;
+   phnumDelete(pnum);
+   for (int i = 0; i < NUMBERS; i++) {
+      source(num, i);
+      phfwdRemove(pf, num);
+   }
+
+   for (int k = 0; k < ITERATORS; k++) {
+      source(num, k % NUMBERS);
+      sprintf(forwarded, "9%02d", k % NUMBERS);
+      char const *first = phfwdReverseNext(its[k]);
+      if (first == NULL || strcmp(first, num) != 0)
+         failures++;
+      char const *second = phfwdReverseNext(its[k]);
+      if (second == NULL || strcmp(second, forwarded) != 0 || phfwdReverseNext(its[k]) != NULL)
+         failures++;
+      phfwdReverseIterDelete(its[k]);
+   }
+   return failures;
+}
+
+/** @brief Uruchamia test.
+ * @return Zero, jeśli wszystkie odczyty były poprawne, a jeden w przeciwnym
+ *         razie.
+ */
+int main(void) {
+   pf = phfwdNewConcurrent();
+   if (pf == NULL)
+      return 1;
+
+   pthread_t threads[READERS + 1];
+   pthread_create(&threads[READERS], NULL, writer, NULL);
+   for (size_t i = 0; i < READERS; i++)
+      pthread_create(&threads[i], NULL, reader, (void *)(i + 1));
+   for (size_t i = 0; i <= READERS; i++)
+      pthread_join(threads[i], NULL);
+   atomic_fetch_add(&errors, iterators());
+   phfwdDelete(pf);
+
+   printf("Błędnych odczytów: %d.\n", atomic_load(&errors));
+   return (atomic_load(&errors) == 0 ? 0 : 1);
+}
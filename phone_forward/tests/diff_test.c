@@ -0,0 +1,388 @@
+/** @file
+ * Test różnicowy modułu phone_forward.
+ * Wykonuje losowe ciągi zmian i zapytań jednocześnie na strukturze
+ * phone_forward i na wzorcowej implementacji na zwykłym drzewie trie
+ * (reference.h) i sprawdza, że wyniki są identyczne.
+ * Każdy ciąg jest wykonywany w kilku trybach: zwykłym, współbieżnym,
+ * z zamrażaniem, z migawkami, z pamięcią podręczną i z kopiami.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../phone_forward.h"
+#include "reference.h"
+
+/** Znaki, z których są losowane numery. Ostatni nie jest cyfrą. */
+#define ALPHABET "0123*#x"
+
+/** Liczba znaków numerów z @ref ALPHABET, które mogą być losowane. */
+#define SYMBOLS 6
+
+/** Największa długość losowanego numeru. */
+#define MAX_LENGTH 8
+
+/** Największa liczba numerów w zapytaniu @ref phfwdGetBatch i par
+ * w wywołaniu @ref phfwdAddBulk. */
+#define MAX_BATCH 32
+
+/** Liczba ciągów wykonywanych dla każdego trybu. */
+#define ROUNDS 20
+
+/** Liczba operacji w ciągu. */
+#define OPERATIONS 2000
+
+/** Tryby, w których jest wykonywany każdy ciąg operacji. */
+typedef enum Mode {
+   MODE_PLAIN,      ///< Struktura utworzona przez @ref phfwdNew.
+   MODE_CONCURRENT, ///< Struktura utworzona przez @ref phfwdNewConcurrent.
+   MODE_FROZEN,     ///< Struktura co jakiś czas zamrażana.
+   MODE_SNAPSHOT,   ///< Struktura co jakiś czas zapisywana i wczytywana.
+   MODE_CACHED,     ///< Struktura z pamięcią podręczną wyników.
+   MODE_CLONED,     ///< Struktura co jakiś czas zastępowana swoją kopią.
+   MODES            ///< Liczba trybów.
+} Mode;
+
+/** Nazwy trybów. */
+static char const * const modeNames[MODES] = {
+   "zwykły", "współbieżny", "zamrażanie", "migawki", "pamięć podręczna", "kopie"
+};
+
+/** Rodzaje losowanych operacji. */
+typedef enum Operation {
+   OP_ADD,          ///< @ref phfwdAdd.
+   OP_REMOVE,       ///< @ref phfwdRemove.
+   OP_GET,          ///< @ref phfwdGet.
+   OP_REVERSE,      ///< @ref phfwdReverse.
+   OP_GET_REVERSE,  ///< @ref phfwdGetReverse.
+   OP_BATCH,        ///< @ref phfwdGetBatch.
+   OP_TRANSFORM,    ///< Przekształcenie struktury zgodnie z trybem.
+   OP_BULK,         ///< @ref phfwdAddBulk.
+   OP_ITERATOR,     ///< @ref phfwdReverseIter.
+   OPERATION_KINDS  ///< Liczba rodzajów operacji.
+} Operation;
+
+/** Względne częstości operacji. */
+static int const weights[OPERATION_KINDS] = {
+   [OP_ADD] = 5, [OP_REMOVE] = 1, [OP_GET] = 3, [OP_REVERSE] = 1,
+   [OP_GET_REVERSE] = 1, [OP_BATCH] = 1, [OP_TRANSFORM] = 1, [OP_BULK] = 1,
+   [OP_ITERATOR] = 1
+};
+
+/** Stan generatora liczb losowych. */
+static unsigned long long randomState;
+
+/** Liczba znaków, z których są losowane numery w bieżącym ciągu. */
+static int symbols;
+
+/** Największa długość numerów w bieżącym ciągu. */
+static int maxLength;
+
+/** Ścieżka do pliku z migawkami. */
+static char snapshotPath[] = "/tmp/phone_forward_diff_XXXXXX";
+
+/** @brief Losuje liczbę.
+ * @param[in] bound - górne ograniczenie (dodatnie).
+ * @return Liczba z przedziału [0, @p bound).
+ */
+static int randomNumber(int const bound) {
+   randomState = randomState * 6364136223846793005ULL + 1442695040888963407ULL;
+   return (int)((randomState >> 33) % (unsigned long long)bound);
+}
+
+/** @brief Losuje rodzaj operacji.
+ * @return Rodzaj operacji wylosowany zgodnie z @ref weights.
+ */
+static Operation randomOperation(void) {
+   int total = 0;
+   for (int i = 0; i < OPERATION_KINDS; i++)
+      total += weights[i];
+
+   int draw = randomNumber(total);
+   int operation = 0;
+   while (draw >= weights[operation])
+      draw -= weights[operation++];
+   return (Operation)operation;
+}
+
+/** @brief Losuje numer.
+ * Czasem losuje napis, który nie jest numerem.
+ * @param[out] num - bufor na co najmniej @ref MAX_LENGTH + 1 znaków.
+ */
+static void randomNumberString(char *num) {
+   int const length = randomNumber(maxLength + 1);
+   for (int i = 0; i < length; i++)
+      num[i] = ALPHABET[randomNumber(symbols)];
+   num[length] = '\0';
+   if (length > 0 && randomNumber(50) == 0)
+      num[randomNumber(length)] = ALPHABET[SYMBOLS];
+}
+
+/** @brief Porównuje ciągi numerów.
+ * @param[in] result   - wynik struktury phone_forward;
+ * @param[in] expected - wynik implementacji wzorcowej;
+ * @param[in] query    - nazwa zapytania;
+ * @param[in] num      - argument zapytania.
+ * @return Wartość @p true, jeśli ciągi są identyczne.
+ */
+static bool sameNumbers(PhoneNumbers const *result, ReferenceNumbers const *expected,
+                        char const *query, char const *num) {
+   if (result == NULL || expected == NULL) {
+      if (result == NULL && expected == NULL)
+         return true;
+      printf("%s(%s): wynik %s NULL\n", query, num, (result == NULL ? "jest" : "nie jest"));
+      return false;
+   }
+
+   for (size_t i = 0; ; i++) {
+      char const *x = phnumGet(result, i);
+      char const *y = refnumGet(expected, i);
+      if (x == NULL && y == NULL)
+         return true;
+      if (x == NULL || y == NULL || strcmp(x, y) != 0) {
+         printf("%s(%s)[%zu]: jest %s, powinno być %s\n", query, num, i,
+                (x == NULL ? "NULL" : x), (y == NULL ? "NULL" : y));
+         return false;
+      }
+   }
+}
+
+/** @brief Porównuje wynik @ref phfwdGetBatch z wynikami implementacji wzorcowej.
+ * @param[in] pf - wskaźnik na strukturę phone_forward;
+ * @param[in] rf - wskaźnik na strukturę wzorcową.
+ * @return Wartość @p true, jeśli wyniki są identyczne.
+ */
+static bool checkBatch(PhoneForward const *pf, Reference const *rf) {
+   char nums[MAX_BATCH][MAX_LENGTH + 1];
+   char const *pointers[MAX_BATCH] = {NULL};
+   int const count = randomNumber(MAX_BATCH + 1);
+   for (int i = 0; i < count; i++) {
+      if (i > 0 && randomNumber(3) == 0)
+         strcpy(nums[i], nums[randomNumber(i)]);
+      else
+         randomNumberString(nums[i]);
+      pointers[i] = nums[i];
+   }
+
+   PhoneNumbers *result = phfwdGetBatch(pf, pointers, (size_t)count);
+   bool same = (result != NULL);
+   for (int i = 0; same && i < count; i++) {
+      ReferenceNumbers *expected = refGet(rf, nums[i]);
+      char const *x = phnumGet(result, (size_t)i);
+      char const *y = refnumGet(expected, 0);
+      if ((x == NULL) != (y == NULL) || (x != NULL && strcmp(x, y) != 0)) {
+         printf("phfwdGetBatch(%s): jest %s, powinno być %s\n", nums[i],
+                (x == NULL ? "NULL" : x), (y == NULL ? "NULL" : y));
+         same = false;
+      }
+      refnumDelete(expected);
+   }
+   if (same && phnumGet(result, (size_t)count) != NULL) {
+      printf("phfwdGetBatch: za dużo wyników\n");
+      same = false;
+   }
+   phnumDelete(result);
+   return same;
+}
+
+/** @brief Porównuje numery zwracane przez iterator z wynikiem @ref refReverse.
+ * @param[in] pf  - wskaźnik na strukturę phone_forward;
+ * @param[in] rf  - wskaźnik na strukturę wzorcową;
+ * @param[in] num - numer.
+ * @return Wartość @p true, jeśli wyniki są identyczne.
+ */
+static bool checkIterator(PhoneForward const *pf, Reference const *rf, char const *num) {
+   size_t const limit = (size_t)randomNumber(4);
+   ReverseIterator *it = phfwdReverseIter(pf, num, limit);
+   ReferenceNumbers *expected = refReverse(rf, num);
+   bool same = (it != NULL && expected != NULL);
+   for (size_t i = 0; same; i++) {
+      char const *x = phfwdReverseNext(it);
+      char const *y = (limit == 0 || i < limit ? refnumGet(expected, i) : NULL);
+      if ((x == NULL) != (y == NULL) || (x != NULL && strcmp(x, y) != 0)) {
+         printf("phfwdReverseNext(%s)[%zu]: jest %s, powinno być %s\n", num, i,
+                (x == NULL ? "NULL" : x), (y == NULL ? "NULL" : y));
+         same = false;
+      }
+      if (x == NULL)
+         break;
+   }
+   phfwdReverseIterDelete(it);
+   refnumDelete(expected);
+   return same;
+}
+
+/** @brief Dodaje losowe przekierowania przez @ref phfwdAddBulk.
+ * W implementacji wzorcowej dodaje je po kolei.
+ * @param[in,out] pf - wskaźnik na strukturę phone_forward;
+ * @param[in,out] rf - wskaźnik na strukturę wzorcową.
+ * @return Wartość @p true, jeśli przekierowania zostały dodane.
+ */
+static bool addBulk(PhoneForward *pf, Reference *rf) {
+   char nums[MAX_BATCH][2][MAX_LENGTH + 1];
+   PhoneForwardPair pairs[MAX_BATCH];
+   int const count = 1 + randomNumber(MAX_BATCH);
+   for (int i = 0; i < count; i++) {
+      // Wszystkie pary muszą być poprawne, bo inaczej struktura się nie zmienia.
+      do {
+         randomNumberString(nums[i][0]);
+         randomNumberString(nums[i][1]);
+      } while (!refAdd(rf, nums[i][0], nums[i][1]));
+      pairs[i] = (PhoneForwardPair){nums[i][0], nums[i][1]};
+   }
+
+   if (!phfwdAddBulk(pf, pairs, (size_t)count)) {
+      printf("phfwdAddBulk: nie udało się dodać %d przekierowań\n", count);
+      return false;
+   }
+   return true;
+}
+
+/** @brief Zmienia strukturę zgodnie z trybem.
+ * Zamraża ją, zastępuje strukturą wczytaną z migawki lub zastępuje kopią.
+ * @param[in,out] pf - wskaźnik na wskaźnik na strukturę phone_forward;
+ * @param[in] mode   - tryb.
+ * @return Wartość @p true, jeśli się to udało.
+ */
+static bool transform(PhoneForward **pf, Mode const mode) {
+   PhoneForward *replacement = NULL;
+   switch (mode) {
+      case MODE_FROZEN:
+         return phfwdFreeze(*pf);
+      case MODE_SNAPSHOT:
+         if (phfwdSave(*pf, snapshotPath))
+            replacement = phfwdLoad(snapshotPath);
+         break;
+      case MODE_CLONED:
+         replacement = phfwdClone(*pf);
+         break;
+      default:
+         return true;
+   }
+
+   if (replacement == NULL)
+      return false;
+   phfwdDelete(*pf);
+   *pf = replacement;
+   return true;
+}
+
+/** @brief Tworzy strukturę w danym trybie.
+ * @param[in] mode - tryb.
+ * @return Wskaźnik na strukturę lub NULL, gdy nie udało się jej utworzyć.
+ */
+static PhoneForward * createInMode(Mode const mode) {
+   PhoneForward *pf = (mode == MODE_CONCURRENT ? phfwdNewConcurrent() : phfwdNew());
+   if (pf != NULL && mode == MODE_CACHED && !phfwdSetCache(pf, 16)) {
+      phfwdDelete(pf);
+      return NULL;
+   }
+   return pf;
+}
+
+/** @brief Wykonuje jeden losowy ciąg operacji.
+ * @param[in] mode - tryb.
+ * @return Wartość @p true, jeśli wszystkie wyniki były identyczne.
+ */
+static bool runRound(Mode const mode) {
+   symbols = 2 + randomNumber(SYMBOLS - 1);
+   maxLength = 2 + randomNumber(MAX_LENGTH - 1);
+   PhoneForward *pf = createInMode(mode);
+   Reference *rf = refNew();
+   bool same = (pf != NULL && rf != NULL);
+
+   for (int i = 0; same && i < OPERATIONS; i++) {
+      char num1[MAX_LENGTH + 1], num2[MAX_LENGTH + 1];
+      randomNumberString(num1);
+      randomNumberString(num2);
+      PhoneNumbers *result = NULL;
+      ReferenceNumbers *expected = NULL;
+
+      switch (randomOperation()) {
+         case OP_ADD:
+            if (phfwdAdd(pf, num1, num2) != refAdd(rf, num1, num2)) {
+               printf("phfwdAdd(%s, %s): inny wynik\n", num1, num2);
+               same = false;
+            }
+            break;
+         case OP_REMOVE:
+            phfwdRemove(pf, num1);
+            refRemove(rf, num1);
+            break;
+         case OP_GET:
+            result = phfwdGet(pf, num1);
+            expected = refGet(rf, num1);
+            same = sameNumbers(result, expected, "phfwdGet", num1);
+            break;
+         case OP_REVERSE:
+            result = phfwdReverse(pf, num1);
+            expected = refReverse(rf, num1);
+            same = sameNumbers(result, expected, "phfwdReverse", num1);
+            break;
+         case OP_GET_REVERSE:
+            result = phfwdGetReverse(pf, num1);
+            expected = refGetReverse(rf, num1);
+            same = sameNumbers(result, expected, "phfwdGetReverse", num1);
+            break;
+         case OP_BATCH:
+            same = checkBatch(pf, rf);
+            break;
+         case OP_TRANSFORM:
+            if (!transform(&pf, mode)) {
+               printf("nie udało się przekształcić struktury\n");
+               same = false;
+            }
+            break;
+         case OP_BULK:
+            same = addBulk(pf, rf);
+            break;
+         case OP_ITERATOR:
+            same = checkIterator(pf, rf, num1);
+            break;
+         default:
+            break;
+      }
+      phnumDelete(result);
+      refnumDelete(expected);
+   }
+
+   phfwdDelete(pf);
+   refDelete(rf);
+   return same;
+}
+
+/** @brief Uruchamia test.
+ * Opcjonalny argument jest ziarnem generatora liczb losowych.
+ * @param[in] argc - liczba argumentów;
+ * @param[in] argv - argumenty.
+ * @return Zero, jeśli wszystkie wyniki były identyczne, a jeden w przeciwnym
+ *         razie.
+ */
+int main(int argc, char *argv[]) {
+   unsigned long long const seed = (argc > 1 ? strtoull(argv[1], NULL, 10) : 1);
+   int const descriptor = mkstemp(snapshotPath);
+   if (descriptor < 0)
+      return 1;
+   close(descriptor);
+
+   bool success = true;
+   for (int mode = 0; mode < MODES; mode++) {
+      randomState = seed;
+      bool same = true;
+      for (int round = 0; same && round < ROUNDS; round++)
+         same = runRound((Mode)mode);
+      printf("Tryb %s: %s.\n", modeNames[mode], (same ? "OK" : "błąd"));
+      success = success && same;
+   }
+
+   unlink(snapshotPath);
+   return (success ? 0 : 1);
+}
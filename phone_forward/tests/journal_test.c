@@ -0,0 +1,242 @@
+/** @file
+ * Test odtwarzania struktury z dziennika z uszkodzoną końcówką.
+ * Zapisuje dziennik losowych zmian, a potem odtwarza strukturę z każdego
+ * jego początku, jaki mógł pozostawić przerwany zapis, i z dziennika
+ * z uszkodzonym bajtem. Sprawdza, że odtworzona struktura zawiera dokładnie
+ * zmiany zapisane w całości przed miejscem uszkodzenia, że uszkodzona
+ * końcówka jest usuwana i że kolejne zmiany dopisane do takiego dziennika
+ * dają się odtworzyć.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../phone_forward.h"
+
+/** Liczba zmian zapisywanych w dzienniku. */
+#define CHANGES 60
+
+/** Znaki, z których są losowane numery. */
+#define ALPHABET "012"
+
+/** Liczba znaków w @ref ALPHABET. */
+#define SYMBOLS 3
+
+/** Największa długość losowanego numeru. */
+#define MAX_LENGTH 3
+
+/** @struct Change
+ * To jest struktura opisująca zmianę zapisaną w dzienniku.
+ */
+typedef struct Change {
+   char num1[MAX_LENGTH + 1]; ///< Numer przekierowywany lub usuwany prefiks.
+   char num2[MAX_LENGTH + 1]; ///< Numer docelowy (pusty dla usunięcia).
+   long end;                  ///< Rozmiar dziennika po zapisaniu zmiany.
+} Change;
+
+/** Zmiany zapisane w dzienniku. */
+static Change changes[CHANGES];
+
+/** Rozmiar pustego dziennika. */
+static long headerSize;
+
+/** Ścieżka do katalogu z plikami testu. */
+static char directory[] = "/tmp/phone_forward_journal_XXXXXX";
+
+/** @brief Losuje numer.
+ * @param[out] num - bufor na co najmniej @ref MAX_LENGTH + 1 znaków.
+ */
+static void randomNumberString(char *num) {
+   int const length = 1 + rand() % MAX_LENGTH;
+   for (int i = 0; i < length; i++)
+      num[i] = ALPHABET[rand() % SYMBOLS];
+   num[length] = '\0';
+}
+
+/** @brief Wykonuje zmianę.
+ * @param[in,out] pf  - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] change  - wskaźnik na zmianę.
+ * @return Wartość @p true, jeśli zmiana się udała.
+ */
+static bool apply(PhoneForward *pf, Change const *change) {
+   if (change->num2[0] == '\0') {
+      phfwdRemove(pf, change->num1);
+      return true;
+   }
+   return phfwdAdd(pf, change->num1, change->num2);
+}
+
+/** @brief Odczytuje rozmiar pliku.
+ * @param[in] path - ścieżka do pliku.
+ * @return Rozmiar pliku w bajtach lub -1, jeśli nie udało się go odczytać.
+ */
+static long fileSize(char const *path) {
+   struct stat status;
+   return (stat(path, &status) == 0 ? (long)status.st_size : -1);
+}
+
+/** @brief Zapisuje początek zawartości dziennika do pliku.
+ * @param[in] path     - ścieżka do pliku;
+ * @param[in] contents - zawartość dziennika;
+ * @param[in] size     - liczba zapisywanych bajtów.
+ * @return Wartość @p true, jeśli plik został zapisany.
+ */
+static bool writeFile(char const *path, char const *contents, long const size) {
+   FILE *file = fopen(path, "wb");
+   if (file == NULL)
+      return false;
+   bool const success = (fwrite(contents, 1, (size_t)size, file) == (size_t)size);
+   return (fclose(file) == 0 && success);
+}
+
+/** @brief Sprawdza, czy struktury zawierają te same przekierowania.
+ * Porównuje wyniki @ref phfwdGet i @ref phfwdReverse dla wszystkich numerów
+ * z @ref ALPHABET o długości co najwyżej @ref MAX_LENGTH + 1.
+ * @param[in] pf       - wskaźnik na badaną strukturę;
+ * @param[in] expected - wskaźnik na strukturę wzorcową.
+ * @return Wartość @p true, jeśli wszystkie wyniki są identyczne.
+ */
+static bool sameForwards(PhoneForward const *pf, PhoneForward const *expected) {
+   char num[MAX_LENGTH + 2];
+   int count = 1;
+   for (int length = 1; length <= MAX_LENGTH + 1; length++) {
+      count *= SYMBOLS;
+      for (int code = 0; code < count; code++) {
+         for (int i = 0, rest = code; i < length; i++, rest /= SYMBOLS)
+            num[i] = ALPHABET[rest % SYMBOLS];
+         num[length] = '\0';
+
+         for (int query = 0; query < 2; query++) {
+            PhoneNumbers *x = (query == 0 ? phfwdGet(pf, num) : phfwdReverse(pf, num));
+            PhoneNumbers *y = (query == 0 ? phfwdGet(expected, num)
+                                          : phfwdReverse(expected, num));
+            bool same = (x != NULL && y != NULL);
+            for (size_t i = 0; same; i++) {
+               char const *a = phnumGet(x, i);
+               char const *b = phnumGet(y, i);
+               same = ((a == NULL) == (b == NULL) && (a == NULL || strcmp(a, b) == 0));
+               if (a == NULL)
+                  break;
+            }
+            phnumDelete(x);
+            phnumDelete(y);
+            if (!same)
+               return false;
+         }
+      }
+   }
+   return true;
+}
+
+/** @brief Tworzy strukturę zawierającą początkowe zmiany.
+ * @param[in] count - liczba zmian.
+ * @return Wskaźnik na strukturę lub NULL, gdy nie udało się jej utworzyć.
+ */
+static PhoneForward * expectedState(int const count) {
+   PhoneForward *pf = phfwdNew();
+   for (int i = 0; pf != NULL && i < count; i++)
+      apply(pf, &changes[i]);
+   return pf;
+}
+
+/** @brief Odtwarza strukturę z dziennika i sprawdza wynik.
+ * Po odtworzeniu dopisuje jeszcze jedną zmianę i sprawdza, że odtwarza się
+ * ona razem z wcześniejszymi.
+ * @param[in] path  - ścieżka do pliku z dziennikiem;
+ * @param[in] count - liczba zmian, które powinny zostać odtworzone.
+ * @return Wartość @p true, jeśli odtworzona struktura jest poprawna.
+ */
+static bool recover(char const *path, int const count) {
+   Change const extra = {"2", "1", 0};
+   PhoneForward *pf = phfwdNew();
+   PhoneForward *expected = expectedState(count);
+   bool success = (pf != NULL && expected != NULL && phfwdAttachLog(pf, path, 1)
+                   && sameForwards(pf, expected)
+                   && fileSize(path) == (count == 0 ? headerSize : changes[count - 1].end));
+   success = success && apply(pf, &extra) && apply(expected, &extra);
+   phfwdDelete(pf);
+
+   pf = phfwdNew();
+   success = success && pf != NULL && phfwdAttachLog(pf, path, 1)
+             && sameForwards(pf, expected);
+   phfwdDelete(pf);
+   phfwdDelete(expected);
+   return success;
+}
+
+/** @brief Uruchamia test.
+ * @return Zero, jeśli wszystkie odtworzone struktury były poprawne, a jeden
+ *         w przeciwnym razie.
+ */
+int main(void) {
+   if (mkdtemp(directory) == NULL)
+      return 1;
+   char log[sizeof(directory) + 8], torn[sizeof(directory) + 8];
+   sprintf(log, "%s/log", directory);
+   sprintf(torn, "%s/torn", directory);
+
+   // Każda zmiana jest utrwalana osobno, więc po niej znamy rozmiar dziennika.
+   srand(1);
+   PhoneForward *pf = phfwdNew();
+   bool success = (pf != NULL && phfwdAttachLog(pf, log, 1));
+   headerSize = fileSize(log);
+   for (int i = 0; success && i < CHANGES; i++) {
+      do {
+         randomNumberString(changes[i].num1);
+         if (rand() % 4 == 0)
+            changes[i].num2[0] = '\0';
+         else
+            randomNumberString(changes[i].num2);
+      } while (strcmp(changes[i].num1, changes[i].num2) == 0);
+      success = apply(pf, &changes[i]);
+      changes[i].end = fileSize(log);
+   }
+   phfwdDelete(pf);
+
+   long const size = fileSize(log);
+   char *contents = (size > 0 ? malloc((size_t)size) : NULL);
+   FILE *file = fopen(log, "rb");
+   success = success && contents != NULL && file != NULL
+             && fread(contents, 1, (size_t)size, file) == (size_t)size;
+   if (file != NULL)
+      fclose(file);
+
+   // Dziennik urwany w dowolnym miejscu za nagłówkiem.
+   int complete = 0;
+   for (long cut = headerSize; success && cut <= size; cut++) {
+      while (complete < CHANGES && changes[complete].end <= cut)
+         complete++;
+      success = writeFile(torn, contents, cut) && recover(torn, complete);
+      if (!success)
+         printf("Dziennik urwany po %ld bajtach: błędne odtworzenie.\n", cut);
+   }
+
+   // Dziennik z uszkodzonym bajtem w środku zmiany.
+   for (int i = 0; success && i < CHANGES; i++) {
+      long const start = (i == 0 ? headerSize : changes[i - 1].end);
+      if (changes[i].end == start)
+         continue;
+      long const position = start + rand() % (changes[i].end - start);
+      contents[position] ^= 0x40;
+      success = writeFile(torn, contents, size) && recover(torn, i);
+      contents[position] ^= 0x40;
+      if (!success)
+         printf("Dziennik uszkodzony w zmianie %d: błędne odtworzenie.\n", i);
+   }
+
+   free(contents);
+   unlink(torn);
+   unlink(log);
+   rmdir(directory);
+   printf("Odtwarzanie dziennika: %s.\n", (success ? "OK" : "błąd"));
+   return (success ? 0 : 1);
+}
@@ -0,0 +1,604 @@
+/** @file
+ * Wspólne definicje drzew przekierowań i struktury, która je przechowuje,
+ * z których korzystają moduły implementacji klasy przechowującej
+ * przekierowania numerów telefonicznych. Nie jest częścią interfejsu klasy.
+ *
+ * @author Wojciech Weremczuk <ww438808@students.mimuw.edu.pl>
+ * @copyright Wojciech Weremczuk
+ * @date 2022
+ */
+
+#ifndef __TRIE_H__
+#define __TRIE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "phone_forward.h"
+#include "slab.h"
+#include "intern.h"
+#include "journal.h"
+#include "cache.h"
+#include "share.h"
+#include "ebr.h"
+
+/** Liczba elementów, o którą pobieranie do pamięci podręcznej wyprzedza
+ * przetwarzanie kolejki wierzchołków.
+ */
+#define PREFETCH_DISTANCE 8
+
+/** Wskazówka dla procesora, żeby pobrał do pamięci podręcznej dany adres. */
+#ifdef __GNUC__
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address) ((void)(address))
+#endif
+
+/** Położenie numeru, którego nie ma.
+ * Wynik funkcji @ref phfwdGetBatch dla napisu niebędącego numerem.
+ */
+#define NO_NUMBER SIZE_MAX
+
+/** Liczba cyfr.
+ * Numer składa się z cyfr 0..9, *, #.
+ */
+#define NUMBER_OF_DIGITS 12
+
+/** Separator w kluczach indeksu odwrotnego.
+ * Oddziela numer docelowy od numeru przekierowywanego.
+ */
+#define SEPARATOR '|'
+
+/** Liczba symboli, którymi mogą być etykietowane krawędzie drzew.
+ * Oprócz cyfr numeru drzewo indeksu odwrotnego używa separatora.
+ */
+#define NUMBER_OF_SYMBOLS (NUMBER_OF_DIGITS + 1)
+
+/** @brief Sprawdza, czy podany znak jest cyfrą numeru.
+ * @param[in] digit – znak, dla którego sprawdzamy poprawność.
+ * @return Wartość @p true, jeśli podany znak jest cyfrą numeru.
+ *         Wartość @p false, w przeciwnym przypadku.
+ */
+static inline bool isDigit(char const digit) {
+   return (digit >= '0' && digit <= '9') || digit == '*' || digit == '#';
+}
+
+/** @brief Zwraca identyfikator znaku.
+ * Zwraca identyfikator znaku zgodnie z treścią zadania - cyfry 0..9 
+ * reprezentują same siebie, * reprezentuje cyfrę 10, # reprezentuje cyfrę 11.
+ * Separator @ref SEPARATOR ma identyfikator 12.
+ * @param[in] digit – znak, dla którego wyznaczamy identyfikator.
+ * @return Identyfikator znaku.
+ */
+static inline int digitID(char const digit) {
+   if (digit == '*')
+      return 10;
+   if (digit == '#')
+      return 11;
+   if (digit == SEPARATOR)
+      return NUMBER_OF_DIGITS;
+   return digit - '0';
+}
+
+/** @struct Node
+ * To jest struktura zawierająca wierzchołek drzewa
+ * (przekierowania przechowujemy na drzewie).
+ * Wierzchołek przechowuje tylko istniejących synów, uporządkowanych według
+ * identyfikatorów krawędzi. Bit @p i pola @p children mówi, czy istnieje syn
+ * o identyfikatorze @p i, a jego pozycja w tablicy @p subtrees jest równa
+ * liczbie ustawionych młodszych bitów.
+ */
+struct Node;
+/** @typedef Node
+ * Definicja structury Node.
+ */
+typedef struct Node {
+   Target *forward;        ///< Przekierowanie.
+   uint32_t generation;    ///< Numer ostatniej zmiany, która utworzyła, udostępniła
+                           ///< do zmiany lub zwolniła wierzchołek.
+   uint16_t children;      ///< Mapa bitowa istniejących synów.
+   char digit;             ///< Cyfra reprezentująca wierzchołek.
+   bool isSource;          ///< Czy wierzchołek indeksu odwrotnego kończy klucz.
+   struct Node *subtrees[]; ///< Wskaźniki na synów.
+} Node;
+
+/** @brief Wyznacza liczbę ustawionych bitów.
+ * @param[in] mask – maska bitowa.
+ * @return Liczba ustawionych bitów maski @p mask.
+ */
+static inline int popcount(unsigned int mask) {
+#ifdef __GNUC__
+   return __builtin_popcount(mask);
+#else
+   int result = 0;
+   while (mask != 0) {
+      mask &= mask - 1;
+      result++;
+   }
+   return result;
+#endif
+}
+
+/** @brief Wyznacza liczbę synów wierzchołka @p node.
+ * @param[in] node – wskaźnik na wierzchołek drzewa.
+ * @return Liczba synów wierzchołka @p node.
+ */
+static inline int nonEmptySubtrees(Node const *node) {
+   return popcount(node->children);
+}
+
+/** @brief Wyznacza pozycję syna w tablicy synów.
+ * @param[in] node – wskaźnik na wierzchołek drzewa.
+ * @param[in] id   – identyfikator krawędzi prowadzącej do syna.
+ * @return Pozycja syna o identyfikatorze @p id w tablicy @p subtrees.
+ */
+static inline int childPosition(Node const *node, int const id) {
+   return popcount(node->children & ((1u << id) - 1));
+}
+
+/** @brief Zwraca syna wierzchołka.
+ * @param[in] node – wskaźnik na wierzchołek drzewa.
+ * @param[in] id   – identyfikator krawędzi prowadzącej do syna.
+ * @return Wskaźnik na syna lub NULL, jeśli taki syn nie istnieje.
+ */
+static inline Node * getChild(Node const *node, int const id) {
+   if (!(node->children & (1u << id)))
+      return NULL;
+   return (node->subtrees)[childPosition(node, id)];
+}
+
+/** @brief Wyznacza identyfikator kolejnego syna.
+ * @param[in] node – wskaźnik na wierzchołek drzewa.
+ * @param[in] from – najmniejszy rozważany identyfikator.
+ * @return Najmniejszy identyfikator nie mniejszy niż @p from, pod którym
+ *         istnieje syn, lub @ref NUMBER_OF_SYMBOLS, jeśli takiego nie ma.
+ */
+static inline int nextChild(Node const *node, int const from) {
+   unsigned int const mask = (unsigned int)(node->children) >> from;
+   if (mask == 0)
+      return NUMBER_OF_SYMBOLS;
+   return from + popcount((mask & (~mask + 1)) - 1);
+}
+
+/** @brief Wyznacza rozmiar wierzchołka.
+ * @param[in] children – liczba synów.
+ * @return Liczba bajtów zajmowanych przez wierzchołek z @p children synami.
+ */
+static inline size_t nodeSize(int const children) {
+   return sizeof(Node) + (size_t)children * sizeof(Node*);
+}
+
+/** @brief Powiększa tablicę.
+ * Zapewnia, że tablica @p array pomieści co najmniej @p needed elementów,
+ * podwajając jej rozmiar.
+ * @param[in,out] array   – wskaźnik na tablicę;
+ * @param[in,out] size    – wskaźnik na rozmiar tablicy;
+ * @param[in] needed      – wymagana liczba elementów;
+ * @param[in] elementSize – rozmiar elementu w bajtach.
+ * @return Wartość @p true, jeśli tablica mieści @p needed elementów.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+bool reserveArray(void **array, size_t *size, size_t needed, size_t elementSize);
+
+/** @struct Frozen
+ * Postać zamrożona drzew, opisana w pliku frozen.h.
+ */
+struct Frozen;
+/** @typedef Frozen
+ * Definicja struktury Frozen.
+ */
+typedef struct Frozen Frozen;
+
+/** @union NumberRef
+ * To jest unia opisująca położenie numeru w strukturze @p PhoneNumbers.
+ * Podczas budowania struktury przechowuje przesunięcie numeru względem
+ * początku tablicy znaków, a podczas sortowania - wskaźnik na numer.
+ */
+typedef union NumberRef {
+   size_t offset;       ///< Przesunięcie numeru w tablicy znaków.
+   char const *pointer; ///< Wskaźnik na numer.
+} NumberRef;
+
+struct PhoneNumbers {
+   char *chars;         ///< Znaki wszystkich numerów, każdy zakończony '\0'.
+   size_t charsCount;   ///< Liczba zajętych znaków.
+   size_t charsSize;    ///< Rozmiar tablicy znaków.
+   NumberRef *numbers;  ///< Położenia numerów.
+   size_t count;        ///< Liczba numerów.
+   size_t size;         ///< Rozmiar tablicy położeń.
+};
+
+/** @struct Version
+ * To jest struktura opisująca stan przekierowań widoczny dla funkcji
+ * odczytujących. W trybie współbieżnym każda zmiana tworzy nową wersję,
+ * kopiując zmieniane wierzchołki, a wcześniejsze wersje pozostają
+ * nienaruszone, dopóki mogą je czytać inne wątki.
+ */
+typedef struct Version {
+   Node *node;    ///< Wskaźnik na pierwszy wierzchołek drzewa trie.
+   Node *reverse; ///< Wskaźnik na korzeń indeksu odwrotnego.
+   size_t maxSourceLength; ///< Długość najdłuższego numeru przekierowywanego.
+   bool staleReverse;      ///< Czy indeks odwrotny może zawierać nieaktualne pary.
+   bool erasing;           ///< Czy indeks odwrotny zawiera pary odłożonych poddrzew.
+} Version;
+
+/** Rodzaje obiektów czekających na zwolnienie. */
+typedef enum RetiredKind {
+   RETIRED_NODE,    ///< Pojedynczy wierzchołek (bez przekierowania).
+   RETIRED_SUBTREE, ///< Wierzchołek wraz z całym poddrzewem.
+   RETIRED_TARGET,  ///< Referencja na przekierowanie.
+   RETIRED_VERSION  ///< Wersja.
+} RetiredKind;
+
+/** @struct Pending
+ * To jest struktura opisująca usunięte poddrzewo drzewa przekierowań
+ * odłożone do zwolnienia.
+ */
+typedef struct Pending {
+   Node *node;    ///< Korzeń poddrzewa (NULL - brak poddrzewa).
+   char *number;  ///< Numer odpowiadający korzeniowi lub NULL, jeśli pary
+                  ///< poddrzewa są już usunięte z indeksu odwrotnego.
+   size_t length; ///< Długość numeru.
+} Pending;
+
+/** @struct Reclaimer
+ * To jest struktura opisująca zwalnianie odłożonych poddrzew. Poddrzewo
+ * jest przeglądane w głąb po kilka wierzchołków na raz, dlatego stan
+ * przeglądania jest pamiętany między kolejnymi zmianami.
+ */
+typedef struct Reclaimer {
+   Pending *pending; ///< Poddrzewa czekające na przeglądanie.
+   size_t count;     ///< Liczba czekających poddrzew.
+   size_t size;      ///< Rozmiar tablicy @p pending.
+   size_t erasing;   ///< Liczba poddrzew, których pary są w indeksie odwrotnym.
+   Pending current;  ///< Przeglądane poddrzewo.
+   Node **stack;     ///< Wierzchołki na ścieżce od korzenia przeglądanego poddrzewa.
+   char *path;       ///< Numer odpowiadający bieżącemu wierzchołkowi.
+   size_t capacity;  ///< Rozmiar stosu i bufora numeru.
+   size_t top;       ///< Indeks bieżącego wierzchołka na stosie.
+   int next;         ///< Identyfikator pierwszego nieprzejrzanego syna (0 - wierzchołek
+                     ///< nie był jeszcze przeglądany).
+   bool release;     ///< Czy wierzchołki przeglądanego poddrzewa są od razu zwalniane.
+} Reclaimer;
+
+/** @struct Family
+ * To jest struktura opisująca rodzinę struktur utworzonych przez
+ * @ref phfwdClone. Struktury rodziny mają wspólne alokatory i tablicę numerów
+ * docelowych, a ich drzewa mogą współdzielić wierzchołki. Wierzchołek,
+ * na który wskazuje więcej niż jeden ojciec (lub wersja), jest zmieniany
+ * dopiero po skopiowaniu.
+ */
+typedef struct Family {
+   ShareTable *shared;  ///< Liczniki referencji współdzielonych wierzchołków.
+   uint32_t generation; ///< Numer ostatniej zmiany w całej rodzinie.
+} Family;
+
+/** @struct Latency
+ * To jest struktura z czasami wykonania jednej operacji. Liczniki są
+ * atomowe, bo w trybie współbieżnym operacje odczytu wykonuje wiele wątków.
+ */
+typedef struct Latency {
+   _Atomic uint64_t count;       ///< Liczba wykonań.
+   _Atomic uint64_t nanoseconds; ///< Łączny czas wykonań w nanosekundach.
+   _Atomic uint64_t buckets[PHFWD_LATENCY_BUCKETS]; ///< Histogram czasów.
+} Latency;
+
+struct PhoneForward {
+   _Atomic(Version*) version; ///< Bieżąca wersja.
+   Version *writing;          ///< Wersja modyfikowana przez trwającą zmianę.
+   size_t maxSourceLength; ///< Długość najdłuższego numeru przekierowywanego.
+   size_t maxTargetLength; ///< Długość najdłuższego numeru docelowego.
+   char *buffer;  ///< Bufor pomocniczy długości @p maxSourceLength.
+   char *key;     ///< Bufor na klucze indeksu odwrotnego.
+   Node **stack;  ///< Stos pomocniczy mieszczący najdłuższą ścieżkę w drzewach.
+   SlabAllocator *allocator; ///< Alokator wierzchołków i wersji.
+   SlabAllocator *targetAllocator; ///< Alokator numerów docelowych.
+   InternTable *targets;     ///< Tablica numerów docelowych przekierowań.
+   bool concurrent;          ///< Czy struktura działa w trybie współbieżnym.
+   uint32_t generation;      ///< Numer trwającej zmiany.
+   EpochDomain *epochs;      ///< Epoki wątków czytających i obiekty czekające na
+                             ///< zwolnienie (NULL - tryb zwykły).
+   Reclaimer reclaimer;      ///< Zwalnianie odłożonych poddrzew.
+   pthread_mutex_t writer;   ///< Zamek szeregujący zmiany.
+   Frozen *frozen;           ///< Postać zamrożona (NULL - drzewa są zwykłe).
+   Journal *journal;         ///< Dziennik zmian (NULL - zmiany nie są zapisywane).
+   LookupCache *cache;       ///< Pamięć podręczna wyników (NULL - wyłączona); zmienia
+                             ///< ją także @ref phfwdGet, zajmując ją na czas odczytu.
+   size_t nodeCount;         ///< Liczba przydzielonych wierzchołków.
+   size_t nodeBytes;         ///< Łączny rozmiar przydzielonych wierzchołków.
+   size_t forwardCount;      ///< Liczba przekierowań.
+   size_t depths[PHFWD_DEPTHS]; ///< Histogram długości numerów przekierowywanych.
+   Latency *latencies;       ///< Czasy wykonania operacji (NULL - nie są mierzone).
+   Family *family;           ///< Rodzina struktury (NULL - struktura nie ma kopii).
+   PhoneForward *sibling;    ///< Kolejna struktura rodziny (lista cykliczna).
+};
+
+/** @brief Sprawdza, czy zmiany kopiują wierzchołki.
+ * @param[in] pf – wskaźnik na strukturę przechowującą przekierowania.
+ * @return Wartość @p true, jeśli wierzchołki, które widzą inne wątki lub
+ *         klony, są przed zmianą kopiowane. Wartość @p false, jeśli wszystkie
+ *         wierzchołki są zmieniane w miejscu.
+ */
+static inline bool copiesPaths(PhoneForward const *pf) {
+   return pf->concurrent || pf->family != NULL;
+}
+
+/** @brief Wyznacza długość numeru.
+ * @param[in] number – wskaźnik na napis reprezentujący numer.
+ * @return Długość napisu reprezentującego numer telefonu
+ *         (jeżeli wskaźnik na napis ma wartość NULL lub podany 
+ *         napis nie jest poprawnym numerem, to zwraca 0).
+ */
+size_t numberLength(char const *number);
+
+/** @brief Tworzy nową strukturę.
+ * Tworzy nową strukturę niezawierającą żadnych numerów.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+PhoneNumbers * phnumCreate(void);
+
+/** @brief Zapisuje numer w tablicy znaków.
+ * Zapisuje w tablicy znaków struktury numer powstały ze sklejenia napisów
+ * @p prefix i @p suffix, nie dodając go do ciągu numerów.
+ * @param[in,out] pnum     – wskaźnik na strukturę przechowującą numery.
+ * @param[in] prefix       – wskaźnik na początek numeru lub NULL, jeśli
+ *                           początek zostanie zapisany później.
+ * @param[in] prefixLength – długość początku numeru.
+ * @param[in] suffix       – wskaźnik na koniec numeru.
+ * @param[in] suffixLength – długość końca numeru.
+ * @param[out] ref         – wskaźnik na położenie zapisanego numeru.
+ * @return Wartość @p true, jeśli numer został zapisany.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+bool phnumWrite(PhoneNumbers *pnum, char const *prefix, size_t prefixLength,
+                char const *suffix, size_t suffixLength, NumberRef *ref);
+
+/** @brief Zapisuje w tablicy znaków numer zaczynający się od numeru docelowego.
+ * Numer docelowy jest rozpakowywany bezpośrednio w tablicy znaków struktury.
+ * @param[in,out] pnum     – wskaźnik na strukturę przechowującą numery.
+ * @param[in] forward      – wskaźnik na numer docelowy lub NULL.
+ * @param[in] suffix       – wskaźnik na koniec numeru.
+ * @param[in] suffixLength – długość końca numeru.
+ * @param[out] ref         – wskaźnik na położenie zapisanego numeru.
+ * @return Wartość @p true, jeśli numer został zapisany.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+bool phnumWriteForward(PhoneNumbers *pnum, Target const *forward, char const *suffix,
+                       size_t suffixLength, NumberRef *ref);
+
+/** @brief Rozpoczyna odczyt przekierowań.
+ * W trybie współbieżnym ogłasza bieżącą epokę w wolnym miejscu, dzięki
+ * czemu obiekty odczytanej wersji nie zostaną zwolnione przed wywołaniem
+ * @ref endRead. Nie blokuje się na zmianach przekierowań.
+ * @param[in] pf    – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[out] slot – wskaźnik na indeks zajętego miejsca.
+ * @return Wskaźnik na bieżącą wersję.
+ */
+Version const * beginRead(PhoneForward const *pf, size_t *slot);
+
+/** @brief Kończy odczyt przekierowań.
+ * @param[in] pf   – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] slot – indeks miejsca zajętego przez @ref beginRead.
+ */
+void endRead(PhoneForward const *pf, size_t slot);
+
+/** @brief Porównuje dwa numery.
+ * @param[in] number1 – wskaźnik na pierwszy numer.
+ * @param[in] number2 – wskaźnik na drugi numer.
+ * @return Wartość @p -1, jeśli pierwszy numer jest mniejszy leksykograficznie.
+ *         Wartość @p 0, jeśli podane numery są równe.
+ *         Wartość @p 1, jeśli drugi numer jest mniejszy leksykograficznie.
+ */
+int numberComparator(char const *number1, char const *number2);
+
+/** @brief Rezerwuje miejsce na obiekty do zwolnienia.
+ * W trybie współbieżnym każde wywołanie @ref retire musi poprzedzać
+ * rezerwacja, zrobiona, zanim zmiana odłączy obiekt od bieżącej wersji -
+ * w razie niepowodzenia zmiana może się jeszcze wycofać. Poza tym trybem
+ * nic nie robi.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] count  – liczba rezerwowanych miejsc.
+ * @return Wartość @p true, jeśli miejsce zostało zarezerwowane.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+bool reserveRetired(PhoneForward *pf, size_t count);
+
+/** @brief Uwzględnia w statystykach dodane lub usunięte przekierowanie.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] length – długość numeru przekierowywanego.
+ * @param[in] added  – czy przekierowanie zostało dodane.
+ */
+void countForward(PhoneForward *pf, size_t length, bool added);
+
+/** @brief Przydziela blok wierzchołka.
+ * @param[in,out] pf   – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] children – liczba synów.
+ * @return Wskaźnik na blok mieszczący wierzchołek z @p children synami lub
+ *         NULL, gdy nie powiodła się alokacja pamięci.
+ */
+Node * allocNode(PhoneForward *pf, int children);
+
+/** @brief Zwraca blok wierzchołka do alokatora.
+ * Zapisuje w bloku numer trwającej zmiany. Wpis pamięci podręcznej zależny
+ * od zwolnionego wierzchołka przestaje więc być ważny także wtedy, gdy blok
+ * nie zostanie ponownie przydzielony - a przydzielony ponownie dostaje numer
+ * zmiany, która go przydzieliła. Bloki wierzchołków nie są przydzielane
+ * numerom docelowym, które mają osobny alokator.
+ * @param[in,out] pf   – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] node     – wskaźnik na zwalniany wierzchołek.
+ * @param[in] children – liczba synów, dla której przydzielono wierzchołek.
+ */
+void freeNode(PhoneForward *pf, Node *node, int children);
+
+/** @brief Zwalnia referencję na przekierowanie.
+ * W trybie współbieżnym referencja jest odkładana do zwolnienia, bo numer
+ * docelowy mogą jeszcze czytać inne wątki. Nic nie robi, jeśli wskaźnik
+ * @p target ma wartość NULL.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] target – wskaźnik na przekierowanie.
+ */
+void releaseTarget(PhoneForward *pf, Target *target);
+
+/** @brief Udostępnia wierzchołek do zmiany.
+ * Jeśli wierzchołek mogą czytać inne wątki, zastępuje go kopią, a oryginał
+ * odkłada do zwolnienia. Wierzchołek współdzielony z klonami też jest
+ * zastępowany kopią, a oryginał traci jedną referencję i dostaje numer
+ * trwającej zmiany, co unieważnia zależne od niego wpisy pamięci
+ * podręcznej wszystkich klonów. Ojciec wierzchołka musi być już udostępniony.
+ * Udostępniony wierzchołek ma numer trwającej zmiany - zmiana przechodzi
+ * przez wszystkie wierzchołki od korzenia do zmienianego, co unieważnia
+ * zależne od nich wpisy pamięci podręcznej.
+ * @param[in,out] pf   – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in,out] slot – wskaźnik na miejsce przechowywania wierzchołka.
+ * @return Wskaźnik na wierzchołek, który można zmieniać, lub NULL, gdy nie
+ *         powiodła się alokacja pamięci.
+ */
+Node * writableNode(PhoneForward *pf, Node **slot);
+
+/** @brief Dołącza syna do wierzchołka.
+ * Wierzchołek jest przy tym przenoszony do większego bloku, dlatego jest
+ * przekazywany przez wskaźnik na miejsce, w którym jest przechowywany.
+ * @param[in,out] pf   – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in,out] slot – wskaźnik na miejsce przechowywania wierzchołka.
+ * @param[in] child    – wskaźnik na dołączanego syna.
+ * @return Wskaźnik na miejsce przechowywania syna lub NULL, gdy nie
+ *         powiodła się alokacja pamięci (wierzchołek nie jest wtedy zmieniany).
+ */
+Node ** insertChild(PhoneForward *pf, Node **slot, Node *child);
+
+/** @brief Usuwa strukturę.
+ * Usuwa strukturę wskazywaną przez @p node wraz z całym jej poddrzewem.
+ * Żaden inny wątek nie może jej już czytać. Wierzchołki współdzielone
+ * z klonami tracą tylko referencję i nie są przeglądane.
+ * Nic nie robi, jeśli wskaźnik ten ma wartość NULL.
+ * @param[in,out] pf    – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] node      – wskaźnik na usuwaną strukturę.
+ * @param[in,out] stack – tablica pomocnicza, która pomieści wierzchołki
+ *                        najdłuższej ścieżki w poddrzewie; może mieć wartość
+ *                        NULL, jeśli usuwany wierzchołek nie ma synów.
+ */
+void deleteNode(PhoneForward *pf, Node *node, Node **stack);
+
+/** @brief Wyznacza wierzchołek odpowiadający napisowi.
+ * Przechodzi od wierzchołka @p node ścieżką opisaną przez @p number.
+ * @param[in] node   – wskaźnik na wierzchołek początkowy.
+ * @param[in] number – wskaźnik na napis opisujący ścieżkę.
+ * @param[in] length – długość napisu.
+ * @return Wskaźnik na ostatni wierzchołek ścieżki lub NULL, gdy ścieżka
+ *         nie istnieje.
+ */
+Node * findPath(Node const *node, char const *number, size_t length);
+
+/** @brief Usuwa parę z indeksu odwrotnego.
+ * @param[in,out] pf       – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] target       – wskaźnik na numer docelowy.
+ * @param[in] targetLength – długość numeru docelowego.
+ * @param[in] source       – wskaźnik na numer przekierowywany.
+ * @param[in] sourceLength – długość numeru przekierowywanego.
+ */
+void reverseErase(PhoneForward *pf, char const *target, size_t targetLength,
+                  char const *source, size_t sourceLength);
+
+/** @brief Usuwa z indeksu odwrotnego parę odpowiadającą przekierowaniu.
+ * @param[in,out] pf       – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] forward      – wskaźnik na numer docelowy przekierowania.
+ * @param[in] source       – wskaźnik na numer przekierowywany.
+ * @param[in] sourceLength – długość numeru przekierowywanego.
+ */
+void reverseEraseForward(PhoneForward *pf, Target const *forward,
+                         char const *source, size_t sourceLength);
+
+/** @brief Rozpoczyna zmianę przekierowań.
+ * W trybie współbieżnym zajmuje zamek zmian i tworzy nową wersję, która
+ * będzie modyfikowana przez zmianę.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania.
+ * @return Wartość @p true, jeśli zmianę rozpoczęto.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+bool beginChange(PhoneForward *pf);
+
+/** @brief Kończy zmianę przekierowań.
+ * W trybie współbieżnym publikuje nową wersję, zwalnia obiekty, których nie
+ * może już czytać żaden wątek, i zwalnia zamek zmian.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania.
+ */
+void endChange(PhoneForward *pf);
+
+/** @brief Powiększa bufory pomocnicze.
+ * Zapewnia, że bufory i stos pomocniczy pomieszczą numery o podanych długościach.
+ * @param[in,out] pf       – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] sourceLength – długość numeru przekierowywanego.
+ * @param[in] targetLength – długość numeru docelowego.
+ * @return Wartość @p true, jeśli działanie funkcji przebiegło pomyślnie.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+bool reserveBuffers(PhoneForward *pf, size_t sourceLength,
+                    size_t targetLength);
+
+/** @brief Dodaje przekierowanie w trwającej zmianie.
+ * @param[in,out] pf   – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] num1     – wskaźnik na numer przekierowywany.
+ * @param[in] length1  – długość numeru przekierowywanego.
+ * @param[in] num2     – wskaźnik na numer docelowy.
+ * @param[in] length2  – długość numeru docelowego.
+ * @return Wartość @p true, jeśli przekierowanie zostało dodane.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+bool addForward(PhoneForward *pf, char const *num1, size_t length1,
+                char const *num2, size_t length2);
+
+/** @brief Zmienia długość numeru.
+ * Alokuje odpowiednią ilość pamięci, tak żeby @p number przechowywał 
+ * wskaźnik na numer długości @p length. 
+ * @param[in,out] number – wskaźnik na numer.
+ * @param[in] length     – docelowa długość numeru.
+ * @return Wartość @p true, jeśli alokacja pamięci się powiodła.
+ *         Wartość @p false, w przeciwnym przypadku.
+ */
+bool reallocNumber(char **number, size_t length);
+
+/** @brief Sprawdza, czy numer jest przekierowywany na podany numer.
+ * @param[in] root      – wskaźnik na korzeń drzewa przekierowań.
+ * @param[in] number    – wskaźnik na sprawdzany numer.
+ * @param[in] length    – długość sprawdzanego numeru.
+ * @param[in] num       – wskaźnik na numer docelowy.
+ * @param[in] packed    – wskaźnik na upakowany numer docelowy.
+ * @param[in] numLength – długość numeru docelowego.
+ * @param[in] preimage  – czy brać pod uwagę tylko przekierowanie, którego
+ *                        użyje funkcja @ref phfwdGet.
+ * @return Wartość @p true, jeśli numer @p number należy do wyniku funkcji
+ *         @ref phfwdReverse (lub @ref phfwdGetReverse, jeśli @p preimage
+ *         ma wartość @p true) dla numeru @p num.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool isForwardedTo(Node const *root, char const *number, size_t length,
+                   char const *num, uint8_t const *packed, size_t numLength,
+                   bool preimage);
+
+/** @brief Odkłada obiekt do zwolnienia.
+ * W trybie współbieżnym obiekt zostanie zwolniony, gdy żaden wątek nie będzie
+ * mógł go już czytać, i zajmuje miejsce zarezerwowane przez
+ * @ref reserveRetired. Poza tym trybem obiekt zostanie zwolniony dopiero
+ * razem z alokatorem struktury.
+ * @param[in,out] pf  – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] object  – wskaźnik na obiekt.
+ * @param[in] kind    – rodzaj obiektu.
+ */
+void retire(PhoneForward *pf, void *object, RetiredKind kind);
+
+/** @brief Zwalnia referencję na wierzchołek współdzielony z klonami.
+ * Musi być wywołana w trakcie zmiany, a wierzchołek nie może być już
+ * osiągalny z drzew struktury inaczej niż przez usuwaną referencję.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania.
+ * @param[in] node   – wskaźnik na wierzchołek.
+ * @return Wartość @p true, jeśli wierzchołek ma jeszcze innego ojca - jego
+ *         referencja została zwolniona, a on sam i jego poddrzewo nie mogą
+ *         zostać zwolnione. Wartość @p false, jeśli wierzchołek należy tylko
+ *         do struktury @p pf.
+ */
+bool releaseShared(PhoneForward *pf, Node const *node);
+
+#endif /* __TRIE_H__ */